@@ -112,9 +112,15 @@ BOOL WINAPI HashCalcPrepare( PHASHCALCCONTEXT phcctx )
 
 		if (cchCurrent && phcctx->hList)
 		{
+			WIN32_FILE_ATTRIBUTE_DATA fad;
+
 			// Finally, we can do the actual work that's needed!
 
-			if (GetFileAttributes(pszCurrent) & FILE_ATTRIBUTE_DIRECTORY)
+			// (an inaccessible path is handed to the directory walk, as before)
+			if (!GetFileAttributesEx(pszCurrent, GetFileExInfoStandard, &fad))
+				fad.dwFileAttributes = INVALID_FILE_ATTRIBUTES;
+
+			if (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 			{
 				if (cchCurrent < MAX_PATH_BUFFER - 2)
 				{
@@ -130,6 +136,8 @@ BOOL WINAPI HashCalcPrepare( PHASHCALCCONTEXT phcctx )
 				{
                     pItem->results.dwFlags = 0;
 					pItem->cchPath = cchCurrent;
+					pItem->cbSize = (ULONGLONG)fad.nFileSizeHigh << 32 | fad.nFileSizeLow;
+					pItem->bHashed = FALSE;
 					memcpy(pItem->szPath, pszCurrent, cbCurrent);
 
 					if (phcctx->cchMax < cchCurrent)
@@ -195,6 +203,8 @@ VOID WINAPI HashCalcWalkDirectory( PHASHCALCCONTEXT phcctx, PTSTR pszPath, UINT
 				{
                     pItem->results.dwFlags = 0;
 					pItem->cchPath = cchNew;
+					pItem->cbSize = (ULONGLONG)finddata.nFileSizeHigh << 32 | finddata.nFileSizeLow;
+					pItem->bHashed = FALSE;
 					memcpy(pItem->szPath, pszPath, cbPathBuffer);
 
 					if (phcctx->cchMax < cchNew)
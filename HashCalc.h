@@ -31,7 +31,7 @@ extern "C" {
  **/
 
 // Constants
-#define RESULTS_LEN 0x200
+#define RESULTS_LEN 0x500
 #define SCRATCH_BUFFER_SIZE (MAX_PATH_BUFFER + RESULTS_LEN)
 
 // Scratch buffer
@@ -91,6 +91,8 @@ typedef struct {
 // Per-file data
 typedef struct {
 	UINT cchPath;                    // length of path in characters, not including NULL
+	ULONGLONG cbSize;                // file size as of the directory walk (for scheduling only)
+	BOOL bHashed;                    // results are ready to be written (for writing them in order)
 	WHRESULTEX results;              // hash results
 #ifdef _TIMED
 	DWORD dwElapsed;                 // time in ms taken to compute all hashes of one file
@@ -32,6 +32,9 @@ HANDLE g_hActCtx;
 // Major and minor Windows version (declared as extern in globals.h)
 UINT16 g_uWinVer;
 
+// Number of logical processors (declared as extern in globals.h)
+UINT g_cProcessors;
+
 // Prototypes for the self-registration/install/uninstall helper functions
 STDAPI DllRegisterServerEx( LPCTSTR );
 HRESULT Install( BOOL, BOOL );
@@ -55,6 +58,11 @@ extern "C" BOOL WINAPI DllMain( HINSTANCE hInstance, DWORD dwReason, LPVOID lpRe
 			#ifndef _WIN64
 			if (g_uWinVer < 0x0501) return(FALSE);
 			#endif
+			{
+				SYSTEM_INFO si;
+				GetSystemInfo(&si);
+				g_cProcessors = si.dwNumberOfProcessors;
+			}
 			#ifdef _DLL
 			DisableThreadLibraryCalls(hInstance);
 			#endif
@@ -179,7 +187,7 @@ STDAPI DllRegisterServerEx( LPCTSTR lpszModuleName )
 		RegCloseKey(hKey);
 	} else return(SELFREG_E_CLASS);
 
-	// The actual association of .sfv/.md5/.sha1/.sha256/.sha512/.sha3-256/.sha3-512/.asc files with our program ID
+	// The actual association of .sfv/.md5/.sha1/.sha256/.sha512/.sha3-256/.sha3-512/.b3/.xxh128/.k12/.crc32c/.b2/.b2bp/.asc files with our program ID
 	// will be handled by DllInstall, not DllRegisterServer.
 
 	// Register approval
@@ -10,7 +10,9 @@
 #include <assert.h>
 #include "globals.h"
 #include "HashCheckCommon.h"
+#include "HashCheckOptions.h"
 #include "GetHighMSB.h"
+#include "libs/WinHashMB.h"
 #include <Strsafe.h>
 
 #define PROGRESS_BAR_STEPS 300
@@ -32,6 +34,21 @@ HANDLE __fastcall CreateThreadCRT( PVOID pThreadProc, PVOID pvParam )
             pcmnctx->hUnpauseEvent = CreateEvent(NULL, TRUE, TRUE, NULL);
 		SendMessage(pcmnctx->hWndPBFile, PBM_SETRANGE, 0, MAKELPARAM(0, PROGRESS_BAR_STEPS));
 
+		// How and in what order files are read are registry-only options
+		{
+			HASHCHECKOPTIONS opt;
+			opt.dwFlags = HCOF_READMODE | HCOF_DISKORDER;
+			OptionsLoad(&opt);
+
+			pcmnctx->dwFlags &= ~(HCF_MAPPED_READS | HCF_UNBUFFERED_READS | HCF_DISK_ORDER);
+			if (opt.dwReadMode == READMODE_MAPPED)
+				pcmnctx->dwFlags |= HCF_MAPPED_READS;
+			else if (opt.dwReadMode == READMODE_UNBUFFERED)
+				pcmnctx->dwFlags |= HCF_UNBUFFERED_READS;
+			if (opt.dwDiskOrder == DISKORDER_PHYSICAL)
+				pcmnctx->dwFlags |= HCF_DISK_ORDER;
+		}
+
 		pThreadProc = WorkerThreadStartup;
 	}
 
@@ -58,6 +75,45 @@ HANDLE __fastcall OpenFileForReading( PCTSTR pszPath )
 	));
 }
 
+// Opens a file that is to be hashed; in the unbuffered read mode the file
+// cache is bypassed, which requires the offset and length of every read and
+// its buffer to be sector-aligned: all of them here are multiples of 8K into
+// buffers from VirtualAlloc, and the unaligned end of a file comes from such
+// a read that is cut short
+static HANDLE WINAPI OpenFileForHashing( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath, DWORD dwFlags )
+{
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+
+	if (pcmnctx->dwFlags & HCF_UNBUFFERED_READS)
+	{
+		hFile = CreateFile(
+			pszPath,
+			GENERIC_READ,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			NULL,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | dwFlags,
+			NULL
+		);
+	}
+
+	// Fall back to reading through the cache if that is not supported
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		hFile = CreateFile(
+			pszPath,
+			GENERIC_READ,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			NULL,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN | dwFlags,
+			NULL
+		);
+	}
+
+	return(hFile);
+}
+
 VOID __fastcall HCNormalizeString( PTSTR psz )
 {
 	if (!psz) return;
@@ -331,8 +387,593 @@ __inline VOID UpdateProgressBar( HWND hWndPBFile, PCRITICAL_SECTION pCritSec,
     }
 }
 
+// A single segment of a file which is read and hashed by its own thread; since
+// CRC-32 is linear and BLAKE3 is a tree, the per-segment results can be merged
+// afterwards
+typedef VOID (WINAPI *PFNSEGMENTUPDATE)( PVOID pvState, PCBYTE pbIn, UINT cbIn );
+
+typedef struct {
+	PCOMMONCONTEXT     pcmnctx;      // the worker context (for pause/cancel)
+	PCTSTR             pszPath;      // path of the file
+	ULONGLONG          ibOffset;     // offset of the first byte of this segment
+	ULONGLONG          cbLength;     // length of this segment, in bytes
+	PFNSEGMENTUPDATE   pfnUpdate;    // hash update function
+	PVOID              pvState;      // hash state of this segment
+	volatile LONGLONG *pcbRead;      // total bytes read so far, shared by all segments
+	BOOL               bComplete;    // set if the whole segment was read and hashed
+} HASHSEGMENT, *PHASHSEGMENT;
+
+static DWORD WINAPI WorkerThreadHashSegment( PHASHSEGMENT pseg )
+{
+	HANDLE hFile;
+	PBYTE pbBuffer;
+	ULONGLONG cbLeft = pseg->cbLength;
+	DWORD cbBufferRead;
+
+	if ((hFile = OpenFileForHashing(pseg->pcmnctx, pseg->pszPath, 0)) == INVALID_HANDLE_VALUE)
+		return(0);
+
+	if ( (pbBuffer = (PBYTE)VirtualAlloc(NULL, READ_BUFFER_SIZE, MEM_COMMIT, PAGE_READWRITE)) &&
+	     SetFilePointerEx(hFile, *(PLARGE_INTEGER)&pseg->ibOffset, NULL, FILE_BEGIN) )
+	{
+		while (cbLeft)
+		{
+			if (pseg->pcmnctx->status == PAUSED)
+				WaitForSingleObject(pseg->pcmnctx->hUnpauseEvent, INFINITE);
+			if (pseg->pcmnctx->status == CANCEL_REQUESTED)
+				break;
+
+			// Only the last segment can have a partial buffer left, and the
+			// read is then cut short by the end of the file (unless it grew)
+			if ( !ReadFile(hFile, pbBuffer, READ_BUFFER_SIZE, &cbBufferRead, NULL) ||
+			     cbBufferRead == 0 )
+				break;
+
+			cbBufferRead = (DWORD)min(cbBufferRead, cbLeft);
+			pseg->pfnUpdate(pseg->pvState, pbBuffer, cbBufferRead);
+			cbLeft -= cbBufferRead;
+			InterlockedExchangeAdd64(pseg->pcbRead, cbBufferRead);
+		}
+
+		pseg->bComplete = (cbLeft == 0);
+	}
+
+	if (pbBuffer)
+		VirtualFree(pbBuffer, 0, MEM_RELEASE);
+	CloseHandle(hFile);
+	return(0);
+}
+
+// Reads and hashes cSegments consecutive segments of cbSegment bytes (the last
+// one takes the remainder) concurrently, each one into its own state in the
+// pvStates array; returns TRUE only if every segment was completely hashed
+static BOOL WINAPI WorkerThreadHashSegments( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath,
+                                             ULONGLONG cbFileSize, UINT cSegments, ULONGLONG cbSegment,
+                                             PFNSEGMENTUPDATE pfnUpdate, PVOID pvStates, SIZE_T cbState,
+                                             BOOL bUpdateProgress, PCRITICAL_SECTION pUpdateCritSec,
+                                             volatile ULONGLONG* pcbCurrentMaxSize )
+{
+	HASHSEGMENT segs[MAX_SEGMENTS];
+	HANDLE ahThreads[MAX_SEGMENTS];
+	volatile LONGLONG cbRead = 0;
+	UINT lastProgress = 0, cThreads = 0, i;
+	BOOL bCurrentlyUpdating = FALSE, bComplete = TRUE;
+	DWORD dwWait = WAIT_OBJECT_0;
+
+	assert(cSegments <= MAX_SEGMENTS);
+
+	for (i = 0; i < cSegments; ++i)
+	{
+		segs[i].pcmnctx   = pcmnctx;
+		segs[i].pszPath   = pszPath;
+		segs[i].ibOffset  = cbSegment * i;
+		segs[i].cbLength  = (i < cSegments - 1) ? cbSegment : cbFileSize - segs[i].ibOffset;
+		segs[i].pfnUpdate = pfnUpdate;
+		segs[i].pvState   = (PBYTE)pvStates + cbState * i;
+		segs[i].pcbRead   = &cbRead;
+		segs[i].bComplete = FALSE;
+
+		if (ahThreads[cThreads] = CreateThreadCRT(WorkerThreadHashSegment, &segs[i]))
+			++cThreads;
+		else
+			WorkerThreadHashSegment(&segs[i]);  // fall back to hashing it on this thread
+	}
+
+	// The segment threads take care of pausing and canceling by themselves;
+	// all this thread needs to do is to keep the progress bar moving
+	while (cThreads && (dwWait = WaitForMultipleObjects(cThreads, ahThreads, TRUE, 250)) == WAIT_TIMEOUT)
+	{
+		if (bUpdateProgress)
+			UpdateProgressBar(pcmnctx->hWndPBFile, pUpdateCritSec, &bCurrentlyUpdating, pcbCurrentMaxSize,
+			                  cbFileSize, InterlockedCompareExchange64(&cbRead, 0, 0), &lastProgress);
+	}
+
+	// If the wait itself failed, the segment threads may still be using segs
+	// and their buffers, so they must each be waited for before returning
+	if (dwWait == WAIT_FAILED)
+	{
+		for (i = 0; i < cThreads; ++i)
+			WaitForSingleObject(ahThreads[i], INFINITE);
+	}
+
+	for (i = 0; i < cThreads; ++i)
+		CloseHandle(ahThreads[i]);
+
+	for (i = 0; i < cSegments; ++i)
+		bComplete &= segs[i].bComplete;
+
+	if (bUpdateProgress)
+		UpdateProgressBar(pcmnctx->hWndPBFile, pUpdateCritSec, &bCurrentlyUpdating,
+		                  pcbCurrentMaxSize, cbFileSize, 0, &lastProgress);
+
+	return(bComplete);
+}
+
+static VOID WINAPI SegmentUpdateCRC32( PVOID pvState, PCBYTE pbIn, UINT cbIn )
+{
+	WHUpdateCRC32((PWHCTXCRC32)pvState, pbIn, cbIn);
+}
+
+// Hashes a large CRC-32-only file in concurrently read segments and merges the
+// partial CRCs; returns the number of bytes hashed (cbFileSize iff successful)
+static ULONGLONG WINAPI WorkerThreadHashSegmentsCRC32( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath,
+                                                       PWHCTXEX pwhctx, ULONGLONG cbFileSize, UINT cSegments,
+                                                       PCRITICAL_SECTION pUpdateCritSec,
+                                                       volatile ULONGLONG* pcbCurrentMaxSize )
+{
+	WHCTXCRC32 ctxSegments[MAX_SEGMENTS];
+	ULONGLONG cbSegment;
+	UINT i;
+
+	// Round the segment size up to a whole number of read buffers
+	cbSegment = (cbFileSize / cSegments + READ_BUFFER_SIZE - 1) & ~(ULONGLONG)(READ_BUFFER_SIZE - 1);
+	cSegments = (UINT)((cbFileSize + cbSegment - 1) / cbSegment);
+
+	for (i = 0; i < cSegments; ++i)
+		WHInitCRC32(&ctxSegments[i]);
+
+	if (! WorkerThreadHashSegments(pcmnctx, pszPath, cbFileSize, cSegments, cbSegment,
+	                               SegmentUpdateCRC32, ctxSegments, sizeof(WHCTXCRC32),
+	                               cbFileSize >= READ_BUFFER_SIZE * 4, pUpdateCritSec, pcbCurrentMaxSize))
+		return(0);
+
+	// crc(A || B) = crc32_combine(crc(A), crc(B), len(B))
+	pwhctx->ctxCRC32.state = ctxSegments[0].state;
+	for (i = 1; i < cSegments; ++i)
+	{
+		pwhctx->ctxCRC32.state = crc32_combine(pwhctx->ctxCRC32.state, ctxSegments[i].state,
+			(i < cSegments - 1) ? cbSegment : cbFileSize - cbSegment * i);
+	}
+
+	return(cbFileSize);
+}
+
+static VOID WINAPI SegmentUpdateBLAKE3( PVOID pvState, PCBYTE pbIn, UINT cbIn )
+{
+	WHUpdateBLAKE3((PWHCTXBLAKE3)pvState, pbIn, cbIn);
+}
+
+// Hashes a large BLAKE3-only file in concurrently read segments, each of which
+// is a run of whole subtrees, and appends them together; returns the number of
+// bytes hashed (cbFileSize iff successful)
+static ULONGLONG WINAPI WorkerThreadHashSegmentsBLAKE3( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath,
+                                                        PWHCTXEX pwhctx, ULONGLONG cbFileSize, UINT cSegments,
+                                                        PCRITICAL_SECTION pUpdateCritSec,
+                                                        volatile ULONGLONG* pcbCurrentMaxSize )
+{
+	WHCTXBLAKE3 ctxSegments[MAX_SEGMENTS];
+	ULONGLONG cbSegment;
+	UINT i;
+
+	// The segment size must be a power of 2 (which READ_BUFFER_SIZE also is)
+	// so that every segment starts on a subtree boundary of its own size
+	for (cbSegment = READ_BUFFER_SIZE; cbSegment * cSegments < cbFileSize; cbSegment <<= 1);
+	cSegments = (UINT)((cbFileSize + cbSegment - 1) / cbSegment);
+
+	for (i = 0; i < cSegments; ++i)
+		BLAKE3InitAt(&ctxSegments[i], cbSegment * i);
+
+	if (! WorkerThreadHashSegments(pcmnctx, pszPath, cbFileSize, cSegments, cbSegment,
+	                               SegmentUpdateBLAKE3, ctxSegments, sizeof(WHCTXBLAKE3),
+	                               cbFileSize >= READ_BUFFER_SIZE * 4, pUpdateCritSec, pcbCurrentMaxSize))
+		return(0);
+
+	pwhctx->ctxBLAKE3 = ctxSegments[0];
+	for (i = 1; i < cSegments; ++i)
+		BLAKE3Append(&pwhctx->ctxBLAKE3, &ctxSegments[i]);
+
+	return(cbFileSize);
+}
+
+// KangarooTwelve's leaves are also hashed independently, but the final node
+// must absorb their chaining values in order; rather than being split into a
+// few large segments (all of whose chaining values would have to be held until
+// the segments before them were done), a K12-only file is dealt out to the
+// leaf threads one run of READ_BUFFER_SIZE bytes at a time, round-robin, and
+// each leaf thread can get at most K12_RUNS_AHEAD runs ahead of the final node
+#define K12_RUN_LEAVES (READ_BUFFER_SIZE / K12_CHUNK_LENGTH)
+#define K12_RUNS_AHEAD 4
+
+typedef struct {
+	PCOMMONCONTEXT     pcmnctx;      // the worker context (for pause/cancel)
+	PCTSTR             pszPath;      // path of the file
+	ULONGLONG          cLeaves;      // number of whole leaves in the file after the first chunk
+	ULONGLONG          iFirstRun;    // this thread hashes runs iFirstRun, iFirstRun + cThreads, ...
+	UINT               cThreads;
+	HANDLE             hFilled;      // semaphore counting the runs hashed but not yet absorbed
+	HANDLE             hEmptied;     // semaphore counting the free run slots
+	volatile BOOL     *pbStop;       // set once no more runs are needed
+	volatile LONGLONG *pcbRead;      // total bytes read so far, shared by all leaf threads
+	UINT               acHashed[K12_RUNS_AHEAD];  // the number of leaves hashed into each slot
+	BYTE               cvs[K12_RUNS_AHEAD][K12_RUN_LEAVES * K12_CV_LENGTH];
+} K12LEAFTHREAD, *PK12LEAFTHREAD;
+
+// Reads and hashes one run into a slot; returns the number of leaves hashed,
+// which is less than the run's length if it could not be read completely
+static UINT WINAPI K12HashRun( PK12LEAFTHREAD plt, HANDLE hFile, PBYTE pbBuffer, ULONGLONG iRun, UINT iSlot )
+{
+	ULONGLONG ibOffset = K12_CHUNK_LENGTH + iRun * READ_BUFFER_SIZE;
+	UINT cLeaves = (UINT)min(plt->cLeaves - iRun * K12_RUN_LEAVES, K12_RUN_LEAVES);
+	DWORD cbBufferRead;
+
+	if ( !SetFilePointerEx(hFile, *(PLARGE_INTEGER)&ibOffset, NULL, FILE_BEGIN) ||
+	     !ReadFile(hFile, pbBuffer, cLeaves * K12_CHUNK_LENGTH, &cbBufferRead, NULL) )
+		return(0);
+
+	cLeaves = cbBufferRead / K12_CHUNK_LENGTH;
+	K12HashLeaves(pbBuffer, cLeaves, plt->cvs[iSlot]);
+	InterlockedExchangeAdd64(plt->pcbRead, cbBufferRead);
+	return(cLeaves);
+}
+
+static DWORD WINAPI WorkerThreadHashLeavesK12( PK12LEAFTHREAD plt )
+{
+	HANDLE hFile = OpenFileForHashing(plt->pcmnctx, plt->pszPath, 0);
+	PBYTE pbBuffer = (PBYTE)VirtualAlloc(NULL, READ_BUFFER_SIZE, MEM_COMMIT, PAGE_READWRITE);
+	ULONGLONG cRuns = (plt->cLeaves + K12_RUN_LEAVES - 1) / K12_RUN_LEAVES, iRun;
+	UINT iSlot = 0;
+
+	for (iRun = plt->iFirstRun; iRun < cRuns; iRun += plt->cThreads)
+	{
+		WaitForSingleObject(plt->hEmptied, INFINITE);
+
+		if (plt->pcmnctx->status == PAUSED)
+			WaitForSingleObject(plt->pcmnctx->hUnpauseEvent, INFINITE);
+		if (*plt->pbStop || plt->pcmnctx->status == CANCEL_REQUESTED)
+			break;
+
+		// A run that could not be hashed is passed on as a short one
+		plt->acHashed[iSlot] = (hFile != INVALID_HANDLE_VALUE && pbBuffer) ?
+			K12HashRun(plt, hFile, pbBuffer, iRun, iSlot) : 0;
+
+		ReleaseSemaphore(plt->hFilled, 1, NULL);
+		iSlot = (iSlot + 1) % K12_RUNS_AHEAD;
+	}
+
+	if (pbBuffer)
+		VirtualFree(pbBuffer, 0, MEM_RELEASE);
+	if (hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(hFile);
+	return(0);
+}
+
+// Hashes a large K12-only file with cThreads leaf threads; this thread absorbs
+// the first chunk, then the runs' chaining values as they come in (hashing the
+// runs of any leaf thread that could not be started itself), and then the
+// remaining partial leaf; returns the number of bytes hashed (cbFileSize iff
+// successful); the caller's buffer is left alone, since it may hold pszPath
+static ULONGLONG WINAPI WorkerThreadHashTreeK12( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath, HANDLE hFile,
+                                                 PWHCTXEX pwhctx, ULONGLONG cbFileSize, UINT cThreads,
+                                                 PCRITICAL_SECTION pUpdateCritSec,
+                                                 volatile ULONGLONG* pcbCurrentMaxSize )
+{
+	PK12LEAFTHREAD plts, plt;
+	PBYTE pbBuffer;
+	HANDLE ahThreads[MAX_SEGMENTS];
+	volatile LONGLONG cbRead = K12_CHUNK_LENGTH;
+	volatile BOOL bStop = FALSE;
+	ULONGLONG cLeaves = cbFileSize / K12_CHUNK_LENGTH - 1;
+	ULONGLONG cRuns = (cLeaves + K12_RUN_LEAVES - 1) / K12_RUN_LEAVES, iRun = 0;
+	ULONGLONG ibTail = K12_CHUNK_LENGTH * (cLeaves + 1);
+	UINT lastProgress = 0, iSlot, i;
+	DWORD cbBufferRead;
+	BOOL bUpdateProgress = cbFileSize >= READ_BUFFER_SIZE * 4,
+	     bCurrentlyUpdating = FALSE, bComplete = FALSE;
+
+	assert(cThreads <= MAX_SEGMENTS);
+
+	// This thread's read buffer is followed by the leaf threads' contexts
+	if (! (pbBuffer = (PBYTE)VirtualAlloc(NULL, READ_BUFFER_SIZE + sizeof(K12LEAFTHREAD) * cThreads,
+	                                      MEM_COMMIT, PAGE_READWRITE)))
+		return(0);
+
+	plts = (PK12LEAFTHREAD)(pbBuffer + READ_BUFFER_SIZE);
+
+	// The first chunk goes straight into the final node
+	if ( !ReadFile(hFile, pbBuffer, K12_CHUNK_LENGTH, &cbBufferRead, NULL) ||
+	     cbBufferRead != K12_CHUNK_LENGTH )
+	{
+		VirtualFree(pbBuffer, 0, MEM_RELEASE);
+		return(0);
+	}
+
+	WHUpdateK12(&pwhctx->ctxK12, pbBuffer, cbBufferRead);
+
+	for (i = 0; i < cThreads; ++i)
+	{
+		plts[i].pcmnctx   = pcmnctx;
+		plts[i].pszPath   = pszPath;
+		plts[i].cLeaves   = cLeaves;
+		plts[i].iFirstRun = i;
+		plts[i].cThreads  = cThreads;
+		plts[i].hFilled   = CreateSemaphore(NULL, 0, K12_RUNS_AHEAD, NULL);
+		plts[i].hEmptied  = CreateSemaphore(NULL, K12_RUNS_AHEAD, K12_RUNS_AHEAD, NULL);
+		plts[i].pbStop    = &bStop;
+		plts[i].pcbRead   = &cbRead;
+
+		ahThreads[i] = (plts[i].hFilled && plts[i].hEmptied) ?
+			CreateThreadCRT(WorkerThreadHashLeavesK12, &plts[i]) : NULL;
+	}
+
+	for ( ; iRun < cRuns; ++iRun)
+	{
+		plt = &plts[iRun % cThreads];
+		iSlot = (UINT)(iRun / cThreads % K12_RUNS_AHEAD);
+
+		if (ahThreads[iRun % cThreads])
+		{
+			// The leaf threads take care of pausing by themselves
+			while ( pcmnctx->status != CANCEL_REQUESTED &&
+			        WaitForSingleObject(plt->hFilled, 250) == WAIT_TIMEOUT )
+			{
+				if (bUpdateProgress)
+					UpdateProgressBar(pcmnctx->hWndPBFile, pUpdateCritSec, &bCurrentlyUpdating, pcbCurrentMaxSize,
+					                  cbFileSize, InterlockedCompareExchange64(&cbRead, 0, 0), &lastProgress);
+			}
+		}
+		else  // fall back to hashing the run on this thread
+		{
+			if (pcmnctx->status == PAUSED)
+				WaitForSingleObject(pcmnctx->hUnpauseEvent, INFINITE);
+			if (pcmnctx->status != CANCEL_REQUESTED)
+				plt->acHashed[iSlot] = K12HashRun(plt, hFile, pbBuffer, iRun, iSlot);
+		}
+
+		if ( pcmnctx->status == CANCEL_REQUESTED ||
+		     plt->acHashed[iSlot] != min(cLeaves - iRun * K12_RUN_LEAVES, K12_RUN_LEAVES) )
+			break;
+
+		K12AppendLeaves(&pwhctx->ctxK12, plt->cvs[iSlot], plt->acHashed[iSlot]);
+
+		if (ahThreads[iRun % cThreads])
+			ReleaseSemaphore(plt->hEmptied, 1, NULL);
+
+		if (bUpdateProgress && (iRun & 0x03) == 0x03)
+			UpdateProgressBar(pcmnctx->hWndPBFile, pUpdateCritSec, &bCurrentlyUpdating, pcbCurrentMaxSize,
+			                  cbFileSize, InterlockedCompareExchange64(&cbRead, 0, 0), &lastProgress);
+	}
+
+	// Wake any leaf threads which are still waiting for a free slot
+	bStop = TRUE;
+	for (i = 0; i < cThreads; ++i)
+	{
+		if (ahThreads[i])
+		{
+			ReleaseSemaphore(plts[i].hEmptied, 1, NULL);
+			WaitForSingleObject(ahThreads[i], INFINITE);
+			CloseHandle(ahThreads[i]);
+		}
+		if (plts[i].hFilled)
+			CloseHandle(plts[i].hFilled);
+		if (plts[i].hEmptied)
+			CloseHandle(plts[i].hEmptied);
+	}
+
+	// What is left is less than a leaf
+	if ( iRun == cRuns &&
+	     SetFilePointerEx(hFile, *(PLARGE_INTEGER)&ibTail, NULL, FILE_BEGIN) &&
+	     ReadFile(hFile, pbBuffer, K12_CHUNK_LENGTH, &cbBufferRead, NULL) &&
+	     cbBufferRead == cbFileSize - ibTail )
+	{
+		WHUpdateK12(&pwhctx->ctxK12, pbBuffer, cbBufferRead);
+		bComplete = TRUE;
+	}
+
+	if (bUpdateProgress)
+		UpdateProgressBar(pcmnctx->hWndPBFile, pUpdateCritSec, &bCurrentlyUpdating,
+		                  pcbCurrentMaxSize, cbFileSize, 0, &lastProgress);
+
+	VirtualFree(pbBuffer, 0, MEM_RELEASE);
+	return(bComplete ? cbFileSize : 0);
+}
+
+// Hashes a file through a sliding read-only view of its mapping, so that
+// pages which are already in the file cache are hashed without being copied;
+// returns the number of bytes hashed (cbFileSize iff successful)
+static ULONGLONG WINAPI WorkerThreadHashMapped( PCOMMONCONTEXT pcmnctx, HANDLE hMapping,
+                                                PWHCTXEX pwhctx, ULONGLONG cbFileSize,
+                                                PCRITICAL_SECTION pUpdateCritSec,
+                                                volatile ULONGLONG* pcbCurrentMaxSize )
+{
+	typedef BOOL (WINAPI *PFNPREFETCHVIRTUALMEMORY)( HANDLE, ULONG_PTR, PWIN32_MEMORY_RANGE_ENTRY, ULONG );
+
+	// Available only on Windows 8 and later
+	PFNPREFETCHVIRTUALMEMORY pfnPrefetchVirtualMemory = (PFNPREFETCHVIRTUALMEMORY)
+		GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory");
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	ULONGLONG ibView = 0;
+	UINT lastProgress = 0;
+	BOOL bUpdateProgress = cbFileSize >= READ_BUFFER_SIZE * 4,
+	     bCurrentlyUpdating = FALSE;
+
+	while (ibView < cbFileSize)
+	{
+		SIZE_T cbView = (SIZE_T)min(cbFileSize - ibView, MAP_VIEW_SIZE);
+		BOOL bHashed = FALSE;
+		PCBYTE pbView;
+
+		if (pcmnctx->status == PAUSED)
+			WaitForSingleObject(pcmnctx->hUnpauseEvent, INFINITE);
+		if (pcmnctx->status == CANCEL_REQUESTED)
+			break;
+
+		if (!(pbView = MapViewOfFile(hMapping, FILE_MAP_READ, (DWORD)(ibView >> 32), (DWORD)ibView, cbView)))
+			break;
+
+		// Have the whole view read in with large sequential reads ahead of the
+		// hashing, rather than one page fault at a time
+		if (pfnPrefetchVirtualMemory)
+		{
+			range.VirtualAddress = (PVOID)pbView;
+			range.NumberOfBytes = cbView;
+			pfnPrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+
+		// A read error (or the file being truncated) surfaces as an in-page
+		// error when the view is touched instead of as a failed ReadFile
+		__try
+		{
+			// The hashing must stay on this thread: an in-page error is raised
+			// on whichever thread touches the page, and only this one has the
+			// __except for it (WHUpdateEx may hand the view to other threads,
+			// where it would end the process)
+			WHUpdateExSerial64(pwhctx, pbView, cbView);
+			bHashed = TRUE;
+		}
+		__except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ?
+		          EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+		{
+		}
+
+		UnmapViewOfFile(pbView);
+
+		if (!bHashed)
+			break;
+
+		ibView += cbView;
+
+		if (bUpdateProgress)
+			UpdateProgressBar(pcmnctx->hWndPBFile, pUpdateCritSec, &bCurrentlyUpdating,
+			                  pcbCurrentMaxSize, cbFileSize, ibView, &lastProgress);
+	}
+
+	if (bUpdateProgress)
+		UpdateProgressBar(pcmnctx->hWndPBFile, pUpdateCritSec, &bCurrentlyUpdating,
+		                  pcbCurrentMaxSize, cbFileSize, 0, &lastProgress);
+
+	return(ibView);
+}
+
+// Overlapped read-ahead for a file that is hashed on a single thread: a ring
+// of READ_AHEAD_BUFFERS reads is kept in flight on a second, overlapped handle
+// so that the disk is reading the next buffers while the current one is hashed
+typedef struct {
+	HANDLE     hFile;                         // overlapped handle of the file
+	PBYTE      pbAlloc;                       // buffers other than the caller's
+	ULONGLONG  ibNext;                        // offset of the next read to issue
+	UINT       iNext;                         // ring index of the next read to complete
+	UINT       iHeld;                         // ring index held by the caller, or -1
+	PBYTE      apb[READ_AHEAD_BUFFERS];       // the ring of buffers
+	OVERLAPPED aov[READ_AHEAD_BUFFERS];       // the reads into each of them
+	BOOL       abPending[READ_AHEAD_BUFFERS]; // set if a read was issued into it
+} READAHEAD, *PREADAHEAD;
+
+static VOID WINAPI ReadAheadIssue( PREADAHEAD pra, UINT i )
+{
+	pra->aov[i].Offset = (DWORD)pra->ibNext;
+	pra->aov[i].OffsetHigh = (DWORD)(pra->ibNext >> 32);
+	pra->ibNext += READ_BUFFER_SIZE;
+
+	// Reads past the end of the file fail right away (with ERROR_HANDLE_EOF),
+	// and are then reported as having read zero bytes
+	pra->abPending[i] = ReadFile(pra->hFile, pra->apb[i], READ_BUFFER_SIZE, NULL, &pra->aov[i]) ||
+	                    GetLastError() == ERROR_IO_PENDING;
+}
+
+// Opens pszPath for overlapped reading and starts reading it into a ring which
+// uses pbuffer (READ_BUFFER_SIZE bytes) as one of its buffers; returns FALSE
+// if read-ahead is not available, in which case nothing needs to be cleaned up
+static BOOL WINAPI ReadAheadStart( PREADAHEAD pra, PCOMMONCONTEXT pcmnctx, PCTSTR pszPath, PBYTE pbuffer )
+{
+	UINT i;
+
+	ZeroMemory(pra, sizeof(READAHEAD));
+	pra->iHeld = (UINT)-1;
+	pra->hFile = OpenFileForHashing(pcmnctx, pszPath, FILE_FLAG_OVERLAPPED);
+
+	if (pra->hFile == INVALID_HANDLE_VALUE)
+		return(FALSE);
+
+	if (pra->pbAlloc = (PBYTE)VirtualAlloc(NULL, READ_BUFFER_SIZE * (READ_AHEAD_BUFFERS - 1),
+	                                       MEM_COMMIT, PAGE_READWRITE))
+	{
+		for (i = 0; i < READ_AHEAD_BUFFERS; ++i)
+		{
+			pra->apb[i] = i ? pra->pbAlloc + READ_BUFFER_SIZE * (i - 1) : pbuffer;
+			if (! (pra->aov[i].hEvent = CreateEvent(NULL, TRUE, FALSE, NULL)))
+				break;
+		}
+
+		if (i == READ_AHEAD_BUFFERS)
+		{
+			for (i = 0; i < READ_AHEAD_BUFFERS; ++i)
+				ReadAheadIssue(pra, i);
+
+			return(TRUE);
+		}
+
+		while (i--)
+			CloseHandle(pra->aov[i].hEvent);
+
+		VirtualFree(pra->pbAlloc, 0, MEM_RELEASE);
+	}
+
+	CloseHandle(pra->hFile);
+	return(FALSE);
+}
+
+// Returns the next buffer in file order once its read has completed, and
+// reuses the buffer returned by the previous call for a new read
+static PBYTE WINAPI ReadAheadNext( PREADAHEAD pra, PDWORD pcbRead )
+{
+	UINT i = pra->iNext;
+
+	if (pra->iHeld != (UINT)-1)
+		ReadAheadIssue(pra, pra->iHeld);
+
+	if (! (pra->abPending[i] && GetOverlappedResult(pra->hFile, &pra->aov[i], pcbRead, TRUE)))
+		*pcbRead = 0;
+
+	pra->abPending[i] = FALSE;
+	pra->iHeld = i;
+	pra->iNext = (i + 1) % READ_AHEAD_BUFFERS;
+	return(pra->apb[i]);
+}
+
+// Cancels the reads which are still in flight and releases the ring
+static VOID WINAPI ReadAheadEnd( PREADAHEAD pra )
+{
+	DWORD cbRead;
+	UINT i;
+
+	CancelIo(pra->hFile);
+
+	for (i = 0; i < READ_AHEAD_BUFFERS; ++i)
+	{
+		// The buffers must not be freed while the system may still write to them
+		if (pra->abPending[i])
+			GetOverlappedResult(pra->hFile, &pra->aov[i], &cbRead, TRUE);
+
+		CloseHandle(pra->aov[i].hEvent);
+	}
+
+	VirtualFree(pra->pbAlloc, 0, MEM_RELEASE);
+	CloseHandle(pra->hFile);
+}
+
 VOID WINAPI WorkerThreadHashFile( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath,
-                                  PWHCTXEX pwhctx, PWHRESULTEX pwhres, PBYTE pbuffer,
+                                  PWHCTXEX pwhctx, PWHRESULTEX pwhres, PBYTE pbuffer, PWHPIPE pPipe,
                                   PFILESIZE pFileSize, LPARAM lParam,
                                   PCRITICAL_SECTION pUpdateCritSec, volatile ULONGLONG* pcbCurrentMaxSize
 #ifdef _TIMED
@@ -367,12 +1008,15 @@ VOID WINAPI WorkerThreadHashFile( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath,
 	// Indicate that we want lower-case results (TODO: make this an option)
 	pwhctx->uCaseMode = WHFMT_LOWERCASE;
 
-	if ((hFile = OpenFileForReading(pszPath)) != INVALID_HANDLE_VALUE)
+	if ((hFile = OpenFileForHashing(pcmnctx, pszPath, 0)) != INVALID_HANDLE_VALUE)
 	{
 		ULONGLONG cbFileSize, cbFileRead = 0;
 		DWORD cbBufferRead;
-		UINT lastProgress = 0;
+		UINT lastProgress = 0, cSegments;
 		UINT8 cInner = 0;
+		READAHEAD ra;
+		BOOL bReadAhead = FALSE;
+		HANDLE hMapping;
 
 		if (GetFileSizeEx(hFile, (PLARGE_INTEGER)&cbFileSize))
 		{
@@ -383,6 +1027,17 @@ VOID WINAPI WorkerThreadHashFile( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath,
 			BOOL bUpdateProgress = cbFileSize >= READ_BUFFER_SIZE * 4,
 			     bCurrentlyUpdating = FALSE;
 
+			// If the caller has a pipeline, files of more than one buffer are
+			// hashed with all of the requested algorithms in parallel by its
+			// threads, which otherwise would only add handoff overhead
+			BOOL bPipelined = pPipe && cbFileSize > READ_BUFFER_SIZE &&
+			                  (pwhctx->dwFlags & (pwhctx->dwFlags - 1));
+
+			// Callers which hash many files in parallel update each of them on
+			// one thread, rather than spreading its algorithms across cores
+			VOID (WHAPI *pfnUpdate)( PWHCTXEX, PCBYTE, UINT ) =
+				(pcmnctx->dwFlags & HCF_SERIAL_UPDATES) ? WHUpdateExSerial : WHUpdateEx;
+
 			// If the caller provides a way to return the file size, then set
 			// the file size; send a SETSIZE notification only if it was "big"
 			if (pFileSize)
@@ -401,29 +1056,108 @@ VOID WINAPI WorkerThreadHashFile( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath,
 			// progress bar is updated only once every 4 buffer reads (512K)
 			WHInitEx(pwhctx);
 
-			do // Outer loop: keep going until the end
+			// A large file on fast storage for which only CRC-32, only BLAKE3,
+			// or only K12 was requested can be split into segments (or runs of
+			// leaves) that are read and hashed concurrently
+			if ( (pcmnctx->dwFlags & HCF_PARALLEL_SEGMENTS) &&
+			     (pwhctx->dwFlags == WHEX_CHECKCRC32 || pwhctx->dwFlags == WHEX_CHECKBLAKE3 ||
+			      pwhctx->dwFlags == WHEX_CHECKK12) &&
+			     (cSegments = (UINT)min(min(g_cProcessors, MAX_SEGMENTS), cbFileSize / MIN_SEGMENT_SIZE)) > 1 )
 			{
-				do // Inner loop: break every 4 cycles or if the end is reached
+				if (pwhctx->dwFlags == WHEX_CHECKCRC32)
+					cbFileRead = WorkerThreadHashSegmentsCRC32(pcmnctx, pszPath, pwhctx, cbFileSize, cSegments,
+					                                           pUpdateCritSec, pcbCurrentMaxSize);
+				else if (pwhctx->dwFlags == WHEX_CHECKBLAKE3)
+					cbFileRead = WorkerThreadHashSegmentsBLAKE3(pcmnctx, pszPath, pwhctx, cbFileSize, cSegments,
+					                                            pUpdateCritSec, pcbCurrentMaxSize);
+				else
+					cbFileRead = WorkerThreadHashTreeK12(pcmnctx, pszPath, hFile, pwhctx, cbFileSize, cSegments,
+					                                     pUpdateCritSec, pcbCurrentMaxSize);
+
+				if (pcmnctx->status == CANCEL_REQUESTED)
 				{
-                    if (pcmnctx->status == PAUSED)
-                        WaitForSingleObject(pcmnctx->hUnpauseEvent, INFINITE);
-					if (pcmnctx->status == CANCEL_REQUESTED)
-					{
-						CloseHandle(hFile);
-						return;
-					}
+					CloseHandle(hFile);
+					return;
+				}
+
+				bUpdateProgress = FALSE;  // already taken care of
+			}
 
-					ReadFile(hFile, pbuffer, READ_BUFFER_SIZE, &cbBufferRead, NULL);
-					WHUpdateEx(pwhctx, pbuffer, cbBufferRead);
-					cbFileRead += cbBufferRead;
+			// If so configured, files are hashed straight out of the file cache
+			// (unless they are left to the pipeline's threads)
+			else if ( (pcmnctx->dwFlags & HCF_MAPPED_READS) && !bPipelined && cbFileSize &&
+			          (hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL)) )
+			{
+				cbFileRead = WorkerThreadHashMapped(pcmnctx, hMapping, pwhctx, cbFileSize,
+				                                    pUpdateCritSec, pcbCurrentMaxSize);
+				CloseHandle(hMapping);
 
-				} while (cbBufferRead == READ_BUFFER_SIZE && (++cInner & 0x03));
+				if (pcmnctx->status == CANCEL_REQUESTED)
+				{
+					CloseHandle(hFile);
+					return;
+				}
 
-				if (bUpdateProgress)
-					UpdateProgressBar(pcmnctx->hWndPBFile, pUpdateCritSec, &bCurrentlyUpdating,
-					                  pcbCurrentMaxSize, cbFileSize, cbFileRead, &lastProgress);
+				bUpdateProgress = FALSE;  // already taken care of
+			}
+			else
+			{
+				// Otherwise, unless the pipeline's threads already overlap hashing
+				// with reading, keep reads in flight while each buffer is hashed
+				if (!bPipelined && cbFileSize > READ_BUFFER_SIZE)
+					bReadAhead = ReadAheadStart(&ra, pcmnctx, pszPath, pbuffer);
 
-			} while (cbBufferRead == READ_BUFFER_SIZE);
+				do // Outer loop: keep going until the end
+				{
+					do // Inner loop: break every 4 cycles or if the end is reached
+					{
+                        if (pcmnctx->status == PAUSED)
+                            WaitForSingleObject(pcmnctx->hUnpauseEvent, INFINITE);
+						if (pcmnctx->status == CANCEL_REQUESTED)
+						{
+							// The pipeline may still be using pwhctx
+							if (bPipelined)
+								WHPipeWait(pPipe);
+							if (bReadAhead)
+								ReadAheadEnd(&ra);
+
+							CloseHandle(hFile);
+							return;
+						}
+
+						if (bPipelined)
+						{
+							pbuffer = WHPipeGetBuffer(pPipe);
+							ReadFile(hFile, pbuffer, READ_BUFFER_SIZE, &cbBufferRead, NULL);
+							WHPipeSubmit(pPipe, pwhctx, cbBufferRead);
+						}
+						else if (bReadAhead)
+						{
+							pbuffer = ReadAheadNext(&ra, &cbBufferRead);
+							pfnUpdate(pwhctx, pbuffer, cbBufferRead);
+						}
+						else
+						{
+							ReadFile(hFile, pbuffer, READ_BUFFER_SIZE, &cbBufferRead, NULL);
+							pfnUpdate(pwhctx, pbuffer, cbBufferRead);
+						}
+
+						cbFileRead += cbBufferRead;
+
+					} while (cbBufferRead == READ_BUFFER_SIZE && (++cInner & 0x03));
+
+					if (bUpdateProgress)
+						UpdateProgressBar(pcmnctx->hWndPBFile, pUpdateCritSec, &bCurrentlyUpdating,
+						                  pcbCurrentMaxSize, cbFileSize, cbFileRead, &lastProgress);
+
+				} while (cbBufferRead == READ_BUFFER_SIZE);
+
+				if (bReadAhead)
+					ReadAheadEnd(&ra);
+			}
+
+			if (bPipelined)
+				WHPipeWait(pPipe);
 
 			WHFinishEx(pwhctx, pwhres);
 #ifdef _TIMED
@@ -445,6 +1179,200 @@ VOID WINAPI WorkerThreadHashFile( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath,
 	}
 }
 
+// Writes the digest of a finished multi-buffer job as a result
+static VOID WINAPI BatchSetResult( PWHMBJOB pJob, UINT uAlgorithm, PWHRESULTEX pwhres )
+{
+#define BATCH_SET_RESULT_op(alg)                                                     \
+	case alg:                                                                        \
+		WHByteToHex(pJob->digest, pwhres->szHex##alg, alg##_DIGEST_LENGTH * 2, WHFMT_LOWERCASE); \
+		break;
+
+	switch (uAlgorithm)
+	{
+		FOR_EACH_HASH(BATCH_SET_RESULT_op)
+	}
+
+	pwhres->dwFlags = 1UL << (uAlgorithm - 1);
+}
+
+// A slot of a batch, along with the read which fills it
+typedef struct {
+	WHMBJOB    job;        // the slot's multi-buffer job
+	OVERLAPPED ov;         // the read of the whole file into the slot
+	HANDLE     hFile;      // overlapped handle of the file, closed once read
+	ULONGLONG  cbFileSize; // the file's size when it was opened
+} BATCHSLOT, *PBATCHSLOT;
+
+// Hashes a batch of small files with a single algorithm: up to
+// BATCH_QUEUE_DEPTH files at a time are read whole (with overlapped reads
+// which complete on a port) into the slots of a per-call arena, and each one
+// that has been read is submitted to one lane of a multi-buffer engine, so
+// results are delivered in completion order; files which turn out to be too
+// large for a slot, or whose read comes up short (e.g. because the file has
+// changed since it was opened), are not hashed, but are instead moved to the
+// start of ppvItems for the per-file path, and their number is returned
+UINT WINAPI WorkerThreadHashBatch( PCOMMONCONTEXT pcmnctx, UINT uAlgorithm,
+                                   PVOID *ppvItems, UINT cItems,
+                                   PFNBATCHGETPATH pfnGetPath, PFNBATCHDONE pfnDone, PVOID pvParam )
+{
+	TCHAR szPath[MAX_PATH_BUFFER];
+	BATCHSLOT slots[WHMB_MAX_LANES + BATCH_QUEUE_DEPTH];
+	PBATCHSLOT apFree[WHMB_MAX_LANES + BATCH_QUEUE_DEPTH], pSlot;
+	PWHMBJOB pJob;
+	WHRESULTEX whres;
+	PWHMBMGR pMgr;
+	PBYTE pbArena;
+	HANDLE hPort;
+	UINT cFree, cPending = 0, iItem = 0, cDeferred = 0;
+
+	// One slot per lane, plus one per read in flight while all the lanes are
+	// busy; the slots go first so that they are page-aligned for unbuffered
+	// reads, and the engine (which must be 64-byte aligned) follows
+	pbArena = (PBYTE)VirtualAlloc(NULL, countof(slots) * MAX_BATCH_FILE_SIZE + sizeof(WHMBMGR),
+	                              MEM_COMMIT, PAGE_READWRITE);
+	if (pbArena == NULL)
+		return(cItems);
+
+	pMgr = (PWHMBMGR)(pbArena + countof(slots) * MAX_BATCH_FILE_SIZE);
+	if ( !WHMBInit(pMgr, uAlgorithm) ||
+	     !(hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1)) )
+	{
+		VirtualFree(pbArena, 0, MEM_RELEASE);
+		return(cItems);
+	}
+
+	for (cFree = 0; cFree < WHMBLanes(pMgr) + BATCH_QUEUE_DEPTH; ++cFree)
+	{
+		slots[cFree].job.pbData = pbArena + cFree * MAX_BATCH_FILE_SIZE;
+		apFree[cFree] = &slots[cFree];
+	}
+
+	// Once canceled, no more reads are started, but those in flight must
+	// still complete before their slots can be freed
+	while ((iItem < cItems && pcmnctx->status != CANCEL_REQUESTED) || cPending)
+	{
+		// Open files and start reading them until the queue is full
+		while (iItem < cItems && cPending < BATCH_QUEUE_DEPTH)
+		{
+			BOOL bDeferred = FALSE;
+
+			// If the worker thread is working so fast that the UI cannot catch
+			// up, pause for a bit to let things settle down
+			while (pcmnctx->cSentMsgs > pcmnctx->cHandledMsgs + 50 && pcmnctx->status != CANCEL_REQUESTED)
+			{
+				Sleep(50);
+				if (pcmnctx->status == PAUSED)
+					WaitForSingleObject(pcmnctx->hUnpauseEvent, INFINITE);
+			}
+
+			if (pcmnctx->status == PAUSED)
+				WaitForSingleObject(pcmnctx->hUnpauseEvent, INFINITE);
+			if (pcmnctx->status == CANCEL_REQUESTED)
+				break;
+
+			pSlot = apFree[--cFree];
+			pSlot->job.pvUser = ppvItems[iItem];
+			pSlot->cbFileSize = 0;
+			ZeroMemory(&pSlot->ov, sizeof(OVERLAPPED));
+
+			if ((pSlot->hFile = OpenFileForHashing(pcmnctx, pfnGetPath(pvParam, ppvItems[iItem], szPath),
+			                                       FILE_FLAG_OVERLAPPED)) != INVALID_HANDLE_VALUE)
+			{
+				if (GetFileSizeEx(pSlot->hFile, (PLARGE_INTEGER)&pSlot->cbFileSize))
+				{
+					if (pSlot->cbFileSize > MAX_BATCH_FILE_SIZE)
+					{
+						bDeferred = TRUE;
+					}
+
+					// An empty file has nothing to read, so its completion is
+					// posted right away
+					else if ( CreateIoCompletionPort(pSlot->hFile, hPort, 0, 0) &&
+					          ( pSlot->cbFileSize == 0 ?
+					            PostQueuedCompletionStatus(hPort, 0, 0, &pSlot->ov) :
+					            ReadFile(pSlot->hFile, (PVOID)pSlot->job.pbData, MAX_BATCH_FILE_SIZE, NULL, &pSlot->ov) ||
+					            GetLastError() == ERROR_IO_PENDING ) )
+					{
+						++cPending;
+						++iItem;
+						continue;
+					}
+				}
+
+				CloseHandle(pSlot->hFile);
+			}
+
+			apFree[cFree++] = pSlot;
+
+			if (bDeferred)
+			{
+				ppvItems[cDeferred++] = ppvItems[iItem];
+			}
+			else
+			{
+				// Unreadable
+				whres.dwFlags = 0;
+				pfnDone(pvParam, ppvItems[iItem], &whres, pSlot->cbFileSize);
+			}
+
+			++iItem;
+		}
+
+		// Hash the next file whose read has completed
+		if (cPending)
+		{
+			LPOVERLAPPED pov;
+			ULONG_PTR uKey;
+			DWORD cbRead;
+			BOOL bRead = GetQueuedCompletionStatus(hPort, &cbRead, &uKey, &pov, INFINITE);
+
+			// pov is only NULL if the wait itself failed (which it cannot
+			// without a timeout, unless the port is somehow gone)
+			if (pov == NULL)
+				break;
+
+			pSlot = CONTAINING_RECORD(pov, BATCHSLOT, ov);
+			CloseHandle(pSlot->hFile);
+			--cPending;
+
+			if (pcmnctx->status == CANCEL_REQUESTED)
+			{
+				apFree[cFree++] = pSlot;
+			}
+			else if (bRead && cbRead == pSlot->cbFileSize)
+			{
+				pSlot->job.cbData = cbRead;
+
+				if (pJob = WHMBSubmit(pMgr, &pSlot->job))
+				{
+					BatchSetResult(pJob, uAlgorithm, &whres);
+					apFree[cFree++] = CONTAINING_RECORD(pJob, BATCHSLOT, job);
+					pfnDone(pvParam, pJob->pvUser, &whres, pJob->cbData);
+				}
+			}
+			else
+			{
+				// Left to the per-file path, which decides whether the file is
+				// unreadable; every item before iItem has been taken into a
+				// slot or decided, so the entry overwritten is no longer needed
+				apFree[cFree++] = pSlot;
+				ppvItems[cDeferred++] = pSlot->job.pvUser;
+			}
+		}
+	}
+
+	// Drain the lanes (the results of a canceled batch are simply dropped)
+	while (pcmnctx->status != CANCEL_REQUESTED && (pJob = WHMBFlush(pMgr)))
+	{
+		BatchSetResult(pJob, uAlgorithm, &whres);
+		pfnDone(pvParam, pJob->pvUser, &whres, pJob->cbData);
+	}
+
+	CloseHandle(hPort);
+	VirtualFree(pbArena, 0, MEM_RELEASE);
+	return(cDeferred);
+}
+
 __forceinline HANDLE WINAPI GetActCtx( HMODULE hModule, PCTSTR pszResourceName )
 {
 	// Wraps away the silliness of CreateActCtx, including the fact that
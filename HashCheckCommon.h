@@ -17,12 +17,24 @@ extern "C" {
 #include <windows.h>
 #include "HashCheckUI.h"
 #include "libs/WinHash.h"
+#include "libs/WinHashPipe.h"
 
 // Tuning constants
 #define MAX_PATH_BUFFER       0x800
 #define READ_BUFFER_SIZE      0x40000
 #define BASE_STACK_SIZE       0x1000
 #define MARQUEE_INTERVAL      100  // marquee progress bar animation interval
+#define MAX_SEGMENTS          16   // max. number of concurrently read segments of one file
+#define MIN_SEGMENT_SIZE      (READ_BUFFER_SIZE * 32)  // smallest segment worth its own thread (8M)
+#define READ_AHEAD_BUFFERS    3    // number of reads kept in flight while hashing a file
+#ifdef _WIN64
+#define MAP_VIEW_SIZE         0x40000000  // size of the sliding view of a mapped file (1G)
+#else
+#define MAP_VIEW_SIZE         0x04000000  // size of the sliding view of a mapped file (64M)
+#endif
+#define MAX_BATCH_FILE_SIZE   0x10000  // largest file hashed in a multi-buffer lane
+#define BATCH_SIZE            256      // number of small files per WorkerThreadHashBatch call
+#define BATCH_QUEUE_DEPTH     16       // number of small-file reads in flight per batch
 
 // Progress bar states (Vista-only)
 #ifndef PBM_SETSTATE
@@ -44,6 +56,11 @@ extern "C" {
 #define HPF_HAS_RESIZED       0x0008UL
 #define HPF_HLIST_PREPPED     0x0010UL
 #define HPF_INTERRUPTED       0x0020UL
+#define HCF_PARALLEL_SEGMENTS 0x0040UL  // large files may be split into concurrently read segments
+#define HCF_MAPPED_READS      0x0080UL  // files are hashed through views of their mappings
+#define HCF_UNBUFFERED_READS  0x0100UL  // files are read around the system's file cache
+#define HCF_SERIAL_UPDATES    0x0200UL  // each file's algorithms are updated on one thread
+#define HCF_DISK_ORDER        0x0400UL  // files on hard disks are read in physical order
 
 // Messages
 #define HM_WORKERTHREAD_DONE        (WM_APP + 0)  // wParam = ctx, lParam = 0
@@ -55,6 +72,12 @@ extern "C" {
 typedef volatile UINT MSGCOUNT, *PMSGCOUNT;
 typedef VOID (__fastcall *PFNWORKERMAIN)( PVOID );
 
+// WorkerThreadHashBatch callbacks: the first returns the path of an item (and
+// may build it in the MAX_PATH_BUFFER-sized pszBuffer), the second receives
+// the item's results (pwhres->dwFlags is zero if it could not be read)
+typedef PCTSTR (WINAPI *PFNBATCHGETPATH)( PVOID pvParam, PVOID pvItem, PTSTR pszBuffer );
+typedef VOID (WINAPI *PFNBATCHDONE)( PVOID pvParam, PVOID pvItem, PWHRESULTEX pwhres, ULONGLONG cbFileSize );
+
 // Worker thread status
 typedef volatile enum {
 	INACTIVE,
@@ -104,13 +127,16 @@ VOID WINAPI WorkerThreadCleanup( PCOMMONCONTEXT pcmnctx );
 // Worker thread functions
 DWORD WINAPI WorkerThreadStartup( PCOMMONCONTEXT pcmnctx );
 VOID WINAPI WorkerThreadHashFile( PCOMMONCONTEXT pcmnctx, PCTSTR pszPath,
-                                  PWHCTXEX pwhctx, PWHRESULTEX pwhres, PBYTE pbuffer,
+                                  PWHCTXEX pwhctx, PWHRESULTEX pwhres, PBYTE pbuffer, PWHPIPE pPipe,
                                   PFILESIZE pFileSize, LPARAM lParam,
                                   PCRITICAL_SECTION pUpdateCritSec, volatile ULONGLONG* pcbCurrentMaxSize
 #ifdef _TIMED
                                 , PDWORD pdwElapsed
 #endif
                                 );
+UINT WINAPI WorkerThreadHashBatch( PCOMMONCONTEXT pcmnctx, UINT uAlgorithm,
+                                   PVOID *ppvItems, UINT cItems,
+                                   PFNBATCHGETPATH pfnGetPath, PFNBATCHDONE pfnDone, PVOID pvParam );
 
 // Wrappers for SHGetInstanceExplorer
 ULONG_PTR __fastcall HostAddRef( );
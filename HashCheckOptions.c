@@ -12,6 +12,7 @@
 #include "HashCheckCommon.h"
 #include "HashCheckOptions.h"
 #include "libs/WinHash.h"
+#include "libs/WinHashDispatch.h"
 #include "RegHelpers.h"
 #include "libs/IsFontAvailable.h"
 #include <Strsafe.h>
@@ -145,6 +146,28 @@ VOID __fastcall OptionsLoad( PHASHCHECKOPTIONS popt )
         }
     }
 
+	if (popt->dwFlags & HCOF_READMODE)
+	{
+		if (!( hKey &&
+		       RegGetDW(hKey, TEXT("ReadMode"), &popt->dwReadMode) &&
+		       popt->dwReadMode <= READMODE_UNBUFFERED ))
+		{
+			// Fall back to default (buffered)
+			popt->dwReadMode = READMODE_BUFFERED;
+		}
+	}
+
+	if (popt->dwFlags & HCOF_DISKORDER)
+	{
+		if (!( hKey &&
+		       RegGetDW(hKey, TEXT("DiskOrder"), &popt->dwDiskOrder) &&
+		       popt->dwDiskOrder <= DISKORDER_PHYSICAL ))
+		{
+			// Fall back to default (physical order)
+			popt->dwDiskOrder = DISKORDER_PHYSICAL;
+		}
+	}
+
 	if (popt->dwFlags & HCOF_FONT)
 	{
 		DWORD dwType;
@@ -331,6 +354,14 @@ VOID WINAPI OptionsDlgInit( HWND hWnd, POPTIONSCONTEXT poptctx )
 
 		SetDlgItemText(hWnd, IDC_OPT_FONT_PREVIEW, poptctx->popt->lfFont.lfFaceName);
 	}
+
+	// Show which variant of each kernel was picked for this processor (or
+	// forced with the HASHCHECK_KERNELS override)
+	{
+		TCHAR szKernels[WHK_REPORT_LENGTH];
+		WHGetKernelReport(szKernels, countof(szKernels));
+		SetDlgItemText(hWnd, IDC_OPT_KERNELS, szKernels);
+	}
 }
 
 
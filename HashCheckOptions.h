@@ -23,6 +23,8 @@ typedef struct {
 	DWORD dwMenuDisplay;
 	DWORD dwSaveEncoding;
 	DWORD dwChecksums;
+	DWORD dwReadMode;
+	DWORD dwDiskOrder;
 	LOGFONT lfFont;
 } HASHCHECKOPTIONS, *PHASHCHECKOPTIONS;
 
@@ -32,7 +34,18 @@ typedef struct {
 #define HCOF_SAVEENCODING 0x00000004  // The dwSaveEncoding member is valid
 #define HCOF_FONT         0x00000008  // The lfFont member is valid
 #define HCOF_CHECKSUMS    0x00000010  // The dwChecksums member is valid
-#define HCOF_ALL          0x0000001F
+#define HCOF_READMODE     0x00000020  // The dwReadMode member is valid
+#define HCOF_DISKORDER    0x00000040  // The dwDiskOrder member is valid
+#define HCOF_ALL          0x0000001F  // The options of the dialog (not the registry-only ones)
+
+// Read modes (the ReadMode value, which has no UI)
+#define READMODE_BUFFERED   0  // ReadFile into the worker's buffers (default)
+#define READMODE_MAPPED     1  // hash views of the file mapping, without copying
+#define READMODE_UNBUFFERED 2  // bypass the file cache, e.g. for scrubbing archives
+
+// Disk orders (the DiskOrder value, which has no UI either)
+#define DISKORDER_LISTED    0  // read files on hard disks in their listed order
+#define DISKORDER_PHYSICAL  1  // read them in the order they are laid out (default)
 
 // Public functions
 VOID __fastcall OptionsDialog( HWND hWndOwner, PHASHCHECKOPTIONS popt );
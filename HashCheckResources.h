@@ -65,3 +65,11 @@
 #define IDC_OPT_FONT_CHANGE             518
 #define IDC_OPT_FONT_PREVIEW            519
 #define IDC_OPT_LINK                    520
+#define IDC_OPT_CHK_BLAKE3              521
+#define IDC_OPT_CHK_XXH3_128            522
+#define IDC_OPT_CHK_K12                 523
+#define IDC_OPT_CHK_CRC32C              524
+#define IDC_OPT_CHK_BLAKE2B             525
+#define IDC_OPT_CHK_BLAKE2BP            526
+#define IDC_OPT_KERNELS_BOX             527
+#define IDC_OPT_KERNELS                 528
@@ -11,7 +11,9 @@
 #include "globals.h"
 #include "HashCheckCommon.h"
 #include "HashCalc.h"
+#include "StorageProfile.h"
 #include "libs/WinHash.h"
+#include "libs/WinHashDispatch.h"
 #include <Strsafe.h>
 #include <assert.h>
 
@@ -30,6 +32,7 @@
 
 // Worker thread
 VOID __fastcall HashPropWorkerMain( PHASHPROPCONTEXT phpctx );
+BOOL WINAPI HashPropProfileDevices( PHASHPROPCONTEXT phpctx );
 VOID WINAPI HashPropRestart( PHASHPROPCONTEXT phpctx );
 
 // Dialog general
@@ -112,13 +115,25 @@ VOID __fastcall HashPropWorkerMain( PHASHPROPCONTEXT phpctx )
 
 	// Which checksum types we want to calculate
     // (this is loaded earlier in HashPropDlgInit())
-    DWORD checksumFlags = (UINT8)phpctx->opt.dwChecksums;
+    DWORD checksumFlags = phpctx->opt.dwChecksums & WHEX_ALL;
 
     // Read buffer
     PBYTE pbBuffer = (PBYTE)VirtualAlloc(NULL, READ_BUFFER_SIZE, MEM_COMMIT, PAGE_READWRITE);
     if (pbBuffer == NULL)
         return;
 
+    // With more than one checksum type, large files are hashed by a pipeline
+    // with a thread per type (if it cannot be created, they're hashed inline)
+    PWHPIPE pPipe = NULL;
+    if (checksumFlags & (checksumFlags - 1))
+        pPipe = WHPipeCreate(checksumFlags, READ_BUFFER_SIZE);
+
+    // If every device handles concurrent reads well, large files may be hashed
+    // in concurrently read segments (the dialog may be updating dwFlags too,
+    // hence the interlocked OR)
+    if (HashPropProfileDevices(phpctx))
+        InterlockedOr((volatile LONG *)&phpctx->dwFlags, HCF_PARALLEL_SEGMENTS);
+
 #ifdef _TIMED
     DWORD dwStarted;
     dwStarted = GetTickCount();
@@ -137,7 +152,7 @@ VOID __fastcall HashPropWorkerMain( PHASHPROPCONTEXT phpctx )
 			pItem->szPath,
 			&whctx,
 			&pItem->results,
-			pbBuffer,
+			pbBuffer, pPipe,
 			NULL, 0, NULL, NULL
 #ifdef _TIMED
           , &pItem->dwElapsed
@@ -156,9 +171,80 @@ VOID __fastcall HashPropWorkerMain( PHASHPROPCONTEXT phpctx )
 #ifdef _TIMED
     phpctx->dwElapsed = GetTickCount() - dwStarted;
 #endif
+    if (pPipe)
+        WHPipeDestroy(pPipe);
     VirtualFree(pbBuffer, 0, MEM_RELEASE);
 }
 
+// Profiles each device the listed files are on with its largest file, which is
+// the most likely one to be large enough to be measured (a device is only
+// measured the first time it is seen); returns TRUE if every one of them
+// handles concurrent reads well
+BOOL WINAPI HashPropProfileDevices( PHASHPROPCONTEXT phpctx )
+{
+    #define HP_MAX_DEVICES 32
+
+    ULONGLONG aullDevices[HP_MAX_DEVICES];
+    PHASHPROPITEM apLargest[HP_MAX_DEVICES];
+    TCHAR szDir[MAX_PATH_BUFFER] = TEXT("");
+    PHASHPROPITEM pItem;
+    STORAGEPROFILE sp;
+    UINT cDevices = 0, iDevice = 0;
+    BOOL bConcurrent = TRUE;
+
+    SLReset(phpctx->hList);
+
+    while (pItem = SLGetDataAndStep(phpctx->hList))
+    {
+        PCTSTR pszName = StrRChr(pItem->szPath, NULL, TEXT('\\'));
+        SIZE_T cchDir = pszName ? pszName - pItem->szPath : 0;
+
+        // Files in the same directory as the previous one (which is usually
+        // the case) are on the same device
+        if (cchDir == 0 || cchDir >= countof(szDir) || szDir[cchDir] || StrCmpNI(pItem->szPath, szDir, (int)cchDir))
+        {
+            ULONGLONG ullDevice = StorageDeviceId(pItem->szPath);
+
+            if (cchDir < countof(szDir))
+            {
+                memcpy(szDir, pItem->szPath, cchDir * sizeof(TCHAR));
+                szDir[cchDir] = 0;
+            }
+
+            for (iDevice = 0; iDevice < cDevices && aullDevices[iDevice] != ullDevice; ++iDevice);
+
+            if (iDevice == cDevices)
+            {
+                // Too many devices to keep track of, so don't split files up
+                if (cDevices == HP_MAX_DEVICES)
+                {
+                    bConcurrent = FALSE;
+                    break;
+                }
+
+                aullDevices[cDevices] = ullDevice;
+                apLargest[cDevices++] = pItem;
+            }
+        }
+
+        if (pItem->cbSize > apLargest[iDevice]->cbSize)
+            apLargest[iDevice] = pItem;
+    }
+
+    SLReset(phpctx->hList);
+
+    for (iDevice = 0; iDevice < cDevices; ++iDevice)
+    {
+        StorageProfileGet(apLargest[iDevice]->szPath, &sp);
+        if (sp.cReaders <= 1)
+            bConcurrent = FALSE;
+    }
+
+    return(bConcurrent && cDevices);
+
+    #undef HP_MAX_DEVICES
+}
+
 
 
 /*============================================================================*\
@@ -716,8 +802,13 @@ VOID WINAPI HashPropFinalStatus( PHASHPROPCONTEXT phpctx )
 #ifndef _TIMED
 	SetDlgItemText(phpctx->hWnd, IDC_STATUSBOX, szBuffer3);
 #else
-    StringCchPrintf(szBuffer2, countof(szBuffer2), _T("%s in %d ms"), szBuffer3, phpctx->dwElapsed);
-    SetDlgItemText(phpctx->hWnd, IDC_STATUSBOX, szBuffer2);
+    {
+        // Also report which kernel variants were used
+        TCHAR szKernels[WHK_REPORT_LENGTH], szTimed[MAX_STRINGMSG + WHK_REPORT_LENGTH];
+        WHGetKernelReport(szKernels, countof(szKernels));
+        StringCchPrintf(szTimed, countof(szTimed), _T("%s in %d ms; %s"), szBuffer3, phpctx->dwElapsed, szKernels);
+        SetDlgItemText(phpctx->hWnd, IDC_STATUSBOX, szTimed);
+    }
 #endif
 
 	// Enable search controls
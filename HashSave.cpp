@@ -11,8 +11,9 @@
 #include "globals.h"
 #include "HashCheckCommon.h"
 #include "HashCalc.h"
+#include "libs/WinHashMB.h"
 #include "SetAppID.h"
-#include "IsSSD.h"
+#include "StorageProfile.h"
 #include <Strsafe.h>
 #include <vector>
 #include <cassert>
@@ -41,6 +42,8 @@ DWORD WINAPI HashSaveThread( PHASHSAVECONTEXT phsctx );
 
 // Worker thread
 VOID __fastcall HashSaveWorkerMain( PHASHSAVECONTEXT phsctx );
+PCTSTR WINAPI HashSaveBatchGetPath( PVOID pvParam, PVOID pvItem, PTSTR pszBuffer );
+VOID WINAPI HashSaveBatchDone( PVOID pvParam, PVOID pvItem, PWHRESULTEX pwhres, ULONGLONG cbFileSize );
 
 // Dialog general
 INT_PTR CALLBACK HashSaveDlgProc( HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam );
@@ -163,16 +166,52 @@ VOID __fastcall HashSaveWorkerMain( PHASHSAVECONTEXT phsctx )
     vecpItems.pop_back();
     assert(vecpItems.back() != nullptr);
 
+    // Group the files by the device they are on, and profile each device with
+    // its largest file, which is the most likely one to be large enough to be
+    // measured
+    auto get_path = [](PVOID pvItem, PTSTR) { return (PCTSTR)((PHASHSAVEITEM)pvItem)->szPath; };
+    auto get_size = [](PVOID pvItem) { return ((PHASHSAVEITEM)pvItem)->cbSize; };
+    std::vector<DEVICEQUEUE> queues;
+    BuildDeviceQueues(queues, (PVOID*)vecpItems.data(), vecpItems.size(), get_path, get_size);
+
+    // Files on hard disks are read in the order they are laid out on them
+    // (unless the DiskOrder option is off)
+    if (phsctx->dwFlags & HCF_DISK_ORDER)
+        SortDeviceQueues(queues, get_path);
+
+    // If every device handles concurrent reads well, large files may also be
+    // hashed in concurrently read segments (the dialog may be updating dwFlags
+    // too, hence the interlocked OR)
+    if (std::all_of(queues.cbegin(), queues.cend(), [](const DEVICEQUEUE& queue) { return queue.sp.cReaders > 1; }))
+        InterlockedOr((volatile LONG *)&phsctx->dwFlags, HCF_PARALLEL_SEGMENTS);
+
 #ifdef USE_PPL
-    const bool bMultithreaded = vecpItems.size() > 1 && IsSSD(vecpItems[0]->szPath);
+    const UINT cReaders = CountDeviceReaders(queues);
+    const bool bMultithreaded = vecpItems.size() > 1 && cReaders > 1;
     concurrency::concurrent_vector<void*> vecBuffers;  // a vector of all allocated read buffers (one per thread)
     DWORD dwBufferTlsIndex = TlsAlloc();               // TLS index of the current thread's read buffer
     if (dwBufferTlsIndex == TLS_OUT_OF_INDEXES)
         return;
+
+    // Run one thread per reader of every device (which may be more than there
+    // are processors when some of them are waiting on hard disks)
+    const bool bOwnScheduler = bMultithreaded && cReaders != g_cProcessors;
+    if (bOwnScheduler)
+        concurrency::CurrentScheduler::Create(concurrency::SchedulerPolicy(1, concurrency::MaxConcurrency, cReaders));
 #else
     constexpr bool bMultithreaded = false;
 #endif
 
+    // When multithreaded (so results are saved in completion order anyway),
+    // files on devices which handle concurrent reads well are hashed largest
+    // first, and small ones are set aside to be hashed in batches by a
+    // multi-buffer engine (if this processor has one for the selected
+    // algorithm) once there are no larger ones left to start
+    const UINT uAlgorithm = phsctx->ofn.nFilterIndex;
+    std::vector<PVOID> vecpBatched;
+    if (bMultithreaded)
+        SortDeviceQueuesBySize(queues, get_size, WHMBIsAvailable(uAlgorithm) ? &vecpBatched : NULL, MAX_BATCH_FILE_SIZE);
+
     PBYTE pbTheBuffer;  // file read buffer, used iff not multithreaded
     if (! bMultithreaded)
     {
@@ -181,6 +220,17 @@ VOID __fastcall HashSaveWorkerMain( PHASHSAVECONTEXT phsctx )
             return;
     }
 
+    // Indicate which hash type we are after, see WHEX... values in WinHash.h
+    const DWORD dwHashFlags = 1UL << (phsctx->ofn.nFilterIndex - 1);
+
+    // When files are hashed one at a time (e.g. from a single hard disk), more
+    // than one algorithm is run on the long-lived threads of a pipeline rather
+    // than on a task group built for every buffer (if it cannot be created,
+    // they're hashed inline)
+    PWHPIPE pPipe = NULL;
+    if (! bMultithreaded && (dwHashFlags & (dwHashFlags - 1)))
+        pPipe = WHPipeCreate(dwHashFlags, READ_BUFFER_SIZE);
+
     // Initialize the progress bar update synchronization vars
     CRITICAL_SECTION updateCritSec;
     volatile ULONGLONG cbCurrentMaxSize = 0;
@@ -190,17 +240,25 @@ VOID __fastcall HashSaveWorkerMain( PHASHSAVECONTEXT phsctx )
 #ifdef _TIMED
     DWORD dwStarted;
     dwStarted = GetTickCount();
+    volatile DWORD dwLastStarted = dwStarted;  // when the last file or batch was started
 #endif
 
     class CanceledException {};
 
+    // When not multithreaded, files are read device by device (and in physical
+    // order on hard disks), but their results are still saved in their listed
+    // order; this is the next one to be saved
+    size_t iNextWrite = 0;
+
     // concurrency::parallel_for_each(vecpItems.cbegin(), vecpItems.cend(), ...
     auto per_file_worker = [&](PHASHSAVEITEM pItem)
 	{
         WHCTXEX whctx;
+        whctx.dwFlags = dwHashFlags;
 
-        // Indicate which hash type we are after, see WHEX... values in WinHash.h
-        whctx.dwFlags = 1 << (phsctx->ofn.nFilterIndex - 1);
+#ifdef _TIMED
+        dwLastStarted = GetTickCount();
+#endif
 
         PBYTE pbBuffer;
 #ifdef USE_PPL
@@ -228,7 +286,7 @@ VOID __fastcall HashSaveWorkerMain( PHASHSAVECONTEXT phsctx )
 			pItem->szPath,
 			&whctx,
 			&pItem->results,
-            bMultithreaded ? pbBuffer : pbTheBuffer,
+            bMultithreaded ? pbBuffer : pbTheBuffer, pPipe,
 			NULL, 0,
             bMultithreaded ? &updateCritSec : NULL, &cbCurrentMaxSize
 #ifdef _TIMED
@@ -242,7 +300,14 @@ VOID __fastcall HashSaveWorkerMain( PHASHSAVECONTEXT phsctx )
             throw CanceledException();
 
 		// Write the data
-		HashCalcWriteResult(phsctx, pItem);
+        if (bMultithreaded)
+            HashCalcWriteResult(phsctx, pItem);
+        else
+        {
+            pItem->bHashed = TRUE;
+            for (; iNextWrite < vecpItems.size() && vecpItems[iNextWrite]->bHashed; ++iNextWrite)
+                HashCalcWriteResult(phsctx, vecpItems[iNextWrite]);
+        }
 
 		// Update the UI
 		InterlockedIncrement(&phsctx->cSentMsgs);
@@ -254,10 +319,39 @@ VOID __fastcall HashSaveWorkerMain( PHASHSAVECONTEXT phsctx )
     {
 #ifdef USE_PPL
         if (bMultithreaded)
-            concurrency::parallel_for_each(vecpItems.cbegin(), vecpItems.cend(), per_file_worker);
+        {
+            // Readers whose devices run out of files take on the batches, so
+            // that small files fill in around the last of the large ones
+            const LONG cBatches = (LONG)((vecpBatched.size() + BATCH_SIZE - 1) / BATCH_SIZE);
+            volatile LONG iNextBatch = 0;
+
+            RunDeviceQueues(queues, [&](PVOID pvItem) { per_file_worker((PHASHSAVEITEM)pvItem); }, [&]()
+            {
+                LONG iBatch;
+                while ((iBatch = InterlockedIncrement(&iNextBatch) - 1) < cBatches)
+                {
+#ifdef _TIMED
+                    dwLastStarted = GetTickCount();
+#endif
+                    PVOID* ppvItems = vecpBatched.data() + iBatch * BATCH_SIZE;
+                    UINT cDeferred = WorkerThreadHashBatch((PCOMMONCONTEXT)phsctx, uAlgorithm, ppvItems,
+                                                           (UINT)min((size_t)BATCH_SIZE, vecpBatched.size() - iBatch * BATCH_SIZE),
+                                                           HashSaveBatchGetPath, HashSaveBatchDone, phsctx);
+                    if (phsctx->status == CANCEL_REQUESTED)
+                        throw CanceledException();
+
+                    // Files which have grown too large since the directory walk,
+                    // or which could not be read whole in one go
+                    for (UINT i = 0; i < cDeferred; ++i)
+                        per_file_worker((PHASHSAVEITEM)ppvItems[i]);
+                }
+            });
+        }
         else
 #endif
-            std::for_each(vecpItems.cbegin(), vecpItems.cend(), per_file_worker);
+            for (const DEVICEQUEUE& queue : queues)
+                for (PVOID pvItem : queue.items)
+                    per_file_worker((PHASHSAVEITEM)pvItem);
     }
     catch (CanceledException) {}  // ignore cancellation requests
 
@@ -269,13 +363,19 @@ VOID __fastcall HashSaveWorkerMain( PHASHSAVECONTEXT phsctx )
             WCHAR szW[MAX_STRINGMSG];
         } buffer;
         size_t cbBufferLeft;
+        const DWORD dwFinished = GetTickCount();
+        const DWORD dwElapsed = dwFinished - dwStarted;
+        const UINT uFilesPerSec = (UINT)(phsctx->cTotal * 1000ULL / max(dwElapsed, 1UL));
+        // The tail is the time spent after the last file was started, while
+        // at least one thread had nothing left to do
+        const DWORD dwTail = dwFinished - dwLastStarted;
         if (phsctx->opt.dwSaveEncoding == 1)  // UTF-16
         {
-            StringCbPrintfExW(buffer.szW, sizeof(buffer), NULL, &cbBufferLeft, 0, L"; Total elapsed: %d ms\r\n", GetTickCount() - dwStarted);
+            StringCbPrintfExW(buffer.szW, sizeof(buffer), NULL, &cbBufferLeft, 0, L"; Total elapsed: %d ms (%u files/s), tail: %d ms\r\n", dwElapsed, uFilesPerSec, dwTail);
         }
         else                                  // UTF-8 or ANSI
         {
-            StringCbPrintfExA(buffer.szA, sizeof(buffer), NULL, &cbBufferLeft, 0,  "; Total elapsed: %d ms\r\n", GetTickCount() - dwStarted);
+            StringCbPrintfExA(buffer.szA, sizeof(buffer), NULL, &cbBufferLeft, 0,  "; Total elapsed: %d ms (%u files/s), tail: %d ms\r\n", dwElapsed, uFilesPerSec, dwTail);
         }
         DWORD dwUnused;
         WriteFile(phsctx->hFileOut, buffer.szA, (DWORD) (sizeof(buffer) - cbBufferLeft), &dwUnused, NULL);
@@ -288,10 +388,38 @@ VOID __fastcall HashSaveWorkerMain( PHASHSAVECONTEXT phsctx )
         for (void* pBuffer : vecBuffers)
             VirtualFree(pBuffer, 0, MEM_RELEASE);
         DeleteCriticalSection(&updateCritSec);
+        if (bOwnScheduler)
+            concurrency::CurrentScheduler::Detach();
     }
     else
 #endif
         VirtualFree(pbTheBuffer, 0, MEM_RELEASE);
+
+    if (pPipe)
+        WHPipeDestroy(pPipe);
+}
+
+PCTSTR WINAPI HashSaveBatchGetPath( PVOID pvParam, PVOID pvItem, PTSTR pszBuffer )
+{
+	return(((PHASHSAVEITEM)pvItem)->szPath);
+}
+
+VOID WINAPI HashSaveBatchDone( PVOID pvParam, PVOID pvItem, PWHRESULTEX pwhres, ULONGLONG cbFileSize )
+{
+	PHASHSAVECONTEXT phsctx = (PHASHSAVECONTEXT)pvParam;
+	PHASHSAVEITEM pItem = (PHASHSAVEITEM)pvItem;
+
+	pItem->results = *pwhres;
+#ifdef _TIMED
+	pItem->dwElapsed = 0;  // files in a batch are not timed individually
+#endif
+
+	// Write the data
+	HashCalcWriteResult(phsctx, pItem);
+
+	// Update the UI
+	InterlockedIncrement(&phsctx->cSentMsgs);
+	PostMessage(phsctx->hWnd, HM_WORKERTHREAD_UPDATE, (WPARAM)phsctx, (LPARAM)pItem);
 }
 
 
@@ -10,11 +10,13 @@
 
 #include "globals.h"
 #include "HashCheckCommon.h"
+#include "libs/WinHashMB.h"
 #include "SetAppID.h"
 #include "UnicodeHelpers.h"
-#include "IsSSD.h"
+#include "StorageProfile.h"
 #include <uxtheme.h>
 #include <Strsafe.h>
+#include <vector>
 #include <cassert>
 #include <algorithm>
 #ifdef USE_PPL
@@ -112,6 +114,12 @@ typedef struct {
 	TCHAR              szStatus[4][MAX_STRINGRES];
 } HASHVERIFYCONTEXT, *PHASHVERIFYCONTEXT;
 
+// Parameter for the WorkerThreadHashBatch callbacks
+typedef struct {
+	PHASHVERIFYCONTEXT phvctx;
+	SIZE_T             cchPathPrefix;
+} HASHVERIFYBATCH, *PHASHVERIFYBATCH;
+
 
 
 /*============================================================================*\
@@ -125,6 +133,10 @@ BOOL WINAPI ValidateHexSequence( PTSTR psz, UINT cch );
 
 // Worker thread
 VOID __fastcall HashVerifyWorkerMain( PHASHVERIFYCONTEXT phvctx );
+VOID WINAPI HashVerifyBuildPath( PHASHVERIFYCONTEXT phvctx, PHASHVERIFYITEM pItem, SIZE_T cchPathPrefix, PTSTR pszPath );
+VOID WINAPI HashVerifySetResult( PHASHVERIFYCONTEXT phvctx, PHASHVERIFYITEM pItem, PWHRESULTEX pwhres );
+PCTSTR WINAPI HashVerifyBatchGetPath( PVOID pvParam, PVOID pvItem, PTSTR pszBuffer );
+VOID WINAPI HashVerifyBatchDone( PVOID pvParam, PVOID pvItem, PWHRESULTEX pwhres, ULONGLONG cbFileSize );
 
 // Dialog general
 INT_PTR CALLBACK HashVerifyDlgProc( HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam );
@@ -365,13 +377,13 @@ VOID WINAPI HashVerifyParseData( PHASHVERIFYCONTEXT phvctx )
 				if (ValidateHexSequence(pszStartOfLine, 8))
 				{
 					cchChecksum = 8;
-					phvctx->whctxFlags = WHEX_ALL32;  // WHEX_CHECKCRC32
+					phvctx->whctxFlags = WHEX_ALL32;  // WHEX_CHECKCRC32 | WHEX_CHECKCRC32C
 				}
 				// 128-bit algorithms (32-byte)
 				else if (ValidateHexSequence(pszStartOfLine, 32))
 				{
 					cchChecksum = 32;
-					phvctx->whctxFlags = WHEX_ALL128;  // WHEX_CHECKMD5
+					phvctx->whctxFlags = WHEX_ALL128;  // WHEX_CHECKMD5 | WHEX_CHECKXXH3_128
 				}
 				// 160-bit algorithms (40-byte)
 				else if (ValidateHexSequence(pszStartOfLine, 40))
@@ -383,13 +395,13 @@ VOID WINAPI HashVerifyParseData( PHASHVERIFYCONTEXT phvctx )
 				else if (ValidateHexSequence(pszStartOfLine, 64))
 				{
 					cchChecksum = 64;
-					phvctx->whctxFlags = WHEX_ALL256;  // WHEX_CHECKSHA256 | WHEX_CHECKSHA3_256
+					phvctx->whctxFlags = WHEX_ALL256;  // WHEX_CHECKSHA256 | WHEX_CHECKSHA3_256 | WHEX_CHECKBLAKE3 | WHEX_CHECKK12
 				}
 				// 512-bit algorithms (128-byte)
 				else if (ValidateHexSequence(pszStartOfLine, 128))
 				{
 					cchChecksum = 128;
-					phvctx->whctxFlags = WHEX_ALL512;  // WHEX_CHECKSHA512 | WHEX_CHECKSHA3_512
+					phvctx->whctxFlags = WHEX_ALL512;  // WHEX_CHECKSHA512 | WHEX_CHECKSHA3_512 | WHEX_CHECKBLAKE2B | WHEX_CHECKBLAKE2BP
 				}
 			}
 
@@ -458,27 +470,10 @@ BOOL WINAPI ValidateHexSequence( PTSTR psz, UINT cch )
 	// Check that the given hex string matches /[0-9A-Fa-f]{cch}\b/, and if it
 	// does, convert to lower-case and NULL-terminate it.
 
-	while (cch)
-	{
-		TCHAR ch = *psz;
-
-		if (ch < TEXT('0'))
-		{
-			return(FALSE);
-		}
-		else if (ch > TEXT('9'))
-		{
-			ch |= 0x20; // Convert to lower-case
-
-			if (ch < TEXT('a') || ch > TEXT('f'))
-				return(FALSE);
+	if (!WHValidateHex(psz, cch))
+		return(FALSE);
 
-			*psz = ch;
-		}
-
-		++psz;
-		--cch;
-	}
+	psz += cch;
 
 	if (*psz == 0 || *psz == TEXT('\n') || *psz == TEXT(' '))
 	{
@@ -504,23 +499,70 @@ VOID __fastcall HashVerifyWorkerMain( PHASHVERIFYCONTEXT phvctx )
 	PTSTR pszPathTail = StrRChr(phvctx->pszPath, NULL, TEXT('\\'));
 	SIZE_T cchPathPrefix = (pszPathTail) ? pszPathTail + 1 - phvctx->pszPath : 0;
 
+    auto get_path = [&](PVOID pvItem, PTSTR pszPath) -> PCTSTR
+    {
+        HashVerifyBuildPath(phvctx, (PHASHVERIFYITEM)pvItem, cchPathPrefix, pszPath);
+        return(pszPath);
+    };
+
+    // Look up the sizes of the files first (missing files are as quickly done
+    // with as empty ones), by their original index
+    std::vector<ULONGLONG> vecSizes(phvctx->cTotal);
+    for (UINT i = 0; i < phvctx->cTotal; ++i)
+    {
+        TCHAR szPath[MAX_PATH_BUFFER];
+        WIN32_FILE_ATTRIBUTE_DATA fad;
+
+        if (phvctx->status == CANCEL_REQUESTED)
+            return;
+
+        if (GetFileAttributesEx(get_path(phvctx->index[i], szPath), GetFileExInfoStandard, &fad))
+            vecSizes[phvctx->index[i]->nListviewIndex] = (ULONGLONG)fad.nFileSizeHigh << 32 | fad.nFileSizeLow;
+    }
+    auto get_size = [&](PVOID pvItem) { return vecSizes[((PHASHVERIFYITEM)pvItem)->nListviewIndex]; };
+
+    // Group the files by the device they are on, and profile each device with
+    // its largest file, which is the most likely one to be large enough to be
+    // measured
+    std::vector<DEVICEQUEUE> queues;
+    BuildDeviceQueues(queues, (PVOID*)phvctx->index, phvctx->cTotal, get_path, get_size);
+
+    // Files on hard disks are read in the order they are laid out on them,
+    // unless the DiskOrder option is off (the list still shows them in their
+    // listed order)
+    if (phvctx->dwFlags & HCF_DISK_ORDER)
+        SortDeviceQueues(queues, get_path);
+
+    // If every device handles concurrent reads well, large files may also be
+    // hashed in concurrently read segments (the dialog may be updating dwFlags
+    // too, hence the interlocked OR)
+    if (std::all_of(queues.cbegin(), queues.cend(), [](const DEVICEQUEUE& queue) { return queue.sp.cReaders > 1; }))
+        InterlockedOr((volatile LONG *)&phvctx->dwFlags, HCF_PARALLEL_SEGMENTS);
+
 #ifdef USE_PPL
-    // If the first file has an absolute path, use it for IsSSD(),
-    // otherwise use the checksum file itself
-    const bool bMultithreaded = phvctx->cTotal > 1 && IsSSD(
-        phvctx->index[0]->pszDisplayName[0] == TEXT('\\') ||
-        phvctx->index[0]->pszDisplayName[1] == TEXT(':') ?
-        phvctx->index[0]->pszDisplayName :
-        phvctx->pszPath);
+    const UINT cReaders = CountDeviceReaders(queues);
+    const bool bMultithreaded = phvctx->cTotal > 1 && cReaders > 1;
 
     concurrency::concurrent_vector<void*> vecBuffers;  // a vector of all allocated read buffers (one per thread)
     DWORD dwBufferTlsIndex = TlsAlloc();               // TLS index of the current thread's read buffer
     if (dwBufferTlsIndex == TLS_OUT_OF_INDEXES)
         return;
+
+    // Run one thread per reader of every device (which may be more than there
+    // are processors when some of them are waiting on hard disks)
+    const bool bOwnScheduler = bMultithreaded && cReaders != g_cProcessors;
+    if (bOwnScheduler)
+        concurrency::CurrentScheduler::Create(concurrency::SchedulerPolicy(1, concurrency::MaxConcurrency, cReaders));
 #else
     constexpr bool bMultithreaded = false;
 #endif
 
+    // A file is checked with more than one algorithm only when its digest
+    // length is ambiguous; if files are being read by more than one reader,
+    // they are verified in parallel, so each file's algorithms share a thread
+    if (bMultithreaded)
+        InterlockedOr((volatile LONG *)&phvctx->dwFlags, HCF_SERIAL_UPDATES);
+
     PBYTE pbTheBuffer;  // filename/read buffer, used iff not multithreaded
     if (! bMultithreaded)
     {
@@ -529,12 +571,41 @@ VOID __fastcall HashVerifyWorkerMain( PHASHVERIFYCONTEXT phvctx )
             return;
     }
 
+    // When files are hashed one at a time (e.g. from a single hard disk), the
+    // algorithms of an ambiguous digest length are run on the long-lived
+    // threads of a pipeline rather than on a task group built for every
+    // buffer (if it cannot be created, they're hashed inline)
+    PWHPIPE pPipe = NULL;
+    if (! bMultithreaded && (phvctx->whctxFlags & (phvctx->whctxFlags - 1)))
+        pPipe = WHPipeCreate(phvctx->whctxFlags, READ_BUFFER_SIZE);
+
     // Initialize the progress bar update synchronization vars
     CRITICAL_SECTION updateCritSec;
     volatile ULONGLONG cbCurrentMaxSize = 0;
     if (bMultithreaded)
         InitializeCriticalSection(&updateCritSec);
 
+	// When multithreaded, files on devices which handle concurrent reads well
+	// are hashed largest first; if only one
+	// algorithm is being checked for which this processor has a multi-buffer
+	// engine, small ones are set aside to be hashed in batches once there are
+	// no larger ones left to start, and any which have grown since then are
+	// handed back by the batch as too large for it
+	UINT uAlgorithm = 0;
+	std::vector<PVOID> vecpBatched;
+	if (bMultithreaded)
+	{
+#define HASH_VERIFY_BATCH_ALG_op(alg)                  \
+		if (phvctx->whctxFlags == WHEX_CHECK##alg)     \
+			uAlgorithm = alg;
+		FOR_EACH_HASH(HASH_VERIFY_BATCH_ALG_op)
+
+		if (uAlgorithm && ! WHMBIsAvailable(uAlgorithm))
+			uAlgorithm = 0;
+
+		SortDeviceQueuesBySize(queues, get_size, uAlgorithm ? &vecpBatched : NULL, MAX_BATCH_FILE_SIZE);
+	}
+
 	// We need to keep track of the thread's execution time so that we can do a
 	// sound notification of completion when appropriate
 	phvctx->dwStarted = GetTickCount();
@@ -565,22 +636,7 @@ VOID __fastcall HashVerifyWorkerMain( PHASHVERIFYCONTEXT phvctx )
             pbBuffer = pbTheBuffer;
 
 		// Part 1: Build the path
-		{
-			SIZE_T cchPrefix = cchPathPrefix;
-
-			// Do not use the prefix if pszDisplayName is an absolute path
-			if ( pItem->pszDisplayName[0] == TEXT('\\') ||
-			     pItem->pszDisplayName[1] == TEXT(':') )
-			{
-				cchPrefix = 0;
-			}
-
-			SSChainNCpy2(
-                (PTSTR)pbBuffer,
-				phvctx->pszPath, cchPrefix,
-				pItem->pszDisplayName, pItem->cchDisplayName
-			);
-		}
+		HashVerifyBuildPath(phvctx, pItem, cchPathPrefix, (PTSTR)pbBuffer);
 
 		// Part 2: Calculate the checksum(s)
         WHCTXEX whctx;
@@ -592,7 +648,7 @@ VOID __fastcall HashVerifyWorkerMain( PHASHVERIFYCONTEXT phvctx )
             (PTSTR)pbBuffer,
 			&whctx,
 			&whres,
-            pbBuffer,
+            pbBuffer, pPipe,
 			&pItem->filesize,
             pItem->nListviewIndex,
             bMultithreaded ? &updateCritSec : NULL, &cbCurrentMaxSize
@@ -606,61 +662,48 @@ VOID __fastcall HashVerifyWorkerMain( PHASHVERIFYCONTEXT phvctx )
 		if (phvctx->status == CANCEL_REQUESTED)
             throw CanceledException();
 
-		// Part 3: Do something with the results
-		if (whres.dwFlags)
-		{
-            UINT cHashes = 0;
-            DWORD dwMatched = 0;
-            PTSTR pszActual = NULL;
-
-#define HASH_VERIFY_ONE_HASH_op(alg)                                  \
-            if (whres.dwFlags & WHEX_CHECK##alg)                      \
-            {                                                         \
-                cHashes++;                                            \
-                if (! dwMatched)                                      \
-                {                                                     \
-                    pszActual = whres.szHex##alg;                     \
-                    if (StrCmpI(pItem->pszExpected, pszActual) == 0)  \
-                        dwMatched = WHEX_CHECK##alg;                  \
-                }                                                     \
-            }
-            FOR_EACH_HASH(HASH_VERIFY_ONE_HASH_op)
-
-            assert(cHashes > 0);  // should always be true since whres.dwFlags > 0
-            assert(pszActual);
-            if (dwMatched)
-            {
-                pItem->uStatusID = HV_STATUS_MATCH;
-                
-                StringCbCopy(pItem->szActual, sizeof(pItem->szActual), pszActual);
-                if (cHashes > 1 && phvctx->whctxFlags != dwMatched)
-                    phvctx->whctxFlags = dwMatched;
-            }
-            else
-            {
-                pItem->uStatusID = HV_STATUS_MISMATCH;
-                if (cHashes == 1)
-                    StringCbCopy(pItem->szActual, sizeof(pItem->szActual), pszActual);
-            }
-		}
-		else
-		{
-			pItem->uStatusID = HV_STATUS_UNREADABLE;
-		}
-
-		// Part 4: Update the UI
-		++phvctx->cSentMsgs;
-		PostMessage(phvctx->hWnd, HM_WORKERTHREAD_UPDATE, (WPARAM)phvctx, (LPARAM)pItem);
+		// Part 3: Do something with the results, and update the UI
+		HashVerifySetResult(phvctx, pItem, &whres);
     };
 
     try
     {
 #ifdef USE_PPL
         if (bMultithreaded)
-            concurrency::parallel_for_each(phvctx->index, phvctx->index + phvctx->cTotal, per_file_worker);
+        {
+            HASHVERIFYBATCH batch = { phvctx, cchPathPrefix };
+
+            // Readers whose devices run out of files take on the batches, so
+            // that small files fill in around the last of the large ones
+            const LONG cBatches = (LONG)((vecpBatched.size() + BATCH_SIZE - 1) / BATCH_SIZE);
+            volatile LONG iNextBatch = 0;
+
+            RunDeviceQueues(queues, [&](PVOID pvItem) { per_file_worker((PHASHVERIFYITEM)pvItem); }, [&]()
+            {
+                LONG iBatch;
+                while ((iBatch = InterlockedIncrement(&iNextBatch) - 1) < cBatches)
+                {
+                    // A copy of the index, so the batch may reorder them
+                    PVOID* apvItems = vecpBatched.data() + iBatch * BATCH_SIZE;
+                    UINT cItems = (UINT)min((size_t)BATCH_SIZE, vecpBatched.size() - iBatch * BATCH_SIZE);
+
+                    UINT cDeferred = WorkerThreadHashBatch((PCOMMONCONTEXT)phvctx, uAlgorithm, apvItems, cItems,
+                                                           HashVerifyBatchGetPath, HashVerifyBatchDone, &batch);
+                    if (phvctx->status == CANCEL_REQUESTED)
+                        throw CanceledException();
+
+                    // Files which are too large for a lane (only now is their size known),
+                    // or which could not be read whole in one go
+                    for (UINT i = 0; i < cDeferred; ++i)
+                        per_file_worker((PHASHVERIFYITEM)apvItems[i]);
+                }
+            });
+        }
         else
 #endif
-            std::for_each(phvctx->index, phvctx->index + phvctx->cTotal, per_file_worker);
+            for (const DEVICEQUEUE& queue : queues)
+                for (PVOID pvItem : queue.items)
+                    per_file_worker((PHASHVERIFYITEM)pvItem);
     }
     catch (CanceledException) {}  // ignore cancellation requests
 
@@ -670,17 +713,109 @@ VOID __fastcall HashVerifyWorkerMain( PHASHVERIFYCONTEXT phvctx )
         for (void* pBuffer : vecBuffers)
             VirtualFree(pBuffer, 0, MEM_RELEASE);
         DeleteCriticalSection(&updateCritSec);
+        if (bOwnScheduler)
+            concurrency::CurrentScheduler::Detach();
     }
     else
 #endif
         VirtualFree(pbTheBuffer, 0, MEM_RELEASE);
 
+    if (pPipe)
+        WHPipeDestroy(pPipe);
+
 	// Play a sound to signal the normal, successful termination of operations,
 	// but exempt operations that were nearly instantaneous
 	if (phvctx->cTotal && GetTickCount() - phvctx->dwStarted >= 2000)
 		MessageBeep(MB_ICONASTERISK);
 }
 
+VOID WINAPI HashVerifyBuildPath( PHASHVERIFYCONTEXT phvctx, PHASHVERIFYITEM pItem, SIZE_T cchPathPrefix, PTSTR pszPath )
+{
+	// Do not use the prefix if pszDisplayName is an absolute path
+	if ( pItem->pszDisplayName[0] == TEXT('\\') ||
+	     pItem->pszDisplayName[1] == TEXT(':') )
+	{
+		cchPathPrefix = 0;
+	}
+
+	SSChainNCpy2(
+		pszPath,
+		phvctx->pszPath, cchPathPrefix,
+		pItem->pszDisplayName, pItem->cchDisplayName
+	);
+}
+
+VOID WINAPI HashVerifySetResult( PHASHVERIFYCONTEXT phvctx, PHASHVERIFYITEM pItem, PWHRESULTEX pwhres )
+{
+	if (pwhres->dwFlags)
+	{
+		UINT cHashes = 0;
+		DWORD dwMatched = 0;
+		PTSTR pszActual = NULL;
+
+#define HASH_VERIFY_ONE_HASH_op(alg)                                  \
+		if (pwhres->dwFlags & WHEX_CHECK##alg)                        \
+		{                                                             \
+			cHashes++;                                                \
+			if (! dwMatched)                                          \
+			{                                                         \
+				pszActual = pwhres->szHex##alg;                       \
+				if (StrCmpI(pItem->pszExpected, pszActual) == 0)      \
+					dwMatched = WHEX_CHECK##alg;                      \
+			}                                                         \
+		}
+		FOR_EACH_HASH(HASH_VERIFY_ONE_HASH_op)
+
+		assert(cHashes > 0);  // should always be true since pwhres->dwFlags > 0
+		assert(pszActual);
+		if (dwMatched)
+		{
+			pItem->uStatusID = HV_STATUS_MATCH;
+
+			StringCbCopy(pItem->szActual, sizeof(pItem->szActual), pszActual);
+			if (cHashes > 1 && phvctx->whctxFlags != dwMatched)
+				phvctx->whctxFlags = dwMatched;
+		}
+		else
+		{
+			pItem->uStatusID = HV_STATUS_MISMATCH;
+			if (cHashes == 1)
+				StringCbCopy(pItem->szActual, sizeof(pItem->szActual), pszActual);
+		}
+	}
+	else
+	{
+		pItem->uStatusID = HV_STATUS_UNREADABLE;
+	}
+
+	// Update the UI
+	++phvctx->cSentMsgs;
+	PostMessage(phvctx->hWnd, HM_WORKERTHREAD_UPDATE, (WPARAM)phvctx, (LPARAM)pItem);
+}
+
+PCTSTR WINAPI HashVerifyBatchGetPath( PVOID pvParam, PVOID pvItem, PTSTR pszBuffer )
+{
+	PHASHVERIFYBATCH pbatch = (PHASHVERIFYBATCH)pvParam;
+
+	HashVerifyBuildPath(pbatch->phvctx, (PHASHVERIFYITEM)pvItem, pbatch->cchPathPrefix, pszBuffer);
+	return(pszBuffer);
+}
+
+VOID WINAPI HashVerifyBatchDone( PVOID pvParam, PVOID pvItem, PWHRESULTEX pwhres, ULONGLONG cbFileSize )
+{
+	PHASHVERIFYBATCH pbatch = (PHASHVERIFYBATCH)pvParam;
+	PHASHVERIFYITEM pItem = (PHASHVERIFYITEM)pvItem;
+
+	// As set by WorkerThreadHashFile (small files never need a SETSIZE message)
+	if (pwhres->dwFlags)
+	{
+		pItem->filesize.ui64 = cbFileSize;
+		StrFormatKBSize(cbFileSize, pItem->filesize.sz, countof(pItem->filesize.sz));
+	}
+
+	HashVerifySetResult(pbatch->phvctx, pItem, pwhres);
+}
+
 
 
 /*============================================================================*\
@@ -1,24 +0,0 @@
-/**
-* IsSSD function
-* Copyright (C) 2016 Christopher Gurnee.  All rights reserved.
-*
-* Please refer to readme.txt for information about this source code.
-* Please refer to license.txt for details about distribution and modification.
-**/
-
-#ifndef __ISSSD_H__
-#define __ISSSD_H__
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-#include <windows.h>
-
-BOOL IsSSD(LPCWCH lpszPath);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif
@@ -0,0 +1,490 @@
+/**
+* Storage profiling
+* Last modified: 2026/10/18
+*
+* Please refer to readme.txt for information about this source code.
+* Please refer to license.txt for details about distribution and modification.
+*
+* The seek penalty query is adapted from IsSSD.c, which is copyright (C) 2016
+* Christopher Gurnee; credit for it goes to hatenablog.com user NyaRuRu,
+* originally from: http://nyaruru.hatenablog.com/entry/2012/09/29/063829
+**/
+
+#include "globals.h"
+#include "StorageProfile.h"
+#include "HashCheckCommon.h"
+#include "libs/SimpleString.h"
+#include <Strsafe.h>
+
+// Probe parameters
+#define PROBE_MIN_FILE_SIZE   0x1000000  // smallest file worth probing (16M)
+#define PROBE_SEQ_SIZE        0x800000   // bytes read sequentially (8M)
+#define PROBE_SEQ_DEPTH       4          // reads in flight while reading sequentially
+#define PROBE_BLOCK_SIZE      0x1000     // size of each random read (4K)
+#define PROBE_MAX_DEPTH       16
+#define PROBE_SEEK_PENALTY_US 2000       // random reads slower than this are seeks
+
+// Random reads are made at each of these queue depths (this many at a time)
+static const UINT c_acDepths[SP_NUM_DEPTHS] = { 1, 4, 16 };
+static const UINT c_acReads[SP_NUM_DEPTHS]  = { 32, 64, 128 };
+
+// Measured profiles, and the devices of volumes, are cached for the lifetime
+// of the process
+#define PROFILE_CACHE_SIZE    16
+#define VOLUME_CACHE_SIZE     32
+
+static STORAGEPROFILE s_profiles[PROFILE_CACHE_SIZE];
+static UINT s_cProfiles;
+
+static struct {
+	TCHAR     szVolume[MAX_PATH];
+	ULONGLONG ullDevice;
+} s_volumes[VOLUME_CACHE_SIZE];
+static UINT s_cVolumes;
+
+static volatile LONG s_lCacheLock;
+
+static VOID WINAPI CacheLock( )
+{
+	while (InterlockedExchange(&s_lCacheLock, 1))
+		Sleep(0);
+}
+
+static VOID WINAPI CacheUnlock( )
+{
+	InterlockedExchange(&s_lCacheLock, 0);
+}
+
+// Opens the physical drive which holds (the first extent of) the volume on
+// which the given file resides, and optionally returns its number
+static HANDLE WINAPI OpenPhysicalDrive( PCTSTR pszPath, PDWORD pdwDisk )
+{
+    TCHAR szMountPoint[MAX_PATH];
+    if (! GetVolumePathName(pszPath, szMountPoint, MAX_PATH))
+        return(INVALID_HANDLE_VALUE);
+
+    TCHAR szVolumeGUID[MAX_PATH];
+    if (! GetVolumeNameForVolumeMountPoint(szMountPoint, szVolumeGUID, MAX_PATH))
+        return(INVALID_HANDLE_VALUE);
+
+    // Remove any trailing backslash
+    size_t cchVolumeGUIDLen;
+    StringCchLength(szVolumeGUID, MAX_PATH, &cchVolumeGUIDLen);
+    if (szVolumeGUID[cchVolumeGUIDLen - 1] == '\\')
+        szVolumeGUID[cchVolumeGUIDLen - 1] = '\0';
+
+    HANDLE hVolume = CreateFile(
+        szVolumeGUID,
+        FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL);
+    if (hVolume == INVALID_HANDLE_VALUE)
+        return(INVALID_HANDLE_VALUE);
+
+    // There could be multiple extents on which this path resides; this checks only the first
+    VOLUME_DISK_EXTENTS vde;
+    DWORD cbIoControlReturned;
+    if (! DeviceIoControl(
+          hVolume,
+          IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS,
+          NULL,
+          0,
+          &vde,
+          sizeof(vde),
+          &cbIoControlReturned,
+          NULL))
+    {
+        CloseHandle(hVolume);
+        return(INVALID_HANDLE_VALUE);
+    }
+
+    CloseHandle(hVolume);
+
+    TCHAR szPhysicalDrivePath[MAX_PATH];
+    static const TCHAR szPhysicalDrivePrefix[] = TEXT("\\\\.\\PhysicalDrive");
+    SSStaticCpy(szPhysicalDrivePath, szPhysicalDrivePrefix);
+
+    StringCchPrintf(
+        szPhysicalDrivePath + countof(szPhysicalDrivePrefix) - 1,
+        MAX_PATH - countof(szPhysicalDrivePrefix),
+        TEXT("%d"),
+        vde.Extents[0].DiskNumber);
+
+    if (pdwDisk)
+        *pdwDisk = vde.Extents[0].DiskNumber;
+
+    return(CreateFile(
+        szPhysicalDrivePath,
+        FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL));
+}
+
+// Tries to determine if the given file is stored on a device with a slow seek
+// time; errs on the side of a seek penalty
+static BOOL WINAPI HasSeekPenalty( PCTSTR pszPath )
+{
+    HANDLE hPhysicalDrive = OpenPhysicalDrive(pszPath, NULL);
+    if (hPhysicalDrive == INVALID_HANDLE_VALUE)
+        return(TRUE);
+
+    STORAGE_PROPERTY_QUERY spq;
+    spq.PropertyId = StorageDeviceSeekPenaltyProperty;
+    spq.QueryType  = PropertyStandardQuery;
+    DEVICE_SEEK_PENALTY_DESCRIPTOR dspd;
+    DWORD cbIoControlReturned;
+    if (! DeviceIoControl(
+          hPhysicalDrive,
+          IOCTL_STORAGE_QUERY_PROPERTY,
+          &spq,
+          sizeof(spq),
+          &dspd,
+          sizeof(dspd),
+          &cbIoControlReturned,
+          NULL))
+    {
+        CloseHandle(hPhysicalDrive);
+        return(TRUE);
+    }
+
+    CloseHandle(hPhysicalDrive);
+
+    return(dspd.IncursSeekPenalty ? TRUE : FALSE);
+}
+
+ULONGLONG WINAPI StorageDeviceId( PCTSTR pszPath )
+{
+	TCHAR szVolume[MAX_PATH];
+	HANDLE hPhysicalDrive;
+	ULONGLONG ullDevice = 0;
+	DWORD dwDisk, dwSerial;
+	UINT i;
+
+	if (! GetVolumePathName(pszPath, szVolume, MAX_PATH))
+		return(0);
+
+	CacheLock();
+	for (i = 0; i < min(s_cVolumes, VOLUME_CACHE_SIZE); ++i)
+	{
+		if (StrCmpI(s_volumes[i].szVolume, szVolume) == 0)
+		{
+			ullDevice = s_volumes[i].ullDevice;
+			break;
+		}
+	}
+	CacheUnlock();
+
+	if (ullDevice)
+		return(ullDevice);
+
+	// Its physical drive if there is one, else the volume (e.g. for network shares)
+	if ((hPhysicalDrive = OpenPhysicalDrive(szVolume, &dwDisk)) != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(hPhysicalDrive);
+		ullDevice = (1ULL << 32) | dwDisk;
+	}
+	else if (GetVolumeInformation(szVolume, NULL, 0, &dwSerial, NULL, NULL, NULL, 0))
+	{
+		ullDevice = (2ULL << 32) | dwSerial;
+	}
+	else
+	{
+		return(0);
+	}
+
+	CacheLock();
+	i = s_cVolumes++ % VOLUME_CACHE_SIZE;
+	SSStaticCpy(s_volumes[i].szVolume, szVolume);
+	s_volumes[i].ullDevice = ullDevice;
+	CacheUnlock();
+
+	return(ullDevice);
+}
+
+// Reads cReads blocks of cbBlock bytes with up to cDepth of them in flight at
+// a time, either sequentially from the start of the file or (if puSeed is not
+// NULL) at random among its first cBlocks blocks; returns the elapsed time in
+// performance counter ticks, or 0 if any of the reads failed
+static LONGLONG WINAPI ProbeReads( HANDLE hFile, PBYTE pbBuffer, UINT cbBlock, UINT cDepth,
+                                   UINT cReads, ULONGLONG cBlocks, PUINT32 puSeed )
+{
+	OVERLAPPED aov[PROBE_MAX_DEPTH];
+	HANDLE ahEvents[PROBE_MAX_DEPTH];
+	BOOL abPending[PROBE_MAX_DEPTH];
+	LARGE_INTEGER liStart, liEnd;
+	UINT cIssued = 0, cDone = 0, i;
+	DWORD cbRead;
+	BOOL bFailed = FALSE;
+
+	for (i = 0; i < cDepth; ++i)
+	{
+		if (! (ahEvents[i] = CreateEvent(NULL, TRUE, FALSE, NULL)))
+		{
+			while (i--)
+				CloseHandle(ahEvents[i]);
+			return(0);
+		}
+		abPending[i] = FALSE;
+	}
+
+	QueryPerformanceCounter(&liStart);
+
+	while (cDone < cReads && !bFailed)
+	{
+		// Keep every slot busy for as long as there are reads left to make
+		for (i = 0; i < cDepth && cIssued < cReads; ++i)
+		{
+			ULONGLONG ibOffset;
+
+			if (abPending[i])
+				continue;
+
+			if (puSeed)
+			{
+				// xorshift32
+				*puSeed ^= *puSeed << 13;
+				*puSeed ^= *puSeed >> 17;
+				*puSeed ^= *puSeed << 5;
+				ibOffset = (*puSeed % cBlocks) * cbBlock;
+			}
+			else
+			{
+				ibOffset = (ULONGLONG)cIssued * cbBlock;
+			}
+
+			ZeroMemory(&aov[i], sizeof(OVERLAPPED));
+			aov[i].Offset = (DWORD)ibOffset;
+			aov[i].OffsetHigh = (DWORD)(ibOffset >> 32);
+			aov[i].hEvent = ahEvents[i];
+
+			if ( !ReadFile(hFile, pbBuffer + i * cbBlock, cbBlock, NULL, &aov[i]) &&
+			     GetLastError() != ERROR_IO_PENDING )
+			{
+				bFailed = TRUE;
+				break;
+			}
+
+			abPending[i] = TRUE;
+			++cIssued;
+		}
+
+		if (bFailed)
+			break;
+
+		// Wait for any one of them; the events of idle slots are left reset
+		i = WaitForMultipleObjects(cDepth, ahEvents, FALSE, INFINITE) - WAIT_OBJECT_0;
+		if (i >= cDepth)
+			break;
+
+		abPending[i] = FALSE;
+		ResetEvent(ahEvents[i]);
+
+		if (!GetOverlappedResult(hFile, &aov[i], &cbRead, FALSE) || cbRead != cbBlock)
+			bFailed = TRUE;
+		else
+			++cDone;
+	}
+
+	QueryPerformanceCounter(&liEnd);
+
+	// Nothing may be left in flight once this returns
+	CancelIo(hFile);
+
+	for (i = 0; i < cDepth; ++i)
+	{
+		if (abPending[i])
+			GetOverlappedResult(hFile, &aov[i], &cbRead, TRUE);
+
+		CloseHandle(ahEvents[i]);
+	}
+
+	return(cDone == cReads ? max(liEnd.QuadPart - liStart.QuadPart, 1) : 0);
+}
+
+// Measures the device holding an open unbuffered, overlapped file of at least
+// PROBE_MIN_FILE_SIZE bytes; returns FALSE if any of the probes failed
+static BOOL WINAPI ProbeDevice( HANDLE hFile, ULONGLONG cbFileSize, PSTORAGEPROFILE psp )
+{
+	LARGE_INTEGER liFrequency;
+	LONGLONG llTicks, llIOPS[SP_NUM_DEPTHS];
+	UINT32 uSeed = GetTickCount() | 1;
+	PBYTE pbBuffer;
+	UINT i;
+
+	// Large enough for the sequential reads, and page-aligned
+	if (! (pbBuffer = (PBYTE)VirtualAlloc(NULL, READ_BUFFER_SIZE * PROBE_SEQ_DEPTH, MEM_COMMIT, PAGE_READWRITE)))
+		return(FALSE);
+
+	QueryPerformanceFrequency(&liFrequency);
+
+	if (! (llTicks = ProbeReads(hFile, pbBuffer, READ_BUFFER_SIZE, PROBE_SEQ_DEPTH,
+	                            PROBE_SEQ_SIZE / READ_BUFFER_SIZE, 0, NULL)))
+		goto failed;
+
+	psp->uSeqMBps = (UINT)(PROBE_SEQ_SIZE * liFrequency.QuadPart / llTicks >> 20);
+
+	for (i = 0; i < SP_NUM_DEPTHS; ++i)
+	{
+		if (! (llTicks = ProbeReads(hFile, pbBuffer, PROBE_BLOCK_SIZE, c_acDepths[i],
+		                            c_acReads[i], cbFileSize / PROBE_BLOCK_SIZE, &uSeed)))
+			goto failed;
+
+		// Each read was waited on by c_acDepths[i] - 1 others on average
+		psp->auLatencyUs[i] = (UINT)(llTicks * 1000000 * c_acDepths[i] / c_acReads[i] / liFrequency.QuadPart);
+		llIOPS[i] = c_acReads[i] * liFrequency.QuadPart / llTicks;
+
+		// A device that seeks only gets busier with deeper queues; the one
+		// reader it is going to get has been measured
+		if (i == 0 && psp->auLatencyUs[0] > PROBE_SEEK_PENALTY_US)
+		{
+			psp->dwFlags |= SPF_SEEK_PENALTY;
+			break;
+		}
+	}
+
+	// More readers are only worth it while they make the device go faster
+	psp->cReaders = 1;
+	if (!(psp->dwFlags & SPF_SEEK_PENALTY))
+	{
+		for (i = 1; i < SP_NUM_DEPTHS && llIOPS[i] * 2 >= llIOPS[i - 1] * 3; ++i)
+			psp->cReaders = c_acDepths[i];
+	}
+
+	psp->dwFlags |= SPF_MEASURED;
+	VirtualFree(pbBuffer, 0, MEM_RELEASE);
+	return(TRUE);
+
+failed:
+	VirtualFree(pbBuffer, 0, MEM_RELEASE);
+	return(FALSE);
+}
+
+VOID WINAPI StorageProfileGet( PCTSTR pszPath, PSTORAGEPROFILE psp )
+{
+	HANDLE hFile;
+	ULONGLONG cbFileSize;
+	UINT i;
+
+	ZeroMemory(psp, sizeof(STORAGEPROFILE));
+	psp->ullDevice = StorageDeviceId(pszPath);
+
+	hFile = CreateFile(
+		pszPath,
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED,
+		NULL
+	);
+
+	if (hFile != INVALID_HANDLE_VALUE)
+	{
+		// Use a previous measurement of the same device
+		if (psp->ullDevice)
+		{
+			CacheLock();
+			for (i = 0; i < min(s_cProfiles, PROFILE_CACHE_SIZE); ++i)
+			{
+				if (s_profiles[i].ullDevice == psp->ullDevice)
+				{
+					*psp = s_profiles[i];
+					break;
+				}
+			}
+			CacheUnlock();
+		}
+
+		if ( !(psp->dwFlags & SPF_MEASURED) &&
+		     GetFileSizeEx(hFile, (PLARGE_INTEGER)&cbFileSize) && cbFileSize >= PROBE_MIN_FILE_SIZE &&
+		     ProbeDevice(hFile, cbFileSize, psp) && psp->ullDevice )
+		{
+			CacheLock();
+			s_profiles[s_cProfiles++ % PROFILE_CACHE_SIZE] = *psp;
+			CacheUnlock();
+		}
+
+		CloseHandle(hFile);
+	}
+
+	// Without a measurement (e.g. if the file is too small for one), fall back
+	// to asking the device whether it has a seek penalty
+	if (!(psp->dwFlags & SPF_MEASURED))
+	{
+		ULONGLONG ullDevice = psp->ullDevice;
+
+		ZeroMemory(psp, sizeof(STORAGEPROFILE));
+		psp->ullDevice = ullDevice;
+		psp->cReaders = 1;
+
+		if (HasSeekPenalty(pszPath))
+			psp->dwFlags |= SPF_SEEK_PENALTY;
+		else
+			psp->cReaders = PROBE_MAX_DEPTH;
+	}
+
+	// Each file being hashed has one read in flight (more for a file which is
+	// read in concurrent segments), so there is no point in hashing more
+	// files at once than the device has good use for reads
+	psp->cThreads = min(psp->cReaders, g_cProcessors);
+
+#ifdef FORCE_PPL
+	psp->dwFlags &= ~SPF_SEEK_PENALTY;
+	psp->cReaders = PROBE_MAX_DEPTH;
+	psp->cThreads = g_cProcessors;
+#endif
+}
+
+VOID WINAPI StoragePositionGet( PCTSTR pszPath, PSTORAGEPOSITION pspos )
+{
+	BY_HANDLE_FILE_INFORMATION bhfi;
+	STARTING_VCN_INPUT_BUFFER svib;
+	RETRIEVAL_POINTERS_BUFFER rpb;
+	DWORD cbReturned;
+	HANDLE hFile;
+
+	ZeroMemory(pspos, sizeof(STORAGEPOSITION));
+	pspos->dwKind = SPK_UNKNOWN;
+
+	// Neither query needs any access to the file's data
+	hFile = CreateFile(
+		pszPath,
+		FILE_READ_ATTRIBUTES,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		NULL
+	);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		return;
+
+	if (GetFileInformationByHandle(hFile, &bhfi))
+	{
+		pspos->dwVolume = bhfi.dwVolumeSerialNumber;
+		pspos->dwKind = SPK_INDEX;
+		pspos->ullOffset = (ULONGLONG)bhfi.nFileIndexHigh << 32 | bhfi.nFileIndexLow;
+
+		// Only the first extent is needed, so ERROR_MORE_DATA is expected;
+		// files which are resident, empty, or whose start is sparse or
+		// compressed away have no cluster to go by, and keep their file index
+		svib.StartingVcn.QuadPart = 0;
+		if ( ( DeviceIoControl(hFile, FSCTL_GET_RETRIEVAL_POINTERS, &svib, sizeof(svib),
+		                       &rpb, sizeof(rpb), &cbReturned, NULL) ||
+		       GetLastError() == ERROR_MORE_DATA ) &&
+		     rpb.ExtentCount && rpb.Extents[0].Lcn.QuadPart != -1 )
+		{
+			pspos->dwKind = SPK_EXTENT;
+			pspos->ullOffset = rpb.Extents[0].Lcn.QuadPart;
+		}
+	}
+
+	CloseHandle(hFile);
+}
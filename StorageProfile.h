@@ -0,0 +1,265 @@
+/**
+* Storage profiling
+* Last modified: 2026/10/18
+*
+* Please refer to readme.txt for information about this source code.
+* Please refer to license.txt for details about distribution and modification.
+**/
+
+#ifndef __STORAGEPROFILE_H__
+#define __STORAGEPROFILE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <windows.h>
+
+// Profile flags
+#define SPF_MEASURED      0x0001  // the profile was measured (else it was guessed)
+#define SPF_SEEK_PENALTY  0x0002  // random reads are far slower than sequential ones
+
+// Queue depths at which random-read latency is measured
+#define SP_NUM_DEPTHS     3       // 1, 4 and 16
+
+typedef struct {
+	ULONGLONG ullDevice;                 // identifies the device (disk or volume) the profile is for
+	DWORD     dwFlags;                   // SPF_* flags
+	UINT      cReaders;                  // number of concurrent reads which the device handles well
+	UINT      cThreads;                  // number of files worth hashing at once
+	UINT      uSeqMBps;                  // sequential bandwidth, in MB/s (0 if not measured)
+	UINT      auLatencyUs[SP_NUM_DEPTHS];// mean 4K random-read latency at each queue depth, in us
+} STORAGEPROFILE, *PSTORAGEPROFILE;
+
+// Position kinds, in the order in which they are read
+#define SPK_INDEX         0       // no extent of its own (e.g. stored in the MFT), so ordered by file index
+#define SPK_EXTENT        1       // ordered by the first cluster of its first extent
+#define SPK_UNKNOWN       2       // the file could not be opened
+
+typedef struct {
+	DWORD     dwVolume;                  // serial number of the volume the file resides on
+	DWORD     dwKind;                    // SPK_* value
+	ULONGLONG ullOffset;                 // logical cluster number or file index, depending on dwKind
+} STORAGEPOSITION, *PSTORAGEPOSITION;
+
+// Identifies the device which holds the given file (0 if it is unknown); files
+// on different volumes of the same physical drive have the same device
+ULONGLONG WINAPI StorageDeviceId( PCTSTR pszPath );
+
+// Fills in the profile of the device which holds the given file; the device is
+// probed with a quick series of unbuffered reads of the file the first time it
+// is seen (if the file is large enough), else the profile is guessed from
+// whether or not the device has a seek penalty
+VOID WINAPI StorageProfileGet( PCTSTR pszPath, PSTORAGEPROFILE psp );
+
+// Fills in where on its volume the start of the given file resides, for
+// ordering reads from a device with a seek penalty
+VOID WINAPI StoragePositionGet( PCTSTR pszPath, PSTORAGEPOSITION pspos );
+
+// Compares two positions, qsort-style
+__forceinline int StoragePositionCompare( const STORAGEPOSITION *psposA, const STORAGEPOSITION *psposB )
+{
+	if (psposA->dwVolume != psposB->dwVolume)
+		return(psposA->dwVolume < psposB->dwVolume ? -1 : 1);
+	if (psposA->dwKind != psposB->dwKind)
+		return(psposA->dwKind < psposB->dwKind ? -1 : 1);
+	if (psposA->ullOffset != psposB->ullOffset)
+		return(psposA->ullOffset < psposB->ullOffset ? -1 : 1);
+	return(0);
+}
+
+#ifdef __cplusplus
+}
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <shlwapi.h>
+#include "HashCheckCommon.h"
+#ifdef USE_PPL
+#include <ppl.h>
+#endif
+
+// The files of a job which reside on one device, in their original order
+struct DEVICEQUEUE {
+	ULONGLONG          ullDevice;
+	STORAGEPROFILE     sp;
+	std::vector<PVOID> items;
+	UINT               cReaders; // readers to run (no more than it had items when built)
+	volatile LONG      iNext;    // index of the next item to be taken by a reader
+};
+
+// Groups items by the device they reside on, and profiles each device using
+// its largest file according to getSize; getPath(pvItem, pszBuffer) returns
+// the path of an item (and may build it in the MAX_PATH_BUFFER-sized
+// pszBuffer), and getSize returns its size (or 0 if it is not known, in which
+// case a device may be profiled with a file too small to be measured)
+template <typename GETPATH, typename GETSIZE>
+VOID BuildDeviceQueues( std::vector<DEVICEQUEUE>& queues, PVOID *ppvItems, SIZE_T cItems,
+                        GETPATH getPath, GETSIZE getSize )
+{
+	TCHAR szPath[MAX_PATH_BUFFER], szDir[MAX_PATH_BUFFER] = TEXT("");
+	std::vector<PVOID> vecpLargest;
+	ULONGLONG ullDevice = 0;
+	SIZE_T iQueue = 0;
+
+	for (SIZE_T iItem = 0; iItem < cItems; ++iItem)
+	{
+		PCTSTR pszPath = getPath(ppvItems[iItem], szPath);
+		PCTSTR pszName = StrRChr(pszPath, NULL, TEXT('\\'));
+		SIZE_T cchDir = pszName ? pszName - pszPath : 0;
+
+		// Files in the same directory as the previous one (which is usually
+		// the case) are on the same device
+		if (cchDir == 0 || cchDir >= countof(szDir) || szDir[cchDir] || StrCmpNI(pszPath, szDir, (int)cchDir))
+		{
+			if (cchDir < countof(szDir))
+			{
+				memcpy(szDir, pszPath, cchDir * sizeof(TCHAR));
+				szDir[cchDir] = 0;
+			}
+
+			ullDevice = StorageDeviceId(pszPath);
+
+			for (iQueue = 0; iQueue < queues.size() && queues[iQueue].ullDevice != ullDevice; ++iQueue);
+
+			if (iQueue == queues.size())
+			{
+				queues.emplace_back();
+				queues.back().ullDevice = ullDevice;
+				queues.back().iNext = 0;
+				vecpLargest.push_back(ppvItems[iItem]);
+			}
+		}
+
+		queues[iQueue].items.push_back(ppvItems[iItem]);
+
+		if (getSize(ppvItems[iItem]) > getSize(vecpLargest[iQueue]))
+			vecpLargest[iQueue] = ppvItems[iItem];
+	}
+
+	for (iQueue = 0; iQueue < queues.size(); ++iQueue)
+	{
+		StorageProfileGet(getPath(vecpLargest[iQueue], szPath), &queues[iQueue].sp);
+		queues[iQueue].cReaders = (UINT)min((SIZE_T)queues[iQueue].sp.cThreads, queues[iQueue].items.size());
+	}
+}
+
+// Reorders the items of each device which has a seek penalty by where they
+// reside on it, so that it is swept through once instead of seeking for most
+// every file; getPath is as for BuildDeviceQueues
+template <typename GETPATH>
+VOID SortDeviceQueues( std::vector<DEVICEQUEUE>& queues, GETPATH getPath )
+{
+	TCHAR szPath[MAX_PATH_BUFFER];
+	std::vector<std::pair<STORAGEPOSITION, PVOID>> vecPositions;
+
+	for (DEVICEQUEUE& queue : queues)
+	{
+		if (!(queue.sp.dwFlags & SPF_SEEK_PENALTY) || queue.items.size() < 2)
+			continue;
+
+		vecPositions.resize(queue.items.size());
+		for (SIZE_T i = 0; i < queue.items.size(); ++i)
+		{
+			StoragePositionGet(getPath(queue.items[i], szPath), &vecPositions[i].first);
+			vecPositions[i].second = queue.items[i];
+		}
+
+		std::stable_sort(vecPositions.begin(), vecPositions.end(),
+			[](const std::pair<STORAGEPOSITION, PVOID>& a, const std::pair<STORAGEPOSITION, PVOID>& b)
+			{ return StoragePositionCompare(&a.first, &b.first) < 0; });
+
+		for (SIZE_T i = 0; i < queue.items.size(); ++i)
+			queue.items[i] = vecPositions[i].second;
+	}
+}
+
+// Reorders the items of each device which has more than one reader largest
+// first, so that no reader is left hashing a large file long after the others
+// have run out of work; if pvecpSmall is not NULL, the items of at most
+// cbSmall bytes are instead moved out to it (in their original order)
+template <typename GETSIZE>
+VOID SortDeviceQueuesBySize( std::vector<DEVICEQUEUE>& queues, GETSIZE getSize,
+                             std::vector<PVOID> *pvecpSmall, ULONGLONG cbSmall )
+{
+	std::vector<std::pair<ULONGLONG, PVOID>> vecSizes;
+
+	for (DEVICEQUEUE& queue : queues)
+	{
+		if (queue.cReaders < 2)
+			continue;
+
+		vecSizes.clear();
+		for (PVOID pvItem : queue.items)
+		{
+			ULONGLONG cbSize = getSize(pvItem);
+
+			if (pvecpSmall && cbSize <= cbSmall)
+				pvecpSmall->push_back(pvItem);
+			else
+				vecSizes.emplace_back(cbSize, pvItem);
+		}
+
+		std::stable_sort(vecSizes.begin(), vecSizes.end(),
+			[](const std::pair<ULONGLONG, PVOID>& a, const std::pair<ULONGLONG, PVOID>& b)
+			{ return a.first > b.first; });
+
+		queue.items.resize(vecSizes.size());
+		for (SIZE_T i = 0; i < vecSizes.size(); ++i)
+			queue.items[i] = vecSizes[i].second;
+	}
+}
+
+// The total number of readers which the devices have good use for
+inline UINT CountDeviceReaders( const std::vector<DEVICEQUEUE>& queues )
+{
+	UINT cReaders = 0;
+
+	for (const DEVICEQUEUE& queue : queues)
+		cReaders += queue.cReaders;
+
+	return(cReaders);
+}
+
+#ifdef USE_PPL
+// Runs worker(pvItem) on every item, with a reader per thread that each device
+// has good use for, and each reader taking the next of its device's items in
+// order; a device with a single reader (e.g. a hard disk) is thus read from
+// strictly sequentially, while all of the devices are read at the same time;
+// each reader calls tail() once its device has run out of items, which may
+// take on work of its own (such as batches of small files); every reader is a
+// task of its own (unlike with parallel_for_each, which may run several of them
+// one after the other on a thread), so given a scheduler with a thread per
+// reader, no device waits on another's reads
+template <typename WORKER, typename TAIL>
+VOID RunDeviceQueues( std::vector<DEVICEQUEUE>& queues, WORKER worker, TAIL tail )
+{
+	concurrency::task_group readers;
+
+	for (DEVICEQUEUE& queue : queues)
+	{
+		DEVICEQUEUE* pQueue = &queue;
+		pQueue->iNext = 0;
+
+		for (UINT iReader = 0; iReader < pQueue->cReaders; ++iReader)
+		{
+			readers.run([&, pQueue]
+			{
+				LONG iItem;
+
+				while ((iItem = InterlockedIncrement(&pQueue->iNext) - 1) < (LONG)pQueue->items.size())
+					worker(pQueue->items[iItem]);
+
+				tail();
+			});
+		}
+	}
+
+	readers.wait();
+}
+#endif
+
+#endif
+
+#endif
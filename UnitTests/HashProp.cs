@@ -129,6 +129,12 @@ namespace UnitTests
  SHA-512: ae4b5efe9d7e301699dc03ec1bc1f60f83565be9a40d8e38c660a7f9463b22b1ed907f9f4024c9d0ba30c9c38ac12d8cc354d8c4539e63dd6f26a0ce9ce7b71a
 SHA3-256: aae3e14fd718aed758574f170c23a2f172a3690587340aa3c5c8d538ebd66bd4
 SHA3-512: 2620b58e343e8a80e091405b65ced686c58c3996854e092d01202dc91598d596aea148131c77513a4ae7f509800abcdb363c45864ef2e291206cd56775ff3e46
+  BLAKE3: 2935c6c742773c1101fc96af14427d764da67f6d18e2a68375913e3a7d6e020b
+XXH3-128: 9fb58db9dcee88bad6cdee9fb5e8229d
+     K12: f25138976e3bdfe16e2c8c8edc5c72725b6ce22375deabb8d21da0cb6d1f59f2
+ CRC-32C: 3d7d4737
+ BLAKE2b: e1b3550d64cc3773e3418ddb1bef7cfe08dd519efcf49181e45f645ce950bdc0b89d11866a65ed87929a1aa807e00b1b1f670c1e4924f9f899cd5ea40ac4f462
+BLAKE2bp: 131fc85bf2f6a85f526c074f5ac538829cd6f19f63e6a26bda60ebfbcf1cf9c497a71cae6f17adb83ed838ea69783fa67a75c192da38f2fccd8a978105c47233
 " + "\n")]
         [InlineData(
          "SHA3_VeryLongMsg.dat", true,
@@ -146,6 +152,12 @@ SHA3-512: 2620b58e343e8a80e091405b65ced686c58c3996854e092d01202dc91598d596aea148
  SHA-512: 421b072b4fda96eb569ae55b8a9a5b4b5073a623649bd409dbb999e527372994b3a1a91f53c719837868c7fe11bba67640143255a3fbc5c895d2119274b0caff
 SHA3-256: 6a934f386ff779e33a1068c5f3e4c5c0a117968be4264b8f80ec511a1c0b6eed
 SHA3-512: d11fbca35e2383481bd99253a289c035e7a98a36507e4feabf8151fc51e6d77c2f737c4bd747362896ab61df2c066e6a27e7fa2f5bf645b54d98e07e135c4870
+  BLAKE3: 16f33ae7c66473c590a6665a7b974d172636c188ef79800075878ce6dbda0bf5
+XXH3-128: 60d4770e13a72e4ca7a5b02d690649cb
+     K12: 5b725542cfb25af25db487a4725d2551288b9e310956b7d423d30ff29a96e800
+ CRC-32C: b8b40055
+ BLAKE2b: 17af1a7c5b03859de92a455d9094aa6cdb92d6b199115dce558a3f5c9f8d030ca3e239fc253a27b5c72b5f6029775ed5d15d00246586bbaa8fb1b4302c9a8ca4
+BLAKE2bp: ba5581c4cc889955ca00b78d0f685da947a7169df4a16b4a1d99bde6ab3e4f555eb3e64c4b67caf35b9457487a9363139dc90f36305854fffd25eeb168ddd63a
 " + "\n")]
         // BUG: only works for the English translation
         public void HashesTest(string name, bool interrupt, string def_expected_results, string full_expected_results)
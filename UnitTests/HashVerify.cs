@@ -75,10 +75,27 @@ namespace UnitTests
         [InlineData("SHA3_512LongMsg.rsp.sha3-512",  IDC_MATCH_RESULTS)]
         [InlineData("hashcheck.md5",                 IDC_MATCH_RESULTS)]
         [InlineData("hashcheck.sha1",                IDC_MATCH_RESULTS)]
+        [InlineData("BLAKE3.b3",                     IDC_MATCH_RESULTS)]
+        [InlineData("XXH3_128.xxh128",               IDC_MATCH_RESULTS)]
+        [InlineData("K12.k12",                       IDC_MATCH_RESULTS)]
+        [InlineData("CRC32C.crc32c",                 IDC_MATCH_RESULTS)]
+        [InlineData("BLAKE2b.b2",                    IDC_MATCH_RESULTS)]
+        [InlineData("BLAKE2bp.b2bp",                 IDC_MATCH_RESULTS)]
         //
         // tests for disambiguating vectors of the same bit length
         [InlineData("SHA256ShortMsg.rsp.asc",        IDC_MATCH_RESULTS)]
         [InlineData("SHA3_256ShortMsg.rsp.asc",      IDC_MATCH_RESULTS)]
+        [InlineData("BLAKE3.asc",                    IDC_MATCH_RESULTS)]
+        [InlineData("XXH3_128.asc",                  IDC_MATCH_RESULTS)]
+        [InlineData("K12.asc",                       IDC_MATCH_RESULTS)]
+        [InlineData("CRC32C.asc",                    IDC_MATCH_RESULTS)]
+        [InlineData("BLAKE2b.asc",                   IDC_MATCH_RESULTS)]
+        [InlineData("BLAKE2bp.asc",                  IDC_MATCH_RESULTS)]
+        //
+        // the last line is shorter than the digests it is probed for, with no
+        // newline after it (hex validation must not read past its terminator)
+        [InlineData("shortline.sha256",              IDC_MATCH_RESULTS)]
+        [InlineData("shortline.asc",                 IDC_MATCH_RESULTS)]
         //
         // negative tests
         [InlineData(@"mismatch.sha256",              IDC_MISMATCH_RESULTS)]
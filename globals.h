@@ -39,6 +39,9 @@ extern HANDLE g_hActCtx;
 // Major and minor Windows version
 extern UINT16 g_uWinVer;
 
+// Number of logical processors
+extern UINT g_cProcessors;
+
 // Define the data and strings used for COM registration
 static const GUID CLSID_HashCheck = { 0x705977c7, 0x86cb, 0x4743, { 0xbf, 0xaf, 0x69, 0x08, 0xbd, 0x19, 0xb7, 0xb0 } };
 #define CLSID_STR_HashCheck         TEXT("{705977C7-86CB-4743-BFAF-6908BD19B7B0}")
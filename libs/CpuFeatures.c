@@ -0,0 +1,75 @@
+/**
+ * CPU Feature Detection
+ * Last modified: 2026/10/18
+ **/
+
+#include "CpuFeatures.h"
+#include <intrin.h>
+#include <immintrin.h>
+
+static volatile UINT32 g_uCpuFeatures;
+
+static UINT32 CPUAPI ProbeCpuFeatures( )
+{
+	int regs[4];  // EAX, EBX, ECX, EDX
+	int nMaxLeaf;
+	UINT32 uFeatures = CPUF_PROBED;
+	UINT64 uXCR0 = 0;
+
+	__cpuid(regs, 0);
+	nMaxLeaf = regs[0];
+
+	if (nMaxLeaf < 1)
+		return(uFeatures);
+
+	__cpuid(regs, 1);
+
+	if (regs[3] & (1 << 26)) uFeatures |= CPUF_SSE2;
+	if (regs[2] & (1 <<  9)) uFeatures |= CPUF_SSSE3;
+	if (regs[2] & (1 << 19)) uFeatures |= CPUF_SSE41;
+	if (regs[2] & (1 << 20)) uFeatures |= CPUF_SSE42;
+	if (regs[2] & (1 <<  1)) uFeatures |= CPUF_PCLMUL;
+
+	// The AVX family is only usable if the OS saves the extended state (OSXSAVE)
+	if (regs[2] & (1 << 27))
+		uXCR0 = _xgetbv(0);
+
+	if ((regs[2] & (1 << 28)) && (uXCR0 & 0x06) == 0x06)
+		uFeatures |= CPUF_AVX;
+
+	if (nMaxLeaf >= 7)
+	{
+		__cpuidex(regs, 7, 0);
+
+		if (regs[1] & (1 << 29) && (uFeatures & (CPUF_SSSE3 | CPUF_SSE41)) == (CPUF_SSSE3 | CPUF_SSE41))
+			uFeatures |= CPUF_SHA;
+
+		if (regs[1] & (1 <<  8)) uFeatures |= CPUF_BMI2;
+
+		if (uFeatures & CPUF_AVX)
+		{
+			if (regs[1] & (1 << 5)) uFeatures |= CPUF_AVX2;
+
+			// Opmask, ZMM0-15 upper halves, and ZMM16-31 must all be OS-enabled
+			if ((regs[1] & (1 << 16)) && (uXCR0 & 0xE6) == 0xE6)
+			{
+				uFeatures |= CPUF_AVX512F;
+				if (regs[1] & (1UL << 31)) uFeatures |= CPUF_AVX512VL;
+				if (regs[1] & (1 << 30)) uFeatures |= CPUF_AVX512BW;
+			}
+		}
+	}
+
+	return(uFeatures);
+}
+
+UINT32 CPUAPI GetCpuFeatures( )
+{
+	UINT32 uFeatures = g_uCpuFeatures;
+
+	// Racing threads will all compute the same value, so no locking is needed
+	if (!uFeatures)
+		g_uCpuFeatures = uFeatures = ProbeCpuFeatures();
+
+	return(uFeatures);
+}
@@ -0,0 +1,45 @@
+/**
+ * CPU Feature Detection
+ * Last modified: 2026/10/18
+ *
+ * Queries CPUID (and XGETBV, for the OS-enabled register state) once, and
+ * caches the result so that the hashing libraries can cheaply select the
+ * fastest transform supported by the processor that they are running on.
+ **/
+
+#ifndef __CPUFEATURES_H__
+#define __CPUFEATURES_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <windows.h>
+
+#define CPUAPI __fastcall
+
+// Feature flags returned by GetCpuFeatures
+#define CPUF_SSE2       0x00000001
+#define CPUF_SSSE3      0x00000002
+#define CPUF_SSE41      0x00000004
+#define CPUF_SSE42      0x00000008
+#define CPUF_PCLMUL     0x00000010
+#define CPUF_AVX        0x00000020  // includes OS support for the YMM state
+#define CPUF_AVX2       0x00000040
+#define CPUF_BMI2       0x00000080
+#define CPUF_SHA        0x00000100  // SHA-NI (sha1rnds4, sha256rnds2, ...)
+#define CPUF_AVX512F    0x00000200  // includes OS support for the ZMM state
+#define CPUF_AVX512VL   0x00000400
+#define CPUF_AVX512BW   0x00000800
+#define CPUF_PROBED     0x80000000  // internal: set once CPUID has been queried
+
+UINT32 CPUAPI GetCpuFeatures( );
+
+// TRUE only if every one of the requested CPUF_* flags is supported
+#define HasCpuFeatures(f) ((GetCpuFeatures() & (f)) == (f))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,14 +1,16 @@
 /**
  * Windows Hashing/Checksumming Library
- * Last modified: 2016/02/21
+ * Last modified: 2026/10/18
  * Original work copyright (C) Kai Liu.  All rights reserved.
  * Modified work copyright (C) 2014, 2016 Christopher Gurnee.  All rights reserved.
  * Modified work copyright (C) 2016 Tim Schlueter.  All rights reserved.
  *
- * This is a wrapper for the CRC32, MD5, SHA1, SHA2-256, and SHA2-512
- * algorithms.
+ * This is a wrapper for the CRC32, MD5, SHA1, SHA2-256, SHA2-512, SHA3-256,
+ * SHA3-512, BLAKE3, XXH3-128, KangarooTwelve, CRC32C, BLAKE2b, and BLAKE2bp
+ * algorithms, which also updates the MD5/SHA1 and SHA2-256/CRC32 pairs with
+ * their stitched kernels when both of a pair are requested.
  *
- * WinHash.cpp is needed only if the WH*To* or WH*Ex functions are used.
+ * WinHash.cpp is needed only if the WH*Ex functions are used.
  **/
 
 #include "WinHash.h"
@@ -26,90 +28,76 @@ LPCTSTR g_szHashExtsTab[NUM_HASHES + 1] = {
 };
 
 /**
- * WH*To* hex string conversion functions
+ * Fused multi-algorithm update
+ *
+ * Rather than streaming the whole buffer through the cache once for each
+ * algorithm, it is walked in L1-sized tiles which are fed to every enabled
+ * algorithm in turn.  A copy is instantiated for each of the commonly used
+ * combinations of flags, so that the flag tests are resolved at compile time;
+ * any other combination uses the copy which tests the context's flags (once
+ * per tile, which costs next to nothing compared to hashing the tile).
+ *
+ * The pairs of algorithms that are often requested together and that have
+ * stitched kernels (see stitched.c) are updated together.
  **/
 
-BOOL WHAPI WHHexToByte( PTSTR pszSrc, PBYTE pbDest, UINT cchHex )
-{
-	while (cchHex)
-	{
-		BYTE hex = LOBYTE(*pszSrc);
-
-		// The high byte of UTF-16 text should always be zero
-		if (sizeof(TCHAR) == 2 && HIBYTE(*pszSrc))
-			return(FALSE);
-
-		// Now convert the hex character into a 4-bit nybble
-		if (hex < '0')
-		{
-			return(FALSE);
-		}
-		else if (hex > TEXT('9'))
-		{
-			// Ensure that this is lower-case
-			hex |= 0x20;
-
-			// The x86-64 compiler will allocate registers inefficiently if
-			// these two comparisons are joined with an logical OR
-			if (hex < 'a') return(FALSE);
-			if (hex > 'f') return(FALSE);
-
-			hex -= 'a' - 10;
-		}
-		else
-		{
-			hex -= '0';
-		}
-
-		// Save to the resulting byte array
-		if (!(cchHex & 1))
-		{
-			*pbDest = hex << 4;
-		}
-		else
-		{
-			*pbDest |= hex;
-			++pbDest;
-		}
-
-		++pszSrc;
-		--cchHex;
-	}
-
-	return(TRUE);
-}
-
-PTSTR WHAPI WHByteToHex( PBYTE pbSrc, PTSTR pszDest, UINT cchHex, UINT8 uCaseMode )
-{
-	while (cchHex)
-	{
-		BYTE hex = *pbSrc;
-
-		if (!(cchHex & 1))
-			hex >>= 4;
-		else
-			++pbSrc;
-
-		hex &= 0x0F;
-		hex |= 0x30;
-
-		if (hex > '9')
-		{
-			hex += 'A' - ('0' + 10);
-			hex |= uCaseMode;
-		}
-
-		*pszDest = hex;
+#define WH_FUSED_TILE_SIZE 0x4000  // a multiple of every block length except SHA3's and K12's
 
-		++pszDest;
-		--cchHex;
-	}
+// K12 hashes four whole leaves at a time with AVX2, so it gets larger tiles
+#define WH_FUSED_TILE_SIZE_K12 (K12_CHUNK_LENGTH * 4)
 
-	*pszDest = 0;
+typedef VOID (WHAPI *PFNWHUPDATEFUSED)( PWHCTXEX pContext, PCBYTE pbIn, UINT cbIn );
 
-	return(pszDest);
+template <DWORD dwStatic>
+static VOID WHAPI WHUpdateFused( PWHCTXEX pContext, PCBYTE pbIn, UINT cbIn )
+{
+    const DWORD dwFlags = dwStatic ? dwStatic : pContext->dwFlags;
+    const UINT cbTileMax = (dwFlags & WHEX_CHECKK12) ? WH_FUSED_TILE_SIZE_K12 : WH_FUSED_TILE_SIZE;
+    const BOOL bMD5SHA1 = (dwFlags & WH_STITCH_MD5SHA1) == WH_STITCH_MD5SHA1;
+    const BOOL bSHA256CRC32 = (dwFlags & WH_STITCH_SHA256CRC32) == WH_STITCH_SHA256CRC32;
+    DWORD dwSeparate = dwFlags;
+
+    if (bMD5SHA1)
+        dwSeparate &= ~WH_STITCH_MD5SHA1;
+    if (bSHA256CRC32)
+        dwSeparate &= ~WH_STITCH_SHA256CRC32;
+
+    while (cbIn)
+    {
+        UINT cbTile = (cbIn < cbTileMax) ? cbIn : cbTileMax;
+
+        if (bMD5SHA1)
+            MD5SHA1Update(&pContext->ctxMD5, &pContext->ctxSHA1, pbIn, cbTile);
+        if (bSHA256CRC32)
+            SHA256CRC32Update(&pContext->ctxSHA256, &pContext->ctxCRC32.state, pbIn, cbTile);
+
+#define WIN_HASH_UPDATE_TILE_op(alg)  \
+        if (dwSeparate & WHEX_CHECK##alg)  \
+            WHUpdate##alg(&pContext->ctx##alg, pbIn, cbTile);
+        FOR_EACH_HASH(WIN_HASH_UPDATE_TILE_op)
+
+        pbIn += cbTile;
+        cbIn -= cbTile;
+    }
 }
 
+// The default selection, the classic CRC-32/MD5/SHA-1 trio, and the stitched
+// pairs with and without a companion
+#define WH_FUSED_COPY(flags) { (flags), WHUpdateFused<(flags)> }
+
+static const struct {
+    DWORD            dwFlags;
+    PFNWHUPDATEFUSED pfn;
+} c_aFusedCopies[] = {
+    WH_FUSED_COPY(DEFAULT_HASH_ALGORITHMS),
+    WH_FUSED_COPY(WHEX_CHECKCRC32 | WHEX_CHECKMD5 | WHEX_CHECKSHA1),
+    WH_FUSED_COPY(WH_STITCH_MD5SHA1),
+    WH_FUSED_COPY(WH_STITCH_MD5SHA1 | WHEX_CHECKSHA256),
+    WH_FUSED_COPY(WH_STITCH_SHA256CRC32),
+    WH_FUSED_COPY(WH_STITCH_SHA256CRC32 | WHEX_CHECKSHA1),
+    WH_FUSED_COPY(WH_STITCH_SHA256CRC32 | WHEX_CHECKSHA512)
+};
+
 /**
  * WH*Ex functions
  **/
@@ -122,19 +110,54 @@ VOID WHAPI WHInitEx( PWHCTXEX pContext )
     FOR_EACH_HASH(WIN_HASH_INIT_op)
 }
 
+VOID WHAPI WHUpdateExSerial( PWHCTXEX pContext, PCBYTE pbIn, UINT cbIn )
+{
+    const DWORD dwFlags = pContext->dwFlags & WHEX_ALL;
+    UINT i;
+
+    for (i = 0; i < ARRAYSIZE(c_aFusedCopies); ++i)
+    {
+        if (c_aFusedCopies[i].dwFlags == dwFlags)
+        {
+            c_aFusedCopies[i].pfn(pContext, pbIn, cbIn);
+            return;
+        }
+    }
+
+    WHUpdateFused<0>(pContext, pbIn, cbIn);
+}
+
 VOID WHAPI WHUpdateEx( PWHCTXEX pContext, PCBYTE pbIn, UINT cbIn )
 {
 #ifdef USE_PPL
     if (cbIn > 384u) {  // determined experimentally--smaller than this and multithreading doesn't help, but ymmv
 
+        // The stitched pairs are picked out before the split, one task each
+        const BOOL bMD5SHA1 = (pContext->dwFlags & WH_STITCH_MD5SHA1) == WH_STITCH_MD5SHA1;
+        const BOOL bSHA256CRC32 = (pContext->dwFlags & WH_STITCH_SHA256CRC32) == WH_STITCH_SHA256CRC32;
+        DWORD dwSeparate = pContext->dwFlags;
         int cTasks = 0;
-#define WIN_HASH_UPDATE_COUNT_op(alg)             \
-        if (pContext->dwFlags & WHEX_CHECK##alg)  \
+
+        if (bMD5SHA1)
+        {
+            dwSeparate &= ~WH_STITCH_MD5SHA1;
+            cTasks++;
+        }
+        if (bSHA256CRC32)
+        {
+            dwSeparate &= ~WH_STITCH_SHA256CRC32;
+            cTasks++;
+        }
+
+#define WIN_HASH_UPDATE_COUNT_op(alg)     \
+        if (dwSeparate & WHEX_CHECK##alg) \
             cTasks++;
         FOR_EACH_HASH(WIN_HASH_UPDATE_COUNT_op)
 
         if (cTasks > 1)
         {
+            auto task_MD5SHA1 = concurrency::make_task([&] { MD5SHA1Update(&pContext->ctxMD5, &pContext->ctxSHA1, pbIn, cbIn); } );
+            auto task_SHA256CRC32 = concurrency::make_task([&] { SHA256CRC32Update(&pContext->ctxSHA256, &pContext->ctxCRC32.state, pbIn, cbIn); } );
 
 #define WIN_HASH_UPDATE_TASK_op(alg)  \
             auto task_WHUpdate##alg = concurrency::make_task([&] { WHUpdate##alg(&pContext->ctx##alg, pbIn, cbIn); } );
@@ -142,8 +165,13 @@ VOID WHAPI WHUpdateEx( PWHCTXEX pContext, PCBYTE pbIn, UINT cbIn )
 
             concurrency::structured_task_group hashing_task_group;
 
-#define WIN_HASH_UPDATE_RUN_TASK_op(alg)              \
-            if (pContext->dwFlags & WHEX_CHECK##alg)  \
+            if (bMD5SHA1)
+                hashing_task_group.run(task_MD5SHA1);
+            if (bSHA256CRC32)
+                hashing_task_group.run(task_SHA256CRC32);
+
+#define WIN_HASH_UPDATE_RUN_TASK_op(alg)      \
+            if (dwSeparate & WHEX_CHECK##alg) \
                 hashing_task_group.run(task_WHUpdate##alg);
             FOR_EACH_HASH_R(WIN_HASH_UPDATE_RUN_TASK_op)
 
@@ -153,10 +181,23 @@ VOID WHAPI WHUpdateEx( PWHCTXEX pContext, PCBYTE pbIn, UINT cbIn )
     }
 #endif
 
-#define WIN_HASH_UPDATE_RUN_op(alg)           \
-    if (pContext->dwFlags & WHEX_CHECK##alg)  \
-        WHUpdate##alg(&pContext->ctx##alg, pbIn, cbIn);
-    FOR_EACH_HASH(WIN_HASH_UPDATE_RUN_op)
+    WHUpdateExSerial(pContext, pbIn, cbIn);
+}
+
+// For spans which may be 4G or longer, such as views of mapped files; they are
+// fed to WHUpdateExSerial in pieces that a UINT can hold
+#define WH_UPDATE_EX_MAX 0x40000000
+
+VOID WHAPI WHUpdateExSerial64( PWHCTXEX pContext, PCBYTE pbIn, ULONGLONG cbIn )
+{
+    while (cbIn > WH_UPDATE_EX_MAX)
+    {
+        WHUpdateExSerial(pContext, pbIn, WH_UPDATE_EX_MAX);
+        pbIn += WH_UPDATE_EX_MAX;
+        cbIn -= WH_UPDATE_EX_MAX;
+    }
+
+    WHUpdateExSerial(pContext, pbIn, (UINT)cbIn);
 }
 
 VOID WHAPI WHFinishEx( PWHCTXEX pContext, PWHRESULTEX pResults )
@@ -1,11 +1,12 @@
 /**
  * Windows Hashing/Checksumming Library
- * Last modified: 2016/02/21
+ * Last modified: 2026/10/18
  * Original work copyright (C) Kai Liu.  All rights reserved.
  * Modified work copyright (C) 2014, 2016 Christopher Gurnee.  All rights reserved.
  * Modified work copyright (C) 2016 Tim Schlueter.  All rights reserved.
  *
- * This is a wrapper for the CRC32, MD5, SHA1, SHA2-256, and SHA2-512
+ * This is a wrapper for the CRC32, MD5, SHA1, SHA2-256, SHA2-512, SHA3-256,
+ * SHA3-512, BLAKE3, XXH3-128, KangarooTwelve, CRC32C, BLAKE2b, and BLAKE2bp
  * algorithms.
  **/
 
@@ -46,15 +47,27 @@ typedef CONST BYTE *PCBYTE;
                             op(SHA256)  \
                             op(SHA512)  \
                             op(SHA3_256)\
-                            op(SHA3_512)
+                            op(SHA3_512)\
+                            op(BLAKE3)  \
+                            op(XXH3_128)\
+                            op(K12)     \
+                            op(CRC32C)  \
+                            op(BLAKE2B) \
+                            op(BLAKE2BP)
 // In approximate order from longest to shortest compute time
 #define FOR_EACH_HASH_R(op) op(SHA512)  \
                             op(SHA256)  \
                             op(SHA3_512)\
                             op(SHA3_256)\
                             op(SHA1)    \
+                            op(BLAKE2B) \
                             op(CRC32)   \
-                            op(MD5)
+                            op(CRC32C)  \
+                            op(MD5)     \
+                            op(BLAKE2BP)\
+                            op(K12)     \
+                            op(BLAKE3)  \
+                            op(XXH3_128)
 
 /**
  * Some constants related to the hash algorithms
@@ -68,9 +81,15 @@ enum hash_algorithm {
     SHA256,
     SHA512,
     SHA3_256,
-    SHA3_512
+    SHA3_512,
+    BLAKE3,
+    XXH3_128,
+    K12,
+    CRC32C,
+    BLAKE2B,
+    BLAKE2BP
 };
-#define NUM_HASHES SHA3_512
+#define NUM_HASHES BLAKE2BP
 
 // The default hash algorithm to use when creating a checksum file
 #define DEFAULT_HASH_ALGORITHM SHA256
@@ -86,15 +105,21 @@ enum hash_algorithm {
 #define WHEX_CHECKSHA512    (1UL << (SHA512 - 1))
 #define WHEX_CHECKSHA3_256  (1UL << (SHA3_256 - 1))
 #define WHEX_CHECKSHA3_512  (1UL << (SHA3_512 - 1))
-#define WHEX_CHECKLAST      WHEX_CHECKSHA3_512
+#define WHEX_CHECKBLAKE3    (1UL << (BLAKE3 - 1))
+#define WHEX_CHECKXXH3_128  (1UL << (XXH3_128 - 1))
+#define WHEX_CHECKK12       (1UL << (K12 - 1))
+#define WHEX_CHECKCRC32C    (1UL << (CRC32C - 1))
+#define WHEX_CHECKBLAKE2B   (1UL << (BLAKE2B - 1))
+#define WHEX_CHECKBLAKE2BP  (1UL << (BLAKE2BP - 1))
+#define WHEX_CHECKLAST      WHEX_CHECKBLAKE2BP
 
 // Bitwise representation of the hash algorithms, by digest length (in bits)
 #define WHEX_ALL            ((1UL << NUM_HASHES) - 1)
-#define WHEX_ALL32          WHEX_CHECKCRC32
-#define WHEX_ALL128         WHEX_CHECKMD5
+#define WHEX_ALL32          (WHEX_CHECKCRC32 | WHEX_CHECKCRC32C)
+#define WHEX_ALL128         (WHEX_CHECKMD5 | WHEX_CHECKXXH3_128)
 #define WHEX_ALL160         WHEX_CHECKSHA1
-#define WHEX_ALL256         (WHEX_CHECKSHA256 | WHEX_CHECKSHA3_256)
-#define WHEX_ALL512         (WHEX_CHECKSHA512 | WHEX_CHECKSHA3_512)
+#define WHEX_ALL256         (WHEX_CHECKSHA256 | WHEX_CHECKSHA3_256 | WHEX_CHECKBLAKE3 | WHEX_CHECKK12)
+#define WHEX_ALL512         (WHEX_CHECKSHA512 | WHEX_CHECKSHA3_512 | WHEX_CHECKBLAKE2B | WHEX_CHECKBLAKE2BP)
 
 // The block lengths of the hash algorithms, if required below
 #define MD5_BLOCK_LENGTH            64
@@ -103,9 +128,22 @@ enum hash_algorithm {
 #define SHA256_BLOCK_LENGTH         64
 #define SHA384_BLOCK_LENGTH         128
 #define SHA512_BLOCK_LENGTH         128
+#define SHA3_256_BLOCK_LENGTH       136  // the sponge rate
+#define SHA3_512_BLOCK_LENGTH       72
+#define BLAKE3_BLOCK_LENGTH         64
+#define BLAKE3_CHUNK_LENGTH         1024 // the leaves of the tree
+#define XXH3_128_BLOCK_LENGTH       64   // the stripe length
+#define XXH3_BUFFER_LENGTH          256
+#define K12_BLOCK_LENGTH            168  // the sponge rate
+#define K12_CHUNK_LENGTH            8192 // the leaves of the tree
+#define K12_CV_LENGTH               32   // a leaf's chaining value
+#define BLAKE2B_BLOCK_LENGTH        128
+#define BLAKE2BP_PARALLELISM        4    // the leaves of the tree
+#define BLAKE2BP_BUFFER_LENGTH      (2 * BLAKE2BP_PARALLELISM * BLAKE2B_BLOCK_LENGTH)
 
 // The digest lengths of the hash algorithms
 #define CRC32_DIGEST_LENGTH         4
+#define CRC32C_DIGEST_LENGTH        4
 #define MD5_DIGEST_LENGTH           16
 #define SHA1_DIGEST_LENGTH          20
 #define SHA224_DIGEST_LENGTH        28
@@ -114,6 +152,11 @@ enum hash_algorithm {
 #define SHA512_DIGEST_LENGTH        64
 #define SHA3_256_DIGEST_LENGTH      32
 #define SHA3_512_DIGEST_LENGTH      64
+#define BLAKE3_DIGEST_LENGTH        32
+#define XXH3_128_DIGEST_LENGTH      16
+#define K12_DIGEST_LENGTH           32
+#define BLAKE2B_DIGEST_LENGTH       64
+#define BLAKE2BP_DIGEST_LENGTH      64
 #define MAX_DIGEST_LENGTH           SHA512_DIGEST_LENGTH
 
 // The minimum string length required to hold the hex digest strings
@@ -126,6 +169,12 @@ enum hash_algorithm {
 #define SHA512_DIGEST_STRING_LENGTH (SHA512_DIGEST_LENGTH * 2 + 1)
 #define SHA3_256_DIGEST_STRING_LENGTH (SHA3_256_DIGEST_LENGTH * 2 + 1)
 #define SHA3_512_DIGEST_STRING_LENGTH (SHA3_512_DIGEST_LENGTH * 2 + 1)
+#define BLAKE3_DIGEST_STRING_LENGTH (BLAKE3_DIGEST_LENGTH * 2 + 1)
+#define XXH3_128_DIGEST_STRING_LENGTH (XXH3_128_DIGEST_LENGTH * 2 + 1)
+#define K12_DIGEST_STRING_LENGTH    (K12_DIGEST_LENGTH * 2 + 1)
+#define CRC32C_DIGEST_STRING_LENGTH (CRC32C_DIGEST_LENGTH * 2 + 1)
+#define BLAKE2B_DIGEST_STRING_LENGTH (BLAKE2B_DIGEST_LENGTH * 2 + 1)
+#define BLAKE2BP_DIGEST_STRING_LENGTH (BLAKE2BP_DIGEST_LENGTH * 2 + 1)
 #define MAX_DIGEST_STRING_LENGTH    SHA512_DIGEST_STRING_LENGTH
 
 // Hash file extensions
@@ -136,6 +185,12 @@ enum hash_algorithm {
 #define HASH_EXT_SHA512         _T(".sha512")
 #define HASH_EXT_SHA3_256       _T(".sha3-256")
 #define HASH_EXT_SHA3_512       _T(".sha3-512")
+#define HASH_EXT_BLAKE3         _T(".b3")
+#define HASH_EXT_XXH3_128       _T(".xxh128")
+#define HASH_EXT_K12            _T(".k12")
+#define HASH_EXT_CRC32C         _T(".crc32c")
+#define HASH_EXT_BLAKE2B        _T(".b2")
+#define HASH_EXT_BLAKE2BP       _T(".b2bp")
 
 // Table of supported Hash file extensions, plus .asc
 extern LPCTSTR g_szHashExtsTab[NUM_HASHES + 1];
@@ -148,6 +203,12 @@ extern LPCTSTR g_szHashExtsTab[NUM_HASHES + 1];
 #define HASH_NAME_SHA512        _T("SHA-512")
 #define HASH_NAME_SHA3_256      _T("SHA3-256")
 #define HASH_NAME_SHA3_512      _T("SHA3-512")
+#define HASH_NAME_BLAKE3        _T("BLAKE3")
+#define HASH_NAME_XXH3_128      _T("XXH3-128")
+#define HASH_NAME_K12           _T("K12")
+#define HASH_NAME_CRC32C        _T("CRC-32C")
+#define HASH_NAME_BLAKE2B       _T("BLAKE2b")
+#define HASH_NAME_BLAKE2BP      _T("BLAKE2bp")
 
 // Right-justified Hash names
 #define HASH_RNAME_CRC32        _T("  CRC-32")
@@ -157,6 +218,12 @@ extern LPCTSTR g_szHashExtsTab[NUM_HASHES + 1];
 #define HASH_RNAME_SHA512       _T(" SHA-512")
 #define HASH_RNAME_SHA3_256     _T("SHA3-256")
 #define HASH_RNAME_SHA3_512     _T("SHA3-512")
+#define HASH_RNAME_BLAKE3       _T("  BLAKE3")
+#define HASH_RNAME_XXH3_128     _T("XXH3-128")
+#define HASH_RNAME_K12          _T("     K12")
+#define HASH_RNAME_CRC32C       _T(" CRC-32C")
+#define HASH_RNAME_BLAKE2B      _T(" BLAKE2b")
+#define HASH_RNAME_BLAKE2BP     _T("BLAKE2bp")
 
 // Hash OPENFILENAME filters, E.G. "MD5 (*.md5)\0*.md5\0"
 #define HASH_FILTER_op(alg)     HASH_NAME_##alg _T(" (*")   \
@@ -198,8 +265,69 @@ typedef struct _SHA2_CTX {
 	BYTE result[SHA512_DIGEST_LENGTH];
 } SHA2_CTX, *PSHA2_CTX;
 
+typedef struct {
+	UINT32 cv[8];
+	UINT64 counter;
+	BYTE buffer[BLAKE3_BLOCK_LENGTH];
+	BYTE cbBuffer;
+	BYTE cBlocksCompressed;
+	BYTE flags;
+} BLAKE3_CHUNK_STATE, *PBLAKE3_CHUNK_STATE;
+
+// The stack holds one chaining value per level of the tree, plus one more
+// while a new value is being merged into it
+#define BLAKE3_MAX_DEPTH 54
+
+typedef struct {
+	UINT32 key[8];
+	BLAKE3_CHUNK_STATE chunk;
+	UINT64 baseCounter;
+	BYTE cvStackLength;
+	BYTE cvStack[(BLAKE3_MAX_DEPTH + 1) * BLAKE3_DIGEST_LENGTH];
+	BYTE result[BLAKE3_DIGEST_LENGTH];
+} BLAKE3_CTX, *PBLAKE3_CTX;
+
+typedef struct {
+	UINT64 acc[8];
+	BYTE buffer[XXH3_BUFFER_LENGTH];
+	UINT cbBuffer;
+	UINT cStripes;  // stripes accumulated since the last scramble
+	UINT64 cbTotal;
+	BYTE result[XXH3_128_DIGEST_LENGTH];
+} XXH3_128_CTX, *PXXH3_128_CTX;
+
+typedef struct {
+	UINT64 node[25];   // the final node's sponge state
+	UINT64 leaf[25];   // the current leaf's sponge state
+	UINT ibNode;       // bytes absorbed into each sponge's current block
+	UINT ibLeaf;
+	UINT cbChunk;      // bytes of the current chunk (the first one, or a leaf) so far
+	UINT64 cLeaves;    // completed leaves
+	BOOL bTree;        // whether the first chunk is complete
+	BYTE result[K12_DIGEST_LENGTH];
+} K12_CTX, *PK12_CTX;
+
+typedef struct {
+	UINT64 h[8];
+	UINT64 counter;    // bytes compressed so far
+	BYTE buffer[BLAKE2B_BLOCK_LENGTH];
+	UINT cbBuffer;
+	BYTE result[BLAKE2B_DIGEST_LENGTH];
+} BLAKE2B_CTX, *PBLAKE2B_CTX;
+
+typedef struct {
+	UINT64 h[BLAKE2BP_PARALLELISM][8];  // the leaves' states
+	UINT64 counter;    // bytes compressed into each leaf so far
+	BYTE buffer[BLAKE2BP_BUFFER_LENGTH];
+	UINT cbBuffer;
+	BYTE result[BLAKE2BP_DIGEST_LENGTH];
+} BLAKE2BP_CTX, *PBLAKE2BP_CTX;
+
 
 UINT32 crc32( UINT32 uInitial, PCBYTE pbIn, UINT cbIn );
+UINT32 crc32_combine( UINT32 uCrc1, UINT32 uCrc2, UINT64 cbLen2 );
+
+UINT32 crc32c( UINT32 uInitial, PCBYTE pbIn, UINT cbIn );
 
 void MD5Init( PMD5_CTX pContext );
 void MD5Update( PMD5_CTX pContext, PCBYTE pbIn, UINT cbIn );
@@ -217,6 +345,51 @@ void SHA512Init( PSHA2_CTX pContext );
 void SHA512Update( PSHA2_CTX pContext, PCBYTE pbIn, UINT cbIn );
 void SHA512Final( PSHA2_CTX pContext );
 
+void BLAKE3Init( PBLAKE3_CTX pContext );
+void BLAKE3Update( PBLAKE3_CTX pContext, PCBYTE pbIn, UINT cbIn );
+void BLAKE3Final( PBLAKE3_CTX pContext );
+
+// For hashing separate parts of the input in parallel: each part is hashed
+// into a context initialized with its byte offset, which must be a multiple
+// of the part's length rounded up to a power of 2 (and of BLAKE3_CHUNK_LENGTH);
+// then, in order, each part's context is appended to the first one's
+void BLAKE3InitAt( PBLAKE3_CTX pContext, UINT64 cbOffset );
+void BLAKE3Append( PBLAKE3_CTX pContext, PBLAKE3_CTX pNext );
+
+void XXH3_128Init( PXXH3_128_CTX pContext );
+void XXH3_128Update( PXXH3_128_CTX pContext, PCBYTE pbIn, UINT cbIn );
+void XXH3_128Final( PXXH3_128_CTX pContext );
+
+void K12Init( PK12_CTX pContext );
+void K12Update( PK12_CTX pContext, PCBYTE pbIn, UINT cbIn );
+void K12Final( PK12_CTX pContext );
+
+// For hashing the leaves in parallel: after K12_CHUNK_LENGTH bytes (or any
+// multiple of it beyond that) have been added to a context, the chaining
+// values of the next whole leaves can be computed separately by
+// K12HashLeaves, and then appended to the context, in order
+void K12HashLeaves( PCBYTE pbIn, SIZE_T cLeaves, PBYTE pbChainingValues );
+void K12AppendLeaves( PK12_CTX pContext, PCBYTE pbChainingValues, SIZE_T cLeaves );
+
+void BLAKE2bInit( PBLAKE2B_CTX pContext );
+void BLAKE2bUpdate( PBLAKE2B_CTX pContext, PCBYTE pbIn, UINT cbIn );
+void BLAKE2bFinal( PBLAKE2B_CTX pContext );
+
+void BLAKE2bpInit( PBLAKE2BP_CTX pContext );
+void BLAKE2bpUpdate( PBLAKE2BP_CTX pContext, PCBYTE pbIn, UINT cbIn );
+void BLAKE2bpFinal( PBLAKE2BP_CTX pContext );
+
+// Stitched updates of two algorithms at once, with their rounds interleaved
+// in one loop; each has the same effect as the two separate updates, of
+// contexts that have been fed the same input so far
+void MD5SHA1Update( PMD5_CTX pMD5, PSHA1_CTX pSHA1, PCBYTE pbIn, UINT cbIn );
+void SHA256CRC32Update( PSHA2_CTX pSHA256, PUINT32 puCRC32, PCBYTE pbIn, UINT cbIn );
+
+// When both algorithms of a pair are enabled, every way of splitting the work
+// (WHUpdateEx's tasks, WHPipe's threads) keeps the pair together
+#define WH_STITCH_MD5SHA1     (WHEX_CHECKMD5 | WHEX_CHECKSHA1)
+#define WH_STITCH_SHA256CRC32 (WHEX_CHECKSHA256 | WHEX_CHECKCRC32)
+
 /**
  * Structures used by our consistency wrapper layer
  **/
@@ -226,6 +399,9 @@ typedef union {
 	BYTE result[CRC32_DIGEST_LENGTH];
 } WHCTXCRC32, *PWHCTXCRC32;
 
+#define  WHCTXCRC32C  WHCTXCRC32
+#define PWHCTXCRC32C PWHCTXCRC32
+
 #define  WHCTXMD5  MD5_CTX
 #define PWHCTXMD5 PMD5_CTX
 
@@ -238,6 +414,21 @@ typedef union {
 #define  WHCTXSHA512  SHA2_CTX
 #define PWHCTXSHA512 PSHA2_CTX
 
+#define  WHCTXBLAKE3  BLAKE3_CTX
+#define PWHCTXBLAKE3 PBLAKE3_CTX
+
+#define  WHCTXXXH3_128  XXH3_128_CTX
+#define PWHCTXXXH3_128 PXXH3_128_CTX
+
+#define  WHCTXK12  K12_CTX
+#define PWHCTXK12 PK12_CTX
+
+#define  WHCTXBLAKE2B  BLAKE2B_CTX
+#define PWHCTXBLAKE2B PBLAKE2B_CTX
+
+#define  WHCTXBLAKE2BP  BLAKE2BP_CTX
+#define PWHCTXBLAKE2BP PBLAKE2BP_CTX
+
 typedef struct {
     Keccak_HashInstance state;
     BYTE result[SHA3_256_DIGEST_LENGTH];
@@ -269,6 +460,15 @@ __inline void WHAPI WHFinishCRC32( PWHCTXCRC32 pContext )
 	pContext->state = SwapV32(pContext->state);
 }
 
+#define WHInitCRC32C WHInitCRC32
+
+__inline void WHAPI WHUpdateCRC32C( PWHCTXCRC32C pContext, PCBYTE pbIn, UINT cbIn )
+{
+	pContext->state = crc32c(pContext->state, pbIn, cbIn);
+}
+
+#define WHFinishCRC32C WHFinishCRC32
+
 #define WHInitMD5 MD5Init
 #define WHUpdateMD5 MD5Update
 #define WHFinishMD5 MD5Final
@@ -285,6 +485,26 @@ __inline void WHAPI WHFinishCRC32( PWHCTXCRC32 pContext )
 #define WHUpdateSHA512 SHA512Update
 #define WHFinishSHA512 SHA512Final
 
+#define WHInitBLAKE3 BLAKE3Init
+#define WHUpdateBLAKE3 BLAKE3Update
+#define WHFinishBLAKE3 BLAKE3Final
+
+#define WHInitXXH3_128 XXH3_128Init
+#define WHUpdateXXH3_128 XXH3_128Update
+#define WHFinishXXH3_128 XXH3_128Final
+
+#define WHInitK12 K12Init
+#define WHUpdateK12 K12Update
+#define WHFinishK12 K12Final
+
+#define WHInitBLAKE2B BLAKE2bInit
+#define WHUpdateBLAKE2B BLAKE2bUpdate
+#define WHFinishBLAKE2B BLAKE2bFinal
+
+#define WHInitBLAKE2BP BLAKE2bpInit
+#define WHUpdateBLAKE2BP BLAKE2bpUpdate
+#define WHFinishBLAKE2BP BLAKE2bpFinal
+
 __inline void WHAPI WHInitSHA3_256( PWHCTXSHA3_256 pContext )
 {
     Keccak_HashInitialize_SHA3_256(&pContext->state);
@@ -316,7 +536,7 @@ __inline void WHAPI WHFinishSHA3_512(PWHCTXSHA3_512 pContext)
 }
 
 /**
- * WH*To* hex string conversion functions: These require WinHash.cpp
+ * WH*To* hex string conversion functions: These require WinHashHex.c
  **/
 
 #define WHAPI __fastcall
@@ -324,8 +544,24 @@ __inline void WHAPI WHFinishSHA3_512(PWHCTXSHA3_512 pContext)
 #define WHFMT_UPPERCASE 0x00
 #define WHFMT_LOWERCASE 0x20
 
-BOOL WHAPI WHHexToByte( PTSTR pszSrc, PBYTE pbDest, UINT cchHex );
-PTSTR WHAPI WHByteToHex( PBYTE pbSrc, PTSTR pszDest, UINT cchHex, UINT8 uCaseMode );
+BOOL WHAPI WHHexToByteA( PSTR pszSrc, PBYTE pbDest, UINT cchHex );
+BOOL WHAPI WHHexToByteW( PWSTR pszSrc, PBYTE pbDest, UINT cchHex );
+PSTR WHAPI WHByteToHexA( PCBYTE pbSrc, PSTR pszDest, UINT cchHex, UINT8 uCaseMode );
+PWSTR WHAPI WHByteToHexW( PCBYTE pbSrc, PWSTR pszDest, UINT cchHex, UINT8 uCaseMode );
+
+// Checks that psz holds cchHex hex digits, and converts them to lower-case
+BOOL WHAPI WHValidateHexA( PSTR psz, UINT cchHex );
+BOOL WHAPI WHValidateHexW( PWSTR psz, UINT cchHex );
+
+#ifdef UNICODE
+#define WHHexToByte   WHHexToByteW
+#define WHByteToHex   WHByteToHexW
+#define WHValidateHex WHValidateHexW
+#else
+#define WHHexToByte   WHHexToByteA
+#define WHByteToHex   WHByteToHexA
+#define WHValidateHex WHValidateHexA
+#endif
 
 /**
  * WH*Ex functions: These require WinHash.cpp
@@ -339,6 +575,12 @@ typedef struct {
     TCHAR szHexSHA512[SHA512_DIGEST_STRING_LENGTH];
     TCHAR szHexSHA3_256[SHA3_256_DIGEST_STRING_LENGTH];
     TCHAR szHexSHA3_512[SHA3_512_DIGEST_STRING_LENGTH];
+    TCHAR szHexBLAKE3[BLAKE3_DIGEST_STRING_LENGTH];
+    TCHAR szHexXXH3_128[XXH3_128_DIGEST_STRING_LENGTH];
+    TCHAR szHexK12[K12_DIGEST_STRING_LENGTH];
+    TCHAR szHexCRC32C[CRC32C_DIGEST_STRING_LENGTH];
+    TCHAR szHexBLAKE2B[BLAKE2B_DIGEST_STRING_LENGTH];
+    TCHAR szHexBLAKE2BP[BLAKE2BP_DIGEST_STRING_LENGTH];
     DWORD dwFlags;
 } WHRESULTEX, *PWHRESULTEX;
 
@@ -351,6 +593,12 @@ typedef struct {
 	__declspec(align(64)) WHCTXSHA512 ctxSHA512;
 	__declspec(align(64)) WHCTXSHA3_256 ctxSHA3_256;
 	__declspec(align(64)) WHCTXSHA3_512 ctxSHA3_512;
+	__declspec(align(64)) WHCTXBLAKE3 ctxBLAKE3;
+	__declspec(align(64)) WHCTXXXH3_128 ctxXXH3_128;
+	__declspec(align(64)) WHCTXK12 ctxK12;
+	__declspec(align(64)) WHCTXCRC32C ctxCRC32C;
+	__declspec(align(64)) WHCTXBLAKE2B ctxBLAKE2B;
+	__declspec(align(64)) WHCTXBLAKE2BP ctxBLAKE2BP;
 	DWORD dwFlags;
 	UINT8 uCaseMode;
 } WHCTXEX, *PWHCTXEX;
@@ -358,6 +606,11 @@ typedef struct {
 
 VOID WHAPI WHInitEx( PWHCTXEX pContext );
 VOID WHAPI WHUpdateEx( PWHCTXEX pContext, PCBYTE pbIn, UINT cbIn );
+// Like WHUpdateEx, but hashes on the calling thread only, walking the buffer
+// in cache-sized tiles which are fed to each algorithm in turn
+VOID WHAPI WHUpdateExSerial( PWHCTXEX pContext, PCBYTE pbIn, UINT cbIn );
+// Like WHUpdateExSerial, for spans which may be 4G or longer
+VOID WHAPI WHUpdateExSerial64( PWHCTXEX pContext, PCBYTE pbIn, ULONGLONG cbIn );
 VOID WHAPI WHFinishEx( PWHCTXEX pContext, PWHRESULTEX pResults );
 
 #ifdef __cplusplus
@@ -0,0 +1,155 @@
+/**
+ * Windows Hashing/Checksumming Library - Kernel Dispatch
+ * Last modified: 2026/10/18
+ **/
+
+#include "WinHashDispatch.h"
+#include <string.h>
+#include <strsafe.h>
+
+#define KERNELS_ENVNAME   "HASHCHECK_KERNELS"
+#define KERNELS_KEYNAME   "Software\\HashCheck"
+#define KERNELS_VALUENAME "Kernels"
+#define MAX_KERNELS_SPEC  512
+#define MAX_VARIANT_NAME  WHK_MAX_NAME
+
+static PWHKERNELSLOT const c_apSlots[] = {
+	&g_ksCRC32,
+	&g_ksSHA1,
+	&g_ksSHA256,
+	&g_ksSHA512,
+	&g_ksKeccakP1600,
+	&g_ksMD5MB,
+	&g_ksSHA256MB,
+	&g_ksSHA3_256MB,
+	&g_ksSHA3_512MB,
+	&g_ksHex,
+	&g_ksBLAKE3,
+	&g_ksXXH3,
+	&g_ksK12,
+	&g_ksCRC32C,
+	&g_ksBLAKE2BP,
+	&g_ksMD5SHA1,
+	&g_ksSHA256CRC32
+};
+
+C_ASSERT(ARRAYSIZE(c_apSlots) == WHK_NUM_SLOTS);
+
+static BOOL WHAPI WHGetKernelsSpec( PSTR pszSpec, DWORD cchSpec )
+{
+	HKEY hKey;
+	DWORD dwType, cbData = cchSpec - 1;
+	BOOL bFound = FALSE;
+	DWORD cch = GetEnvironmentVariableA(KERNELS_ENVNAME, pszSpec, cchSpec);
+
+	if (cch && cch < cchSpec)
+		return(TRUE);
+
+	if (RegOpenKeyExA(HKEY_CURRENT_USER, KERNELS_KEYNAME, 0, KEY_QUERY_VALUE, &hKey) == ERROR_SUCCESS)
+	{
+		if ( RegQueryValueExA(hKey, KERNELS_VALUENAME, NULL, &dwType, (PBYTE)pszSpec, &cbData) == ERROR_SUCCESS &&
+		     dwType == REG_SZ )
+		{
+			pszSpec[cbData] = 0;
+			bFound = TRUE;
+		}
+
+		RegCloseKey(hKey);
+	}
+
+	return(bFound);
+}
+
+// Looks up the variant forced for pszKernel, if any; a specific entry
+// takes precedence over a "*" entry, regardless of their order
+static BOOL WHAPI WHGetForcedVariant( PCSTR pszKernel, PSTR pszVariant )
+{
+	CHAR szSpec[MAX_KERNELS_SPEC];
+	PSTR pszEntry, pszNext, pszValue;
+	BOOL bFound = FALSE;
+
+	if (!WHGetKernelsSpec(szSpec, MAX_KERNELS_SPEC))
+		return(FALSE);
+
+	for (pszEntry = szSpec; *pszEntry; pszEntry = pszNext)
+	{
+		// Entries are separated by spaces, commas, or semicolons
+		for (pszNext = pszEntry; *pszNext && !strchr(" ,;", *pszNext); ++pszNext);
+		if (*pszNext) *pszNext++ = 0;
+
+		if (!(pszValue = strchr(pszEntry, '=')))
+			continue;
+
+		*pszValue++ = 0;
+
+		if (lstrcmpiA(pszEntry, pszKernel) == 0 || (!bFound && lstrcmpA(pszEntry, "*") == 0))
+		{
+			StringCchCopyA(pszVariant, MAX_VARIANT_NAME, pszValue);
+			bFound = TRUE;
+
+			if (*pszEntry != '*')
+				break;
+		}
+	}
+
+	return(bFound);
+}
+
+PVOID WHAPI WHBindKernel( PWHKERNELSLOT pSlot )
+{
+	PCWHKERNEL pKernel = pSlot->pSelected;
+
+	// Racing threads will all select the same variant, so no locking is needed
+	if (!pKernel)
+	{
+		UINT32 uFeatures = GetCpuFeatures();
+		CHAR szVariant[MAX_VARIANT_NAME];
+		UINT i;
+
+		if (WHGetForcedVariant(pSlot->pszName, szVariant))
+		{
+			for (i = 0; i < pSlot->cVariants; ++i)
+			{
+				if ( lstrcmpiA(pSlot->pVariants[i].pszName, szVariant) == 0 &&
+				     (pSlot->pVariants[i].uRequired & ~uFeatures) == 0 )
+				{
+					pKernel = &pSlot->pVariants[i];
+					break;
+				}
+			}
+		}
+
+		if (!pKernel)
+		{
+			for (i = 0; i < pSlot->cVariants - 1; ++i)
+			{
+				if ( (pSlot->pVariants[i].uRequired & ~uFeatures) == 0 &&
+				     (pSlot->pVariants[i].uSkipIf & uFeatures) == 0 )
+					break;
+			}
+
+			pKernel = &pSlot->pVariants[i];
+		}
+
+		pSlot->pSelected = pKernel;
+	}
+
+	return(pKernel->pfn);
+}
+
+VOID WHAPI WHGetKernelReport( LPTSTR pszReport, UINT cchReport )
+{
+	size_t cchRemaining = cchReport;
+	UINT i;
+
+	*pszReport = 0;
+
+	for (i = 0; i < ARRAYSIZE(c_apSlots); ++i)
+	{
+		WHBindKernel(c_apSlots[i]);
+
+		StringCchPrintfEx(pszReport, cchRemaining, &pszReport, &cchRemaining, 0,
+		                  (i) ? TEXT(" %hs=%hs") : TEXT("%hs=%hs"),
+		                  c_apSlots[i]->pszName, c_apSlots[i]->pSelected->pszName);
+	}
+}
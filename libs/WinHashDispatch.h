@@ -0,0 +1,82 @@
+/**
+ * Windows Hashing/Checksumming Library - Kernel Dispatch
+ * Last modified: 2026/10/18
+ *
+ * Each library that has processor-specific code paths registers a kernel
+ * slot here, listing its variants in order of preference along with the
+ * CPUID features that each one requires.  The slot is bound to the best
+ * variant that the processor supports the first time it is used.
+ *
+ * The choice can be overridden, e.g. to compare variants or to work around
+ * a suspected processor-specific problem, with a list of name=variant pairs
+ * (such as "sha256=c crc32=clmul", or "*=c" to use only the portable code)
+ * in the HASHCHECK_KERNELS environment variable, or else in the "Kernels"
+ * value of HKCU\Software\HashCheck.  A forced variant that the processor
+ * cannot run is ignored.
+ **/
+
+#ifndef __WINHASHDISPATCH_H__
+#define __WINHASHDISPATCH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "WinHash.h"
+#include "CpuFeatures.h"
+
+// The portable variant of every kernel is named "c"
+#define WHK_PORTABLE "c"
+
+#define WHK_NUM_SLOTS  17  // number of registered slots (see below)
+#define WHK_MAX_NAME   32  // longest slot or variant name, including the NUL
+
+// Size, in characters, of a buffer that holds the report of every slot
+#define WHK_REPORT_LENGTH (WHK_NUM_SLOTS * WHK_MAX_NAME * 2)
+
+typedef struct {
+	PCSTR  pszName;    // as used in overrides and in the report
+	UINT32 uRequired;  // CPUF_* flags that the variant requires
+	UINT32 uSkipIf;    // CPUF_* flags that make a later variant the better choice
+	PVOID  pfn;        // the implementation, cast back by the owning library
+} WHKERNEL, *PWHKERNEL;
+
+typedef const WHKERNEL *PCWHKERNEL;
+
+typedef struct {
+	PCSTR      pszName;    // e.g. "sha256"
+	PCWHKERNEL pVariants;  // best first; the last must be the portable variant
+	UINT       cVariants;
+	PCWHKERNEL pSelected;  // NULL until bound
+} WHKERNELSLOT, *PWHKERNELSLOT;
+
+// Binds the slot if it has not yet been bound, and returns the selected pfn
+PVOID WHAPI WHBindKernel( PWHKERNELSLOT pSlot );
+
+// Binds every slot and describes the selection as "name=variant ..."
+VOID WHAPI WHGetKernelReport( LPTSTR pszReport, UINT cchReport );
+
+// The registered slots
+extern WHKERNELSLOT g_ksCRC32;
+extern WHKERNELSLOT g_ksSHA1;
+extern WHKERNELSLOT g_ksSHA256;
+extern WHKERNELSLOT g_ksSHA512;
+extern WHKERNELSLOT g_ksKeccakP1600;
+extern WHKERNELSLOT g_ksMD5MB;
+extern WHKERNELSLOT g_ksSHA256MB;
+extern WHKERNELSLOT g_ksSHA3_256MB;
+extern WHKERNELSLOT g_ksSHA3_512MB;
+extern WHKERNELSLOT g_ksHex;
+extern WHKERNELSLOT g_ksBLAKE3;
+extern WHKERNELSLOT g_ksXXH3;
+extern WHKERNELSLOT g_ksK12;
+extern WHKERNELSLOT g_ksCRC32C;
+extern WHKERNELSLOT g_ksBLAKE2BP;
+extern WHKERNELSLOT g_ksMD5SHA1;
+extern WHKERNELSLOT g_ksSHA256CRC32;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,437 @@
+/**
+ * Windows Hashing/Checksumming Library - Hex Conversion
+ * Last modified: 2026/10/18
+ *
+ * Digests are converted to and from hex text once per file, and every line
+ * of a checksum file is validated as hex, so with millions of tiny files the
+ * nybble-at-a-time loops show up next to the hashing itself.  The SSSE3 and
+ * AVX2 kernels here convert 16 or 32 bytes at a time with table lookups via
+ * PSHUFB; whatever they leave over (and all of the work on older processors)
+ * is done by the scalar loops.
+ *
+ * There are ANSI/UTF-8 (A) and UTF-16 (W) flavors of each function; since
+ * hex digits are ASCII, UTF-16 text is simply narrowed to bytes first, with
+ * any character above 0xFF saturating to an invalid byte.
+ **/
+
+#include "WinHashDispatch.h"
+#include <immintrin.h>
+
+typedef UINT (WHAPI *PFNWHHEXENCODEA)( PCBYTE pbSrc, PSTR pszDest, UINT cbSrc, UINT8 uCaseMode );
+typedef UINT (WHAPI *PFNWHHEXENCODEW)( PCBYTE pbSrc, PWSTR pszDest, UINT cbSrc, UINT8 uCaseMode );
+typedef UINT (WHAPI *PFNWHHEXDECODEA)( PSTR psz, PBYTE pbDest, UINT cch, BOOL bLowercase );
+typedef UINT (WHAPI *PFNWHHEXDECODEW)( PWSTR psz, PBYTE pbDest, UINT cch, BOOL bLowercase );
+
+// Each kernel converts as much as it can in whole vectors and returns how
+// many bytes (encode) or characters (decode) it got through; a decoder stops
+// short of the first vector that contains an invalid character
+typedef struct {
+	PFNWHHEXENCODEA pfnEncodeA;
+	PFNWHHEXENCODEW pfnEncodeW;
+	PFNWHHEXDECODEA pfnDecodeA;
+	PFNWHHEXDECODEW pfnDecodeW;
+} WHHEXBACKEND, *PWHHEXBACKEND;
+
+typedef const WHHEXBACKEND *PCWHHEXBACKEND;
+
+/**
+ * SSSE3
+ **/
+
+// Maps each nybble to its hex digit; or'ing in WHFMT_LOWERCASE leaves the
+// digits alone and lowercases the letters
+__forceinline __m128i WHHexTable128( UINT8 uCaseMode )
+{
+	return(_mm_or_si128(
+		_mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'),
+		_mm_set1_epi8(uCaseMode)));
+}
+
+__forceinline VOID WHHexEncode128( __m128i x, __m128i table, __m128i *pLo, __m128i *pHi )
+{
+	const __m128i nybble = _mm_set1_epi8(0x0F);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), nybble);
+	__m128i lo = _mm_and_si128(x, nybble);
+
+	*pLo = _mm_shuffle_epi8(table, _mm_unpacklo_epi8(hi, lo));
+	*pHi = _mm_shuffle_epi8(table, _mm_unpackhi_epi8(hi, lo));
+}
+
+// Returns the lowercased characters, or FALSE if any of them is not hex
+__forceinline BOOL WHHexCheck128( __m128i ch, __m128i *pLower )
+{
+	__m128i lower = _mm_or_si128(ch, _mm_set1_epi8(0x20));
+	__m128i digit = _mm_sub_epi8(ch, _mm_set1_epi8('0'));
+	__m128i alpha = _mm_sub_epi8(lower, _mm_set1_epi8('a'));
+
+	// Unsigned range checks: 0 <= digit <= 9 and 0 <= alpha <= 5
+	digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+	alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+
+	*pLower = lower;
+	return(_mm_movemask_epi8(_mm_or_si128(digit, alpha)) == 0xFFFF);
+}
+
+// Converts 16 lowercase hex characters to 8 bytes
+__forceinline VOID WHHexDecode128( __m128i lower, PBYTE pbDest )
+{
+	__m128i alpha = _mm_cmpgt_epi8(lower, _mm_set1_epi8('9'));
+	__m128i value = _mm_sub_epi8(_mm_sub_epi8(lower, _mm_set1_epi8('0')),
+	                             _mm_and_si128(alpha, _mm_set1_epi8('a' - '0' - 10)));
+
+	// Each pair of nybbles becomes (hi << 4) + lo
+	value = _mm_maddubs_epi16(value, _mm_set1_epi16(0x0110));
+	_mm_storel_epi64((__m128i *)pbDest, _mm_packus_epi16(value, value));
+}
+
+static UINT WHAPI WHHexEncodeSSSE3A( PCBYTE pbSrc, PSTR pszDest, UINT cbSrc, UINT8 uCaseMode )
+{
+	__m128i table = WHHexTable128(uCaseMode), lo, hi;
+	UINT cb;
+
+	for (cb = 0; cb + 16 <= cbSrc; cb += 16)
+	{
+		WHHexEncode128(_mm_loadu_si128((const __m128i *)(pbSrc + cb)), table, &lo, &hi);
+		_mm_storeu_si128((__m128i *)(pszDest + cb * 2), lo);
+		_mm_storeu_si128((__m128i *)(pszDest + cb * 2 + 16), hi);
+	}
+
+	return(cb);
+}
+
+static UINT WHAPI WHHexEncodeSSSE3W( PCBYTE pbSrc, PWSTR pszDest, UINT cbSrc, UINT8 uCaseMode )
+{
+	__m128i table = WHHexTable128(uCaseMode), zero = _mm_setzero_si128(), lo, hi;
+	UINT cb;
+
+	for (cb = 0; cb + 16 <= cbSrc; cb += 16)
+	{
+		__m128i *pDest = (__m128i *)(pszDest + cb * 2);
+
+		WHHexEncode128(_mm_loadu_si128((const __m128i *)(pbSrc + cb)), table, &lo, &hi);
+		_mm_storeu_si128(pDest + 0, _mm_unpacklo_epi8(lo, zero));
+		_mm_storeu_si128(pDest + 1, _mm_unpackhi_epi8(lo, zero));
+		_mm_storeu_si128(pDest + 2, _mm_unpacklo_epi8(hi, zero));
+		_mm_storeu_si128(pDest + 3, _mm_unpackhi_epi8(hi, zero));
+	}
+
+	return(cb);
+}
+
+static UINT WHAPI WHHexDecodeSSSE3A( PSTR psz, PBYTE pbDest, UINT cch, BOOL bLowercase )
+{
+	__m128i lower;
+	UINT ich;
+
+	for (ich = 0; ich + 16 <= cch; ich += 16)
+	{
+		if (!WHHexCheck128(_mm_loadu_si128((const __m128i *)(psz + ich)), &lower))
+			break;
+
+		if (bLowercase)
+			_mm_storeu_si128((__m128i *)(psz + ich), lower);
+
+		if (pbDest)
+			WHHexDecode128(lower, pbDest + ich / 2);
+	}
+
+	return(ich);
+}
+
+static UINT WHAPI WHHexDecodeSSSE3W( PWSTR psz, PBYTE pbDest, UINT cch, BOOL bLowercase )
+{
+	__m128i lower, zero = _mm_setzero_si128();
+	UINT ich;
+
+	for (ich = 0; ich + 16 <= cch; ich += 16)
+	{
+		__m128i *p = (__m128i *)(psz + ich);
+
+		// Narrowing with unsigned saturation turns anything above 0xFF into
+		// 0xFF (or 0 if the sign bit is set), neither of which is hex
+		if (!WHHexCheck128(_mm_packus_epi16(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)), &lower))
+			break;
+
+		if (bLowercase)
+		{
+			_mm_storeu_si128(p + 0, _mm_unpacklo_epi8(lower, zero));
+			_mm_storeu_si128(p + 1, _mm_unpackhi_epi8(lower, zero));
+		}
+
+		if (pbDest)
+			WHHexDecode128(lower, pbDest + ich / 2);
+	}
+
+	return(ich);
+}
+
+static const WHHEXBACKEND c_hexSSSE3 = {
+	WHHexEncodeSSSE3A, WHHexEncodeSSSE3W, WHHexDecodeSSSE3A, WHHexDecodeSSSE3W
+};
+
+/**
+ * AVX2; PSHUFB and PACKUSWB work within 128-bit lanes, so the results of
+ * each are put back in order with a cross-lane permute
+ **/
+
+__forceinline VOID WHHexEncode256( __m256i x, __m256i table, __m256i *pLo, __m256i *pHi )
+{
+	const __m256i nybble = _mm256_set1_epi8(0x0F);
+	__m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nybble);
+	__m256i lo = _mm256_and_si256(x, nybble);
+	__m256i a = _mm256_unpacklo_epi8(hi, lo);  // bytes 0-7 | 16-23
+	__m256i b = _mm256_unpackhi_epi8(hi, lo);  // bytes 8-15 | 24-31
+
+	*pLo = _mm256_shuffle_epi8(table, _mm256_permute2x128_si256(a, b, 0x20));
+	*pHi = _mm256_shuffle_epi8(table, _mm256_permute2x128_si256(a, b, 0x31));
+}
+
+__forceinline BOOL WHHexCheck256( __m256i ch, __m256i *pLower )
+{
+	__m256i lower = _mm256_or_si256(ch, _mm256_set1_epi8(0x20));
+	__m256i digit = _mm256_sub_epi8(ch, _mm256_set1_epi8('0'));
+	__m256i alpha = _mm256_sub_epi8(lower, _mm256_set1_epi8('a'));
+
+	digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+	alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+
+	*pLower = lower;
+	return(_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)) == -1);
+}
+
+// Converts 32 lowercase hex characters to 16 bytes
+__forceinline VOID WHHexDecode256( __m256i lower, PBYTE pbDest )
+{
+	__m256i alpha = _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('9'));
+	__m256i value = _mm256_sub_epi8(_mm256_sub_epi8(lower, _mm256_set1_epi8('0')),
+	                                _mm256_and_si256(alpha, _mm256_set1_epi8('a' - '0' - 10)));
+
+	value = _mm256_maddubs_epi16(value, _mm256_set1_epi16(0x0110));
+	value = _mm256_permute4x64_epi64(_mm256_packus_epi16(value, value), 0x08);
+	_mm_storeu_si128((__m128i *)pbDest, _mm256_castsi256_si128(value));
+}
+
+static UINT WHAPI WHHexEncodeAVX2A( PCBYTE pbSrc, PSTR pszDest, UINT cbSrc, UINT8 uCaseMode )
+{
+	__m256i table = _mm256_broadcastsi128_si256(WHHexTable128(uCaseMode)), lo, hi;
+	UINT cb;
+
+	for (cb = 0; cb + 32 <= cbSrc; cb += 32)
+	{
+		WHHexEncode256(_mm256_loadu_si256((const __m256i *)(pbSrc + cb)), table, &lo, &hi);
+		_mm256_storeu_si256((__m256i *)(pszDest + cb * 2), lo);
+		_mm256_storeu_si256((__m256i *)(pszDest + cb * 2 + 32), hi);
+	}
+
+	return(cb + WHHexEncodeSSSE3A(pbSrc + cb, pszDest + cb * 2, cbSrc - cb, uCaseMode));
+}
+
+static UINT WHAPI WHHexEncodeAVX2W( PCBYTE pbSrc, PWSTR pszDest, UINT cbSrc, UINT8 uCaseMode )
+{
+	__m256i table = _mm256_broadcastsi128_si256(WHHexTable128(uCaseMode)), lo, hi;
+	UINT cb;
+
+	for (cb = 0; cb + 32 <= cbSrc; cb += 32)
+	{
+		__m256i *pDest = (__m256i *)(pszDest + cb * 2);
+
+		WHHexEncode256(_mm256_loadu_si256((const __m256i *)(pbSrc + cb)), table, &lo, &hi);
+		_mm256_storeu_si256(pDest + 0, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(lo)));
+		_mm256_storeu_si256(pDest + 1, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(lo, 1)));
+		_mm256_storeu_si256(pDest + 2, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(hi)));
+		_mm256_storeu_si256(pDest + 3, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(hi, 1)));
+	}
+
+	return(cb + WHHexEncodeSSSE3W(pbSrc + cb, pszDest + cb * 2, cbSrc - cb, uCaseMode));
+}
+
+static UINT WHAPI WHHexDecodeAVX2A( PSTR psz, PBYTE pbDest, UINT cch, BOOL bLowercase )
+{
+	__m256i lower;
+	UINT ich;
+
+	for (ich = 0; ich + 32 <= cch; ich += 32)
+	{
+		if (!WHHexCheck256(_mm256_loadu_si256((const __m256i *)(psz + ich)), &lower))
+			return(ich);
+
+		if (bLowercase)
+			_mm256_storeu_si256((__m256i *)(psz + ich), lower);
+
+		if (pbDest)
+			WHHexDecode256(lower, pbDest + ich / 2);
+	}
+
+	return(ich + WHHexDecodeSSSE3A(psz + ich, (pbDest) ? pbDest + ich / 2 : NULL, cch - ich, bLowercase));
+}
+
+static UINT WHAPI WHHexDecodeAVX2W( PWSTR psz, PBYTE pbDest, UINT cch, BOOL bLowercase )
+{
+	__m256i lower;
+	UINT ich;
+
+	for (ich = 0; ich + 32 <= cch; ich += 32)
+	{
+		__m256i *p = (__m256i *)(psz + ich);
+		__m256i ch = _mm256_packus_epi16(_mm256_loadu_si256(p), _mm256_loadu_si256(p + 1));
+
+		if (!WHHexCheck256(_mm256_permute4x64_epi64(ch, 0xD8), &lower))
+			return(ich);
+
+		if (bLowercase)
+		{
+			_mm256_storeu_si256(p + 0, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(lower)));
+			_mm256_storeu_si256(p + 1, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(lower, 1)));
+		}
+
+		if (pbDest)
+			WHHexDecode256(lower, pbDest + ich / 2);
+	}
+
+	return(ich + WHHexDecodeSSSE3W(psz + ich, (pbDest) ? pbDest + ich / 2 : NULL, cch - ich, bLowercase));
+}
+
+static const WHHEXBACKEND c_hexAVX2 = {
+	WHHexEncodeAVX2A, WHHexEncodeAVX2W, WHHexDecodeAVX2A, WHHexDecodeAVX2W
+};
+
+// The portable variant uses only the scalar loops below
+static const WHKERNEL c_akHex[] = {
+	{ "avx2",       CPUF_AVX2,  0, (PVOID)&c_hexAVX2 },
+	{ "ssse3",      CPUF_SSSE3, 0, (PVOID)&c_hexSSSE3 },
+	{ WHK_PORTABLE, 0,          0, NULL }
+};
+
+WHKERNELSLOT g_ksHex = { "hex", c_akHex, ARRAYSIZE(c_akHex), NULL };
+
+/**
+ * Scalar loops and the public functions, for both character types; cchHex
+ * is counted back to 0 so that an even count marks a high-order nybble
+ **/
+
+#define WH_HEX_FUNCTIONS(XCHAR, X)                                             \
+                                                                               \
+static BOOL WHAPI WHHexDecode##X( XCHAR *psz, PBYTE pbDest, UINT cchHex, BOOL bLowercase ) \
+{                                                                              \
+	PCWHHEXBACKEND pBackend = (PCWHHEXBACKEND)WHBindKernel(&g_ksHex);          \
+                                                                               \
+	/* The kernels start on a high-order nybble */                             \
+	if (pBackend && (!pbDest || !(cchHex & 1)))                                \
+	{                                                                          \
+		/* They also read whole vectors, so they must not be handed more */    \
+		/* than the string holds; callers may ask for more than that (the */   \
+		/* scalar loop below stops at the terminator as a non-hex char) */     \
+		UINT cchString = 0, cch;                                               \
+		while (cchString < (cchHex & ~1U) && psz[cchString])                   \
+			++cchString;                                                       \
+                                                                               \
+		cch = pBackend->pfnDecode##X(psz, pbDest, cchString & ~1U, bLowercase); \
+		psz += cch;                                                            \
+		cchHex -= cch;                                                         \
+		if (pbDest)                                                            \
+			pbDest += cch / 2;                                                 \
+	}                                                                          \
+                                                                               \
+	while (cchHex)                                                             \
+	{                                                                          \
+		XCHAR ch = *psz;                                                       \
+		BYTE hex;                                                              \
+                                                                               \
+		/* Now convert the hex character into a 4-bit nybble */                \
+		if (ch < '0')                                                          \
+		{                                                                      \
+			return(FALSE);                                                     \
+		}                                                                      \
+		else if (ch > '9')                                                     \
+		{                                                                      \
+			/* Ensure that this is lower-case; in UTF-16, anything with a */   \
+			/* nonzero high byte ends up out of range here */                  \
+			ch |= 0x20;                                                        \
+                                                                               \
+			if (ch < 'a') return(FALSE);                                       \
+			if (ch > 'f') return(FALSE);                                       \
+                                                                               \
+			if (bLowercase)                                                    \
+				*psz = ch;                                                     \
+                                                                               \
+			hex = (BYTE)(ch - ('a' - 10));                                     \
+		}                                                                      \
+		else                                                                   \
+		{                                                                      \
+			hex = (BYTE)(ch - '0');                                            \
+		}                                                                      \
+                                                                               \
+		/* Save to the resulting byte array */                                 \
+		if (pbDest)                                                            \
+		{                                                                      \
+			if (!(cchHex & 1))                                                 \
+			{                                                                  \
+				*pbDest = hex << 4;                                            \
+			}                                                                  \
+			else                                                               \
+			{                                                                  \
+				*pbDest |= hex;                                                \
+				++pbDest;                                                      \
+			}                                                                  \
+		}                                                                      \
+                                                                               \
+		++psz;                                                                 \
+		--cchHex;                                                              \
+	}                                                                          \
+                                                                               \
+	return(TRUE);                                                              \
+}                                                                              \
+                                                                               \
+BOOL WHAPI WHHexToByte##X( XCHAR *pszSrc, PBYTE pbDest, UINT cchHex )          \
+{                                                                              \
+	return(WHHexDecode##X(pszSrc, pbDest, cchHex, FALSE));                     \
+}                                                                              \
+                                                                               \
+BOOL WHAPI WHValidateHex##X( XCHAR *psz, UINT cchHex )                         \
+{                                                                              \
+	return(WHHexDecode##X(psz, NULL, cchHex, TRUE));                           \
+}                                                                              \
+                                                                               \
+XCHAR * WHAPI WHByteToHex##X( PCBYTE pbSrc, XCHAR *pszDest, UINT cchHex, UINT8 uCaseMode ) \
+{                                                                              \
+	PCWHHEXBACKEND pBackend = (PCWHHEXBACKEND)WHBindKernel(&g_ksHex);          \
+                                                                               \
+	if (pBackend && !(cchHex & 1))                                             \
+	{                                                                          \
+		UINT cb = pBackend->pfnEncode##X(pbSrc, pszDest, cchHex / 2, uCaseMode); \
+		pbSrc += cb;                                                           \
+		pszDest += cb * 2;                                                     \
+		cchHex -= cb * 2;                                                      \
+	}                                                                          \
+                                                                               \
+	while (cchHex)                                                             \
+	{                                                                          \
+		BYTE hex = *pbSrc;                                                     \
+                                                                               \
+		if (!(cchHex & 1))                                                     \
+			hex >>= 4;                                                         \
+		else                                                                   \
+			++pbSrc;                                                           \
+                                                                               \
+		hex &= 0x0F;                                                           \
+		hex |= 0x30;                                                           \
+                                                                               \
+		if (hex > '9')                                                         \
+		{                                                                      \
+			hex += 'A' - ('0' + 10);                                           \
+			hex |= uCaseMode;                                                  \
+		}                                                                      \
+                                                                               \
+		*pszDest = hex;                                                        \
+                                                                               \
+		++pszDest;                                                             \
+		--cchHex;                                                              \
+	}                                                                          \
+                                                                               \
+	*pszDest = 0;                                                              \
+                                                                               \
+	return(pszDest);                                                           \
+}
+
+WH_HEX_FUNCTIONS(CHAR, A)
+WH_HEX_FUNCTIONS(WCHAR, W)
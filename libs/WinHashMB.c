@@ -0,0 +1,217 @@
+/**
+ * Windows Hashing/Checksumming Library - Multi-Buffer Engine
+ * Last modified: 2026/10/18
+ **/
+
+#include "WinHashMB.h"
+#include "WinHashDispatch.h"
+
+static const WHMBALG c_mbMD5x8 = {
+	8, MD5_BLOCK_LENGTH, WHMB_PAD_MD_LE,
+	MD5MBInitLane, MD5MBTransformAVX2, MD5MBFinalLane
+};
+
+static const WHMBALG c_mbSHA256x8 = {
+	8, SHA256_BLOCK_LENGTH, WHMB_PAD_MD_BE,
+	SHA256MBInitLane, SHA256MBTransformAVX2, SHA256MBFinalLane
+};
+
+#ifdef WHMB_AVX512
+static const WHMBALG c_mbSHA256x16 = {
+	16, SHA256_BLOCK_LENGTH, WHMB_PAD_MD_BE,
+	SHA256MBInitLane, SHA256MBTransformAVX512, SHA256MBFinalLane
+};
+#endif
+
+static const WHMBALG c_mbSHA3_256x4 = {
+	4, SHA3_256_BLOCK_LENGTH, WHMB_PAD_SHA3,
+	SHA3MBInitLane, SHA3_256MBTransformAVX2, SHA3_256MBFinalLane
+};
+
+static const WHMBALG c_mbSHA3_512x4 = {
+	4, SHA3_512_BLOCK_LENGTH, WHMB_PAD_SHA3,
+	SHA3MBInitLane, SHA3_512MBTransformAVX2, SHA3_512MBFinalLane
+};
+
+// The portable variant of each slot is to not use the multi-buffer engine
+static const WHKERNEL c_akMD5MB[] = {
+	{ "avx2",       CPUF_AVX2,    0,        (PVOID)&c_mbMD5x8 },
+	{ WHK_PORTABLE, 0,            0,        NULL }
+};
+
+static const WHKERNEL c_akSHA256MB[] = {
+#ifdef WHMB_AVX512
+	{ "avx512",     CPUF_AVX512F, 0,        (PVOID)&c_mbSHA256x16 },
+#endif
+	// With SHA-NI, a single stream already keeps up with eight AVX2 lanes
+	{ "avx2",       CPUF_AVX2,    CPUF_SHA, (PVOID)&c_mbSHA256x8 },
+	{ WHK_PORTABLE, 0,            0,        NULL }
+};
+
+static const WHKERNEL c_akSHA3_256MB[] = {
+	{ "avx2",       CPUF_AVX2,    0,        (PVOID)&c_mbSHA3_256x4 },
+	{ WHK_PORTABLE, 0,            0,        NULL }
+};
+
+static const WHKERNEL c_akSHA3_512MB[] = {
+	{ "avx2",       CPUF_AVX2,    0,        (PVOID)&c_mbSHA3_512x4 },
+	{ WHK_PORTABLE, 0,            0,        NULL }
+};
+
+WHKERNELSLOT g_ksMD5MB = { "md5mb", c_akMD5MB, ARRAYSIZE(c_akMD5MB), NULL };
+WHKERNELSLOT g_ksSHA256MB = { "sha256mb", c_akSHA256MB, ARRAYSIZE(c_akSHA256MB), NULL };
+WHKERNELSLOT g_ksSHA3_256MB = { "sha3-256mb", c_akSHA3_256MB, ARRAYSIZE(c_akSHA3_256MB), NULL };
+WHKERNELSLOT g_ksSHA3_512MB = { "sha3-512mb", c_akSHA3_512MB, ARRAYSIZE(c_akSHA3_512MB), NULL };
+
+static PCWHMBALG WHAPI WHMBSelect( UINT uAlgorithm )
+{
+	switch (uAlgorithm)
+	{
+		case MD5:      return((PCWHMBALG)WHBindKernel(&g_ksMD5MB));
+		case SHA256:   return((PCWHMBALG)WHBindKernel(&g_ksSHA256MB));
+		case SHA3_256: return((PCWHMBALG)WHBindKernel(&g_ksSHA3_256MB));
+		case SHA3_512: return((PCWHMBALG)WHBindKernel(&g_ksSHA3_512MB));
+	}
+
+	return(NULL);
+}
+
+BOOL WHAPI WHMBIsAvailable( UINT uAlgorithm )
+{
+	return(WHMBSelect(uAlgorithm) != NULL);
+}
+
+BOOL WHAPI WHMBInit( PWHMBMGR pMgr, UINT uAlgorithm )
+{
+	UINT iLane;
+
+	if (!(pMgr->pAlg = WHMBSelect(uAlgorithm)))
+		return(FALSE);
+
+	for (iLane = 0; iLane < WHMB_MAX_LANES; ++iLane)
+		pMgr->pJobs[iLane] = NULL;
+
+	pMgr->cActive = 0;
+	return(TRUE);
+}
+
+/**
+ * Runs the busy lanes until one of them finishes, and returns its job
+ **/
+
+static PWHMBJOB WHAPI WHMBRun( PWHMBMGR pMgr )
+{
+	PCWHMBALG pAlg = pMgr->pAlg;
+	UINT cLanes = pAlg->cLanes;
+
+	for (;;)
+	{
+		PWHMBJOB pJob;
+		UINT iLane, iShortest = 0, cBlocks = MAXUINT;
+
+		// Find the busy lane that is closest to the end of its current run
+		for (iLane = 0; iLane < cLanes; ++iLane)
+		{
+			if (pMgr->pJobs[iLane] && pMgr->cBlocks[iLane] < cBlocks)
+			{
+				iShortest = iLane;
+				cBlocks = pMgr->cBlocks[iLane];
+			}
+		}
+
+		if (cBlocks == 0)
+		{
+			if (pMgr->cTailBlocks[iShortest])
+			{
+				// The body of the message is done, so continue with the padding
+				pMgr->ppbData[iShortest] = pMgr->tail[iShortest];
+				pMgr->cBlocks[iShortest] = pMgr->cTailBlocks[iShortest];
+				pMgr->cTailBlocks[iShortest] = 0;
+				continue;
+			}
+
+			pJob = pMgr->pJobs[iShortest];
+			pAlg->pfnFinalLane(pMgr->state, cLanes, iShortest, pJob->digest);
+			pMgr->pJobs[iShortest] = NULL;
+			--pMgr->cActive;
+			return(pJob);
+		}
+
+		// Idle lanes trail along on the shortest lane's data, so that every
+		// pointer that the kernel reads from is valid for cBlocks blocks; the
+		// state of an idle lane is reinitialized when it receives its next job
+		for (iLane = 0; iLane < cLanes; ++iLane)
+		{
+			if (!pMgr->pJobs[iLane])
+				pMgr->ppbData[iLane] = pMgr->ppbData[iShortest];
+		}
+
+		pAlg->pfnTransform(pMgr->state, pMgr->ppbData, cBlocks);
+
+		for (iLane = 0; iLane < cLanes; ++iLane)
+		{
+			if (pMgr->pJobs[iLane])
+			{
+				pMgr->ppbData[iLane] += cBlocks * pAlg->cbBlock;
+				pMgr->cBlocks[iLane] -= cBlocks;
+			}
+		}
+	}
+}
+
+PWHMBJOB WHAPI WHMBSubmit( PWHMBMGR pMgr, PWHMBJOB pJob )
+{
+	PCWHMBALG pAlg = pMgr->pAlg;
+	UINT cbBlock = pAlg->cbBlock;
+	UINT cbRemainder = pJob->cbData % cbBlock;
+	UINT cbTail, iLane, i;
+	UINT64 cBits = (UINT64)pJob->cbData << 3;
+	PBYTE pbTail;
+
+	// WHMBSubmit never returns while all the lanes are busy
+	for (iLane = 0; pMgr->pJobs[iLane]; ++iLane);
+
+	// Pad the final partial block (plus one more block if the bit count
+	// does not fit) in the lane's own tail buffer
+	pbTail = pMgr->tail[iLane];
+	memcpy(pbTail, pJob->pbData + pJob->cbData - cbRemainder, cbRemainder);
+
+	if (pAlg->uPadding == WHMB_PAD_SHA3)
+	{
+		// The suffix and the final 1 bit may share the last byte of the block
+		cbTail = cbBlock;
+		memset(pbTail + cbRemainder, 0, cbTail - cbRemainder);
+		pbTail[cbRemainder] = 0x06;
+		pbTail[cbTail - 1] |= 0x80;
+	}
+	else
+	{
+		cbTail = (cbRemainder + 1 + sizeof(cBits) > cbBlock) ? cbBlock * 2 : cbBlock;
+		pbTail[cbRemainder] = 0x80;
+		memset(pbTail + cbRemainder + 1, 0, cbTail - cbRemainder - 1);
+
+		for (i = 0; i < sizeof(cBits); ++i)
+		{
+			if (pAlg->uPadding == WHMB_PAD_MD_BE)
+				pbTail[cbTail - 1 - i] = (BYTE)(cBits >> (i << 3));
+			else
+				pbTail[cbTail - sizeof(cBits) + i] = (BYTE)(cBits >> (i << 3));
+		}
+	}
+
+	pAlg->pfnInitLane(pMgr->state, pAlg->cLanes, iLane);
+	pMgr->ppbData[iLane] = pJob->pbData;
+	pMgr->cBlocks[iLane] = pJob->cbData / cbBlock;
+	pMgr->cTailBlocks[iLane] = cbTail / cbBlock;
+	pMgr->pJobs[iLane] = pJob;
+
+	if (++pMgr->cActive < pAlg->cLanes)
+		return(NULL);
+
+	return(WHMBRun(pMgr));
+}
+
+PWHMBJOB WHAPI WHMBFlush( PWHMBMGR pMgr )
+{
+	return((pMgr->cActive) ? WHMBRun(pMgr) : NULL);
+}
@@ -0,0 +1,108 @@
+/**
+ * Windows Hashing/Checksumming Library - Multi-Buffer Engine
+ * Last modified: 2026/10/18
+ *
+ * Hashes several independent messages at once, one per SIMD lane, so that
+ * batches of small files can make use of the full vector width even though
+ * each individual message is a strictly serial chain of block transforms.
+ *
+ * A job is submitted once its complete message is in memory.  WHMBSubmit
+ * returns NULL for as long as there are idle lanes; once every lane is busy,
+ * it runs the lanes until one of them finishes and returns that job.  When
+ * there is nothing left to submit, WHMBFlush is called repeatedly to drain
+ * the remaining jobs, and returns NULL once all the lanes are idle.
+ **/
+
+#ifndef __WINHASHMB_H__
+#define __WINHASHMB_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "WinHash.h"
+
+// AVX-512 intrinsics are only available starting with Visual Studio 2017 15.3
+#if _MSC_VER >= 1911
+#define WHMB_AVX512
+#endif
+
+#define WHMB_MAX_LANES        16
+#define WHMB_MAX_BLOCK_LENGTH SHA3_256_BLOCK_LENGTH
+#define WHMB_STATE_SIZE       (4 * 25 * sizeof(UINT64))  // four Keccak-p[1600] states
+
+// Message padding schemes
+#define WHMB_PAD_MD_BE        1  // Merkle-Damgard, big-endian bit count (SHA-2)
+#define WHMB_PAD_MD_LE        2  // Merkle-Damgard, little-endian bit count (MD5)
+#define WHMB_PAD_SHA3         3  // SHA3 domain suffix and pad10*1
+
+typedef struct {
+	PCBYTE pbData;                   // complete message, valid until the job is returned
+	UINT   cbData;                   // length of the message
+	PVOID  pvUser;                   // for use by the caller
+	BYTE   digest[MAX_DIGEST_LENGTH];// result, set when the job is returned
+} WHMBJOB, *PWHMBJOB;
+
+// The state is stored transposed, so each kernel knows how to reach one lane
+typedef VOID (WHAPI *PFNWHMBINITLANE)( PVOID pvState, UINT cLanes, UINT iLane );
+typedef VOID (WHAPI *PFNWHMBTRANSFORM)( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks );
+typedef VOID (WHAPI *PFNWHMBFINALLANE)( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest );
+
+typedef struct {
+	UINT             cLanes;         // number of messages hashed side by side
+	UINT             cbBlock;        // block length of the algorithm
+	UINT             uPadding;       // one of WHMB_PAD_*
+	PFNWHMBINITLANE  pfnInitLane;
+	PFNWHMBTRANSFORM pfnTransform;   // transforms cBlocks consecutive blocks in every lane
+	PFNWHMBFINALLANE pfnFinalLane;
+} WHMBALG, *PWHMBALG;
+
+typedef const WHMBALG *PCWHMBALG;
+
+typedef struct {
+	__declspec(align(64)) BYTE state[WHMB_STATE_SIZE];
+	__declspec(align(64)) BYTE tail[WHMB_MAX_LANES][WHMB_MAX_BLOCK_LENGTH * 2];
+	PCBYTE    ppbData[WHMB_MAX_LANES];     // next block to transform, per lane
+	UINT      cBlocks[WHMB_MAX_LANES];     // blocks left in the current run, per lane
+	UINT      cTailBlocks[WHMB_MAX_LANES]; // padded tail blocks, or 0 once in the tail
+	PWHMBJOB  pJobs[WHMB_MAX_LANES];       // job being hashed, or NULL if the lane is idle
+	UINT      cActive;                     // number of busy lanes
+	PCWHMBALG pAlg;
+} WHMBMGR, *PWHMBMGR;
+
+// Returns FALSE if this processor has no multi-buffer kernel for uAlgorithm
+BOOL WHAPI WHMBInit( PWHMBMGR pMgr, UINT uAlgorithm );
+PWHMBJOB WHAPI WHMBSubmit( PWHMBMGR pMgr, PWHMBJOB pJob );
+PWHMBJOB WHAPI WHMBFlush( PWHMBMGR pMgr );
+
+#define WHMBLanes(pMgr) ((pMgr)->pAlg->cLanes)
+
+// Returns TRUE if WHMBInit would succeed for uAlgorithm
+BOOL WHAPI WHMBIsAvailable( UINT uAlgorithm );
+
+/**
+ * Kernels, see md5_mb.c, sha256_mb.c, and sha3_mb.c
+ **/
+
+VOID WHAPI MD5MBInitLane( PVOID pvState, UINT cLanes, UINT iLane );
+VOID WHAPI MD5MBFinalLane( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest );
+VOID WHAPI MD5MBTransformAVX2( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks );
+
+VOID WHAPI SHA256MBInitLane( PVOID pvState, UINT cLanes, UINT iLane );
+VOID WHAPI SHA256MBFinalLane( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest );
+VOID WHAPI SHA256MBTransformAVX2( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks );
+#ifdef WHMB_AVX512
+VOID WHAPI SHA256MBTransformAVX512( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks );
+#endif
+
+VOID WHAPI SHA3MBInitLane( PVOID pvState, UINT cLanes, UINT iLane );
+VOID WHAPI SHA3_256MBFinalLane( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest );
+VOID WHAPI SHA3_256MBTransformAVX2( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks );
+VOID WHAPI SHA3_512MBFinalLane( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest );
+VOID WHAPI SHA3_512MBTransformAVX2( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,197 @@
+/**
+ * Windows Hashing/Checksumming Library - Multi-Algorithm Pipeline
+ * Last modified: 2026/10/18
+ **/
+
+#include "WinHashPipe.h"
+#include <stdlib.h>
+#include <process.h>
+
+#define WHPIPE_STACK_SIZE 0x1000
+
+typedef struct {
+	PBYTE         pbData;
+	UINT          cbData;
+	PWHCTXEX      pContext;     // NULL asks the algorithm threads to exit
+	volatile LONG cRefs;        // algorithm threads still to process this buffer
+} WHPIPEBUFFER, *PWHPIPEBUFFER;
+
+typedef struct {
+	PWHPIPE pPipe;
+	DWORD   dwFlags;            // the algorithm, or stitched pair, to update
+	HANDLE  hThread;
+	HANDLE  hReady;             // counts the submitted buffers not yet taken
+	UINT    iNext;              // next buffer to take
+} WHPIPEWORKER, *PWHPIPEWORKER;
+
+struct _WHPIPE {
+	WHPIPEBUFFER ring[WHPIPE_BUFFERS];
+	WHPIPEWORKER workers[NUM_HASHES];
+	UINT         cWorkers;
+	HANDLE       hFree;         // counts the buffers which may be refilled
+	UINT         iNext;         // next buffer to fill
+	PBYTE        pbBuffers;
+};
+
+static unsigned __stdcall WHPipeThread( PVOID pvParam )
+{
+	PWHPIPEWORKER pWorker = (PWHPIPEWORKER)pvParam;
+	PWHPIPE pPipe = pWorker->pPipe;
+
+	for (;;)
+	{
+		PWHPIPEBUFFER pBuffer;
+		PWHCTXEX pContext;
+		DWORD dwFlags;
+
+		WaitForSingleObject(pWorker->hReady, INFINITE);
+
+		pBuffer = &pPipe->ring[pWorker->iNext];
+		pWorker->iNext = (pWorker->iNext + 1) % WHPIPE_BUFFERS;
+
+		if (!(pContext = pBuffer->pContext))
+			break;
+
+		// A context may ask for only one half of a stitched pair
+		dwFlags = pContext->dwFlags & pWorker->dwFlags;
+
+		if (dwFlags == WH_STITCH_MD5SHA1)
+			MD5SHA1Update(&pContext->ctxMD5, &pContext->ctxSHA1, pBuffer->pbData, pBuffer->cbData);
+		else if (dwFlags == WH_STITCH_SHA256CRC32)
+			SHA256CRC32Update(&pContext->ctxSHA256, &pContext->ctxCRC32.state, pBuffer->pbData, pBuffer->cbData);
+		else
+		{
+#define WHPIPE_UPDATE_op(alg)                                                  \
+			if (dwFlags & WHEX_CHECK##alg)                                     \
+				WHUpdate##alg(&pContext->ctx##alg, pBuffer->pbData, pBuffer->cbData);
+			FOR_EACH_HASH(WHPIPE_UPDATE_op)
+		}
+
+		// Buffers are always released in ring order, since every thread
+		// takes every buffer in ring order
+		if (InterlockedDecrement(&pBuffer->cRefs) == 0)
+			ReleaseSemaphore(pPipe->hFree, 1, NULL);
+	}
+
+	return(0);
+}
+
+PWHPIPE WHAPI WHPipeCreate( DWORD dwFlags, UINT cbBuffer )
+{
+	PWHPIPE pPipe;
+	DWORD adwWorkers[NUM_HASHES];  // the flags of each thread to start
+	DWORD dwSeparate = dwFlags;
+	UINT cWorkers = 0, i;
+
+	if (!(pPipe = (PWHPIPE)calloc(1, sizeof(WHPIPE))))
+		return(NULL);
+
+	if ( !(pPipe->pbBuffers = (PBYTE)VirtualAlloc(NULL, (SIZE_T)cbBuffer * WHPIPE_BUFFERS, MEM_COMMIT, PAGE_READWRITE)) ||
+	     !(pPipe->hFree = CreateSemaphore(NULL, WHPIPE_BUFFERS, WHPIPE_BUFFERS, NULL)) )
+	{
+		WHPipeDestroy(pPipe);
+		return(NULL);
+	}
+
+	for (i = 0; i < WHPIPE_BUFFERS; ++i)
+		pPipe->ring[i].pbData = pPipe->pbBuffers + (SIZE_T)cbBuffer * i;
+
+	// The stitched pairs get one thread each, and every other algorithm its own
+	if ((dwFlags & WH_STITCH_MD5SHA1) == WH_STITCH_MD5SHA1)
+	{
+		adwWorkers[cWorkers++] = WH_STITCH_MD5SHA1;
+		dwSeparate &= ~WH_STITCH_MD5SHA1;
+	}
+	if ((dwFlags & WH_STITCH_SHA256CRC32) == WH_STITCH_SHA256CRC32)
+	{
+		adwWorkers[cWorkers++] = WH_STITCH_SHA256CRC32;
+		dwSeparate &= ~WH_STITCH_SHA256CRC32;
+	}
+
+	for (i = 0; i < NUM_HASHES; ++i)
+	{
+		if (dwSeparate & (1UL << i))
+			adwWorkers[cWorkers++] = 1UL << i;
+	}
+
+	for (i = 0; i < cWorkers; ++i)
+	{
+		PWHPIPEWORKER pWorker = &pPipe->workers[pPipe->cWorkers];
+
+		pWorker->pPipe = pPipe;
+		pWorker->dwFlags = adwWorkers[i];
+
+		if ( !(pWorker->hReady = CreateSemaphore(NULL, 0, WHPIPE_BUFFERS, NULL)) ||
+		     !(pWorker->hThread = (HANDLE)_beginthreadex(NULL, WHPIPE_STACK_SIZE, WHPipeThread, pWorker, 0, NULL)) )
+		{
+			if (pWorker->hReady)
+				CloseHandle(pWorker->hReady);
+
+			WHPipeDestroy(pPipe);
+			return(NULL);
+		}
+
+		++pPipe->cWorkers;
+	}
+
+	return(pPipe);
+}
+
+VOID WHAPI WHPipeDestroy( PWHPIPE pPipe )
+{
+	UINT i;
+
+	if (pPipe->cWorkers)
+	{
+		// An empty buffer tells the threads to exit
+		WHPipeGetBuffer(pPipe);
+		WHPipeSubmit(pPipe, NULL, 0);
+
+		for (i = 0; i < pPipe->cWorkers; ++i)
+		{
+			WaitForSingleObject(pPipe->workers[i].hThread, INFINITE);
+			CloseHandle(pPipe->workers[i].hThread);
+			CloseHandle(pPipe->workers[i].hReady);
+		}
+	}
+
+	if (pPipe->hFree)
+		CloseHandle(pPipe->hFree);
+
+	if (pPipe->pbBuffers)
+		VirtualFree(pPipe->pbBuffers, 0, MEM_RELEASE);
+
+	free(pPipe);
+}
+
+PBYTE WHAPI WHPipeGetBuffer( PWHPIPE pPipe )
+{
+	WaitForSingleObject(pPipe->hFree, INFINITE);
+	return(pPipe->ring[pPipe->iNext].pbData);
+}
+
+VOID WHAPI WHPipeSubmit( PWHPIPE pPipe, PWHCTXEX pContext, UINT cbData )
+{
+	PWHPIPEBUFFER pBuffer = &pPipe->ring[pPipe->iNext];
+	UINT i;
+
+	pPipe->iNext = (pPipe->iNext + 1) % WHPIPE_BUFFERS;
+
+	pBuffer->cbData = cbData;
+	pBuffer->pContext = pContext;
+	pBuffer->cRefs = pPipe->cWorkers;
+
+	for (i = 0; i < pPipe->cWorkers; ++i)
+		ReleaseSemaphore(pPipe->workers[i].hReady, 1, NULL);
+}
+
+VOID WHAPI WHPipeWait( PWHPIPE pPipe )
+{
+	UINT i;
+
+	// Once every buffer is free again, all the work has been done
+	for (i = 0; i < WHPIPE_BUFFERS; ++i)
+		WaitForSingleObject(pPipe->hFree, INFINITE);
+
+	ReleaseSemaphore(pPipe->hFree, WHPIPE_BUFFERS, NULL);
+}
@@ -0,0 +1,51 @@
+/**
+ * Windows Hashing/Checksumming Library - Multi-Algorithm Pipeline
+ * Last modified: 2026/10/18
+ *
+ * Hashes one stream with several algorithms at once, using a long-lived
+ * thread per algorithm.  The reader fills buffers from a small ring and
+ * hands each one to every algorithm thread; a buffer is reused once the
+ * last of them is done with it, so each algorithm runs at its own pace,
+ * and the reader waits only if the slowest one falls a full ring behind.
+ *
+ *     pb = WHPipeGetBuffer(pPipe);     // repeatedly: fill and submit
+ *     WHPipeSubmit(pPipe, pwhctx, cb);
+ *     ...
+ *     WHPipeWait(pPipe);               // then pwhctx can be finished
+ *
+ * pwhctx must have been initialized with WHInitEx, and its dwFlags must be
+ * a subset of those that the pipeline was created with.
+ **/
+
+#ifndef __WINHASHPIPE_H__
+#define __WINHASHPIPE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "WinHash.h"
+
+#define WHPIPE_BUFFERS 8  // number of buffers in the ring
+
+typedef struct _WHPIPE WHPIPE, *PWHPIPE;
+
+// Starts a thread for each algorithm in dwFlags, or for each stitched pair
+// (WH_STITCH_*) of them; returns NULL on failure
+PWHPIPE WHAPI WHPipeCreate( DWORD dwFlags, UINT cbBuffer );
+VOID WHAPI WHPipeDestroy( PWHPIPE pPipe );
+
+// Waits until the next buffer in the ring is free, and returns it
+PBYTE WHAPI WHPipeGetBuffer( PWHPIPE pPipe );
+
+// Hands the buffer returned by WHPipeGetBuffer to the algorithm threads
+VOID WHAPI WHPipeSubmit( PWHPIPE pPipe, PWHCTXEX pContext, UINT cbData );
+
+// Waits until every submitted buffer has been hashed by every algorithm
+VOID WHAPI WHPipeWait( PWHPIPE pPipe );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
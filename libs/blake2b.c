@@ -0,0 +1,375 @@
+/**
+ * BLAKE2b and BLAKE2bp
+ * Last modified: 2026/10/18
+ *
+ * An implementation of BLAKE2b (RFC 7693) and of its 4-way parallel variant
+ * BLAKE2bp, both unkeyed and with the full 512-bit output, producing the same
+ * digests as b2sum and b2sum -a blake2bp.  BLAKE2b is built on 64-bit words,
+ * so even the portable code below outruns SHA-512 on 64-bit processors.
+ *
+ * BLAKE2bp splits the input into 128-byte blocks which are dealt round-robin
+ * to four BLAKE2b leaves, and then hashes the leaves' digests with a fifth
+ * BLAKE2b root.  Since the leaves always advance together, the AVX2 kernel
+ * below keeps one leaf in each 64-bit lane and compresses all four at once.
+ **/
+
+#include "WinHash.h"
+#include "WinHashDispatch.h"
+#include <immintrin.h>
+#include <intrin.h>
+
+#define BLAKE2BP_STRIPE_LENGTH (BLAKE2BP_PARALLELISM * BLAKE2B_BLOCK_LENGTH)
+
+static const UINT64 IV[8] = {
+	0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL, 0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL,
+	0x510E527FADE682D1ULL, 0x9B05688C2B3E6C1FULL, 0x1F83D9ABFB41BD6BULL, 0x5BE0CD19137E2179ULL
+};
+
+static const BYTE SIGMA[12][16] = {
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+	{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+	{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+	{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+	{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+	{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+	{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+	{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+	{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+};
+
+// Compresses cStripes whole stripes into the four leaves, none of which may
+// hold a leaf's last block; counter is the byte count of each leaf so far
+typedef VOID (WHAPI *PFNBLAKE2BPCOMPRESS)( UINT64 h[BLAKE2BP_PARALLELISM][8], PCBYTE pbIn,
+                                           SIZE_T cStripes, UINT64 counter );
+
+/**
+ * Portable compression function
+ **/
+
+#define G(a, b, c, d, x, y)                            \
+	a = a + b + (x); d = RotRV64(d ^ a, 32);           \
+	c = c + d;       b = RotRV64(b ^ c, 24);           \
+	a = a + b + (y); d = RotRV64(d ^ a, 16);           \
+	c = c + d;       b = RotRV64(b ^ c, 63);
+
+static VOID Blake2bCompress( UINT64 h[8], const BYTE block[BLAKE2B_BLOCK_LENGTH],
+                             UINT64 counter, UINT64 f0, UINT64 f1 )
+{
+	UINT64 m[16], v[16];
+	UINT r, i;
+
+	// x86 is little-endian, as are the message words
+	memcpy(m, block, sizeof(m));
+
+	memcpy(v, h, 8 * sizeof(UINT64));
+	memcpy(v + 8, IV, 8 * sizeof(UINT64));
+	v[12] ^= counter;  // the high word of the 128-bit counter is always 0
+	v[14] ^= f0;
+	v[15] ^= f1;
+
+	for (r = 0; r < 12; ++r)
+	{
+		const BYTE *s = SIGMA[r];
+
+		G(v[0], v[4], v[ 8], v[12], m[s[ 0]], m[s[ 1]]);
+		G(v[1], v[5], v[ 9], v[13], m[s[ 2]], m[s[ 3]]);
+		G(v[2], v[6], v[10], v[14], m[s[ 4]], m[s[ 5]]);
+		G(v[3], v[7], v[11], v[15], m[s[ 6]], m[s[ 7]]);
+		G(v[0], v[5], v[10], v[15], m[s[ 8]], m[s[ 9]]);
+		G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+		G(v[2], v[7], v[ 8], v[13], m[s[12]], m[s[13]]);
+		G(v[3], v[4], v[ 9], v[14], m[s[14]], m[s[15]]);
+	}
+
+	for (i = 0; i < 8; ++i)
+		h[i] ^= v[i] ^ v[i + 8];
+}
+
+// Compresses the last cbIn bytes (up to two blocks) of a message whose first
+// counter bytes have already been compressed; an empty message still gets
+// one (empty) last block
+static VOID Blake2bCompressTail( UINT64 h[8], UINT64 counter, PCBYTE pbIn, UINT cbIn, UINT64 f1 )
+{
+	BYTE block[BLAKE2B_BLOCK_LENGTH];
+
+	while (cbIn > BLAKE2B_BLOCK_LENGTH)
+	{
+		counter += BLAKE2B_BLOCK_LENGTH;
+		Blake2bCompress(h, pbIn, counter, 0, 0);
+		pbIn += BLAKE2B_BLOCK_LENGTH;
+		cbIn -= BLAKE2B_BLOCK_LENGTH;
+	}
+
+	memcpy(block, pbIn, cbIn);
+	memset(block + cbIn, 0, sizeof(block) - cbIn);
+	Blake2bCompress(h, block, counter + cbIn, ~0ULL, f1);
+}
+
+// Sets up the state from the parameter block of an unkeyed BLAKE2b with a
+// 512-bit output; a sequential hash has a fanout and depth of 1
+static VOID Blake2bInitParam( UINT64 h[8], BYTE fanout, BYTE depth, UINT64 nodeOffset, BYTE nodeDepth, BYTE cbInner )
+{
+	memcpy(h, IV, sizeof(IV));
+	h[0] ^= BLAKE2B_DIGEST_LENGTH | (UINT64)fanout << 16 | (UINT64)depth << 24;
+	h[1] ^= nodeOffset;
+	h[2] ^= nodeDepth | (UINT64)cbInner << 8;
+}
+
+static VOID WHAPI Blake2bpCompressC( UINT64 h[BLAKE2BP_PARALLELISM][8], PCBYTE pbIn,
+                                     SIZE_T cStripes, UINT64 counter )
+{
+	UINT i;
+
+	while (cStripes--)
+	{
+		counter += BLAKE2B_BLOCK_LENGTH;
+
+		for (i = 0; i < BLAKE2BP_PARALLELISM; ++i)
+			Blake2bCompress(h[i], pbIn + i * BLAKE2B_BLOCK_LENGTH, counter, 0, 0);
+
+		pbIn += BLAKE2BP_STRIPE_LENGTH;
+	}
+}
+
+/**
+ * AVX2: the 4 leaves of BLAKE2bp at a time
+ **/
+
+#define ROT32_256(x) _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1))
+#define ROT24_256(x) _mm256_shuffle_epi8(x, _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, \
+                                                             3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10))
+#define ROT16_256(x) _mm256_shuffle_epi8(x, _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, \
+                                                             2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9))
+#define ROT63_256(x) _mm256_or_si256(_mm256_srli_epi64(x, 63), _mm256_add_epi64(x, x))
+
+#define G4(a, b, c, d, x, y)                                                            \
+	a = _mm256_add_epi64(_mm256_add_epi64(a, b), x); d = ROT32_256(_mm256_xor_si256(d, a)); \
+	c = _mm256_add_epi64(c, d);                      b = ROT24_256(_mm256_xor_si256(b, c)); \
+	a = _mm256_add_epi64(_mm256_add_epi64(a, b), y); d = ROT16_256(_mm256_xor_si256(d, a)); \
+	c = _mm256_add_epi64(c, d);                      b = ROT63_256(_mm256_xor_si256(b, c));
+
+// Transposes the 4x4 matrix of 64-bit words in v[0..3]
+__forceinline VOID Blake2bTranspose4( __m256i v[4] )
+{
+	__m256i t0 = _mm256_unpacklo_epi64(v[0], v[1]);
+	__m256i t1 = _mm256_unpackhi_epi64(v[0], v[1]);
+	__m256i t2 = _mm256_unpacklo_epi64(v[2], v[3]);
+	__m256i t3 = _mm256_unpackhi_epi64(v[2], v[3]);
+
+	v[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+	v[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+	v[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+	v[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+static VOID WHAPI Blake2bpCompressAVX2( UINT64 h[BLAKE2BP_PARALLELISM][8], PCBYTE pbIn,
+                                        SIZE_T cStripes, UINT64 counter )
+{
+	__m256i hv[8], v[16], m[16];
+	UINT r, i, j;
+
+	// Transpose the leaves' states so that each vector holds one word of
+	// every leaf, and the same for the message words below
+	for (j = 0; j < 8; j += 4)
+	{
+		for (i = 0; i < 4; ++i)
+			hv[j + i] = _mm256_loadu_si256((const __m256i *)(h[i] + j));
+
+		Blake2bTranspose4(hv + j);
+	}
+
+	while (cStripes--)
+	{
+		counter += BLAKE2B_BLOCK_LENGTH;
+
+		for (j = 0; j < 16; j += 4)
+		{
+			for (i = 0; i < 4; ++i)
+				m[j + i] = _mm256_loadu_si256((const __m256i *)(pbIn + i * BLAKE2B_BLOCK_LENGTH + j * 8));
+
+			Blake2bTranspose4(m + j);
+		}
+
+		for (i = 0; i < 8; ++i)
+		{
+			v[i] = hv[i];
+			v[i + 8] = _mm256_set1_epi64x((INT64)IV[i]);
+		}
+		v[12] = _mm256_xor_si256(v[12], _mm256_set1_epi64x((INT64)counter));
+
+		for (r = 0; r < 12; ++r)
+		{
+			const BYTE *s = SIGMA[r];
+
+			G4(v[0], v[4], v[ 8], v[12], m[s[ 0]], m[s[ 1]]);
+			G4(v[1], v[5], v[ 9], v[13], m[s[ 2]], m[s[ 3]]);
+			G4(v[2], v[6], v[10], v[14], m[s[ 4]], m[s[ 5]]);
+			G4(v[3], v[7], v[11], v[15], m[s[ 6]], m[s[ 7]]);
+			G4(v[0], v[5], v[10], v[15], m[s[ 8]], m[s[ 9]]);
+			G4(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+			G4(v[2], v[7], v[ 8], v[13], m[s[12]], m[s[13]]);
+			G4(v[3], v[4], v[ 9], v[14], m[s[14]], m[s[15]]);
+		}
+
+		for (i = 0; i < 8; ++i)
+			hv[i] = _mm256_xor_si256(hv[i], _mm256_xor_si256(v[i], v[i + 8]));
+
+		pbIn += BLAKE2BP_STRIPE_LENGTH;
+	}
+
+	for (j = 0; j < 8; j += 4)
+	{
+		Blake2bTranspose4(hv + j);
+
+		for (i = 0; i < 4; ++i)
+			_mm256_storeu_si256((__m256i *)(h[i] + j), hv[j + i]);
+	}
+}
+
+static const WHKERNEL c_akBLAKE2BP[] = {
+	{ "avx2",       CPUF_AVX2, 0, (PVOID)Blake2bpCompressAVX2 },
+	{ WHK_PORTABLE, 0,         0, (PVOID)Blake2bpCompressC }
+};
+
+WHKERNELSLOT g_ksBLAKE2BP = { "blake2bp", c_akBLAKE2BP, ARRAYSIZE(c_akBLAKE2BP), NULL };
+
+/**
+ * Public functions
+ **/
+
+void BLAKE2bInit( PBLAKE2B_CTX pContext )
+{
+	Blake2bInitParam(pContext->h, 1, 1, 0, 0, 0);
+	pContext->counter = 0;
+	pContext->cbBuffer = 0;
+}
+
+void BLAKE2bUpdate( PBLAKE2B_CTX pContext, PCBYTE pbIn, UINT cbIn )
+{
+	UINT cbFill;
+
+	// The last block is compressed differently, so a whole block is kept back
+	// in the buffer until more input follows it
+	if (cbIn > BLAKE2B_BLOCK_LENGTH - pContext->cbBuffer)
+	{
+		cbFill = BLAKE2B_BLOCK_LENGTH - pContext->cbBuffer;
+		memcpy(pContext->buffer + pContext->cbBuffer, pbIn, cbFill);
+		pContext->counter += BLAKE2B_BLOCK_LENGTH;
+		Blake2bCompress(pContext->h, pContext->buffer, pContext->counter, 0, 0);
+		pContext->cbBuffer = 0;
+		pbIn += cbFill;
+		cbIn -= cbFill;
+
+		while (cbIn > BLAKE2B_BLOCK_LENGTH)
+		{
+			pContext->counter += BLAKE2B_BLOCK_LENGTH;
+			Blake2bCompress(pContext->h, pbIn, pContext->counter, 0, 0);
+			pbIn += BLAKE2B_BLOCK_LENGTH;
+			cbIn -= BLAKE2B_BLOCK_LENGTH;
+		}
+	}
+
+	memcpy(pContext->buffer + pContext->cbBuffer, pbIn, cbIn);
+	pContext->cbBuffer += cbIn;
+}
+
+void BLAKE2bFinal( PBLAKE2B_CTX pContext )
+{
+	Blake2bCompressTail(pContext->h, pContext->counter, pContext->buffer, pContext->cbBuffer, 0);
+	memcpy(pContext->result, pContext->h, BLAKE2B_DIGEST_LENGTH);
+}
+
+void BLAKE2bpInit( PBLAKE2BP_CTX pContext )
+{
+	UINT i;
+
+	for (i = 0; i < BLAKE2BP_PARALLELISM; ++i)
+		Blake2bInitParam(pContext->h[i], BLAKE2BP_PARALLELISM, 2, i, 0, BLAKE2B_DIGEST_LENGTH);
+
+	pContext->counter = 0;
+	pContext->cbBuffer = 0;
+}
+
+void BLAKE2bpUpdate( PBLAKE2BP_CTX pContext, PCBYTE pbIn, UINT cbIn )
+{
+	PFNBLAKE2BPCOMPRESS pfnCompress;
+	UINT cbFill;
+	SIZE_T cStripes;
+
+	// Each leaf keeps back its last block like BLAKE2b does, but until the
+	// input ends, that block could be in either of the last two stripes (the
+	// last stripe may hold none of the last leaf's input), so two whole
+	// stripes are kept back in the buffer
+	if (cbIn <= BLAKE2BP_BUFFER_LENGTH - pContext->cbBuffer)
+	{
+		memcpy(pContext->buffer + pContext->cbBuffer, pbIn, cbIn);
+		pContext->cbBuffer += cbIn;
+		return;
+	}
+
+	pfnCompress = (PFNBLAKE2BPCOMPRESS)WHBindKernel(&g_ksBLAKE2BP);
+
+	if (pContext->cbBuffer)
+	{
+		cbFill = BLAKE2BP_BUFFER_LENGTH - pContext->cbBuffer;
+		memcpy(pContext->buffer + pContext->cbBuffer, pbIn, cbFill);
+		pbIn += cbFill;
+		cbIn -= cbFill;
+
+		cStripes = (cbIn > BLAKE2BP_STRIPE_LENGTH) ? 2 : 1;
+		pfnCompress(pContext->h, pContext->buffer, cStripes, pContext->counter);
+		pContext->counter += cStripes * BLAKE2B_BLOCK_LENGTH;
+
+		if (cStripes == 1)
+		{
+			memcpy(pContext->buffer, pContext->buffer + BLAKE2BP_STRIPE_LENGTH, BLAKE2BP_STRIPE_LENGTH);
+			pContext->cbBuffer = BLAKE2BP_STRIPE_LENGTH;
+		}
+		else
+			pContext->cbBuffer = 0;
+	}
+
+	// If a stripe is still buffered, no more than one stripe of input is left
+	if (cbIn > BLAKE2BP_BUFFER_LENGTH)
+	{
+		cStripes = (cbIn - BLAKE2BP_BUFFER_LENGTH + BLAKE2BP_STRIPE_LENGTH - 1) / BLAKE2BP_STRIPE_LENGTH;
+		pfnCompress(pContext->h, pbIn, cStripes, pContext->counter);
+		pContext->counter += cStripes * BLAKE2B_BLOCK_LENGTH;
+		pbIn += cStripes * BLAKE2BP_STRIPE_LENGTH;
+		cbIn -= (UINT)(cStripes * BLAKE2BP_STRIPE_LENGTH);
+	}
+
+	memcpy(pContext->buffer + pContext->cbBuffer, pbIn, cbIn);
+	pContext->cbBuffer += cbIn;
+}
+
+void BLAKE2bpFinal( PBLAKE2BP_CTX pContext )
+{
+	BYTE leaf[2 * BLAKE2B_BLOCK_LENGTH];
+	UINT64 root[8];
+	UINT i, ib, cbLeaf, cbBlock;
+
+	// Gather each leaf's blocks from the (up to two) buffered stripes
+	for (i = 0; i < BLAKE2BP_PARALLELISM; ++i)
+	{
+		cbLeaf = 0;
+
+		for (ib = i * BLAKE2B_BLOCK_LENGTH; ib < pContext->cbBuffer; ib += BLAKE2BP_STRIPE_LENGTH)
+		{
+			cbBlock = min(pContext->cbBuffer - ib, BLAKE2B_BLOCK_LENGTH);
+			memcpy(leaf + cbLeaf, pContext->buffer + ib, cbBlock);
+			cbLeaf += cbBlock;
+		}
+
+		Blake2bCompressTail(pContext->h[i], pContext->counter, leaf, cbLeaf,
+		                    (i == BLAKE2BP_PARALLELISM - 1) ? ~0ULL : 0);
+	}
+
+	// The root hashes the leaves' digests, in order, and it too is a last node
+	Blake2bInitParam(root, BLAKE2BP_PARALLELISM, 2, 0, 1, BLAKE2B_DIGEST_LENGTH);
+	Blake2bCompressTail(root, 0, (PCBYTE)pContext->h, sizeof(pContext->h), ~0ULL);
+	memcpy(pContext->result, root, BLAKE2BP_DIGEST_LENGTH);
+}
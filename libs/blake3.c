@@ -0,0 +1,1013 @@
+/**
+ * BLAKE3
+ * Last modified: 2026/10/18
+ *
+ * An implementation of BLAKE3 (https://github.com/BLAKE3-team/BLAKE3) with
+ * the default 256-bit output, following the structure of the reference C
+ * implementation.  The input is split into 1 KB chunks which are the leaves
+ * of a binary tree, so whole chunks (and later, pairs of chaining values) are
+ * compressed side by side, one per SIMD lane, by the SSE4.1, AVX2, and
+ * AVX-512 kernels below.
+ *
+ * The tree also allows separate threads to hash separate parts of the input:
+ * each part is hashed into a context set up by BLAKE3InitAt, and then the
+ * contexts are combined, in order, with BLAKE3Append.
+ **/
+
+#include "WinHash.h"
+#include "WinHashDispatch.h"
+#include <immintrin.h>
+#include <intrin.h>
+
+// AVX-512 intrinsics are only available starting with Visual Studio 2017 15.3
+#if _MSC_VER >= 1911
+#define BLAKE3_AVX512
+#endif
+
+#define BLAKE3_OUT_LENGTH   BLAKE3_DIGEST_LENGTH
+#define BLAKE3_MAX_DEGREE   16
+
+// Domain separation flags
+#define CHUNK_START         (1 << 0)
+#define CHUNK_END           (1 << 1)
+#define PARENT              (1 << 2)
+#define ROOT                (1 << 3)
+
+static const UINT32 IV[8] = {
+	0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+	0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+};
+
+static const BYTE MSG_SCHEDULE[7][16] = {
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{  2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8 },
+	{  3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1 },
+	{ 10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6 },
+	{ 12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4 },
+	{  9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7 },
+	{ 11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13 }
+};
+
+// Hashes cInputs independent inputs of cBlocks blocks each, storing one
+// chaining value per input; the counter is either the same for every input
+// (parent nodes) or incremented from one input to the next (chunks)
+typedef VOID (WHAPI *PFNBLAKE3HASHMANY)( const BYTE * const *ppbInputs, SIZE_T cInputs, SIZE_T cBlocks,
+                                         const UINT32 key[8], UINT64 counter, BOOL bIncrementCounter,
+                                         BYTE flags, BYTE flagsStart, BYTE flagsEnd, PBYTE pbOut );
+
+typedef struct {
+	SIZE_T            cDegree;      // number of inputs that are hashed side by side
+	PFNBLAKE3HASHMANY pfnHashMany;
+} BLAKE3_BACKEND, *PBLAKE3_BACKEND;
+
+typedef const BLAKE3_BACKEND *PCBLAKE3_BACKEND;
+
+/**
+ * Portable compression function
+ **/
+
+#define G(a, b, c, d, x, y)                            \
+	a = a + b + (x); d = RotRV32(d ^ a, 16);           \
+	c = c + d;       b = RotRV32(b ^ c, 12);           \
+	a = a + b + (y); d = RotRV32(d ^ a, 8);            \
+	c = c + d;       b = RotRV32(b ^ c, 7);
+
+static VOID Blake3CompressPre( UINT32 state[16], const UINT32 cv[8], const BYTE block[BLAKE3_BLOCK_LENGTH],
+                               BYTE cbBlock, UINT64 counter, BYTE flags )
+{
+	UINT32 m[16];
+	UINT r;
+
+	// x86 is little-endian, as are the message words
+	memcpy(m, block, sizeof(m));
+
+	memcpy(state, cv, 8 * sizeof(UINT32));
+	memcpy(state + 8, IV, 4 * sizeof(UINT32));
+	state[12] = (UINT32)counter;
+	state[13] = (UINT32)(counter >> 32);
+	state[14] = cbBlock;
+	state[15] = flags;
+
+	for (r = 0; r < 7; ++r)
+	{
+		const BYTE *s = MSG_SCHEDULE[r];
+
+		G(state[0], state[4], state[ 8], state[12], m[s[ 0]], m[s[ 1]]);
+		G(state[1], state[5], state[ 9], state[13], m[s[ 2]], m[s[ 3]]);
+		G(state[2], state[6], state[10], state[14], m[s[ 4]], m[s[ 5]]);
+		G(state[3], state[7], state[11], state[15], m[s[ 6]], m[s[ 7]]);
+		G(state[0], state[5], state[10], state[15], m[s[ 8]], m[s[ 9]]);
+		G(state[1], state[6], state[11], state[12], m[s[10]], m[s[11]]);
+		G(state[2], state[7], state[ 8], state[13], m[s[12]], m[s[13]]);
+		G(state[3], state[4], state[ 9], state[14], m[s[14]], m[s[15]]);
+	}
+}
+
+static VOID Blake3CompressInPlace( UINT32 cv[8], const BYTE block[BLAKE3_BLOCK_LENGTH],
+                                   BYTE cbBlock, UINT64 counter, BYTE flags )
+{
+	UINT32 state[16];
+	UINT i;
+
+	Blake3CompressPre(state, cv, block, cbBlock, counter, flags);
+
+	for (i = 0; i < 8; ++i)
+		cv[i] = state[i] ^ state[i + 8];
+}
+
+static VOID WHAPI Blake3HashManyC( const BYTE * const *ppbInputs, SIZE_T cInputs, SIZE_T cBlocks,
+                                   const UINT32 key[8], UINT64 counter, BOOL bIncrementCounter,
+                                   BYTE flags, BYTE flagsStart, BYTE flagsEnd, PBYTE pbOut )
+{
+	while (cInputs)
+	{
+		PCBYTE pbInput = *ppbInputs;
+		UINT32 cv[8];
+		BYTE blockFlags = flags | flagsStart;
+		SIZE_T cLeft;
+
+		memcpy(cv, key, sizeof(cv));
+
+		for (cLeft = cBlocks; cLeft; --cLeft)
+		{
+			if (cLeft == 1)
+				blockFlags |= flagsEnd;
+
+			Blake3CompressInPlace(cv, pbInput, BLAKE3_BLOCK_LENGTH, counter, blockFlags);
+			pbInput += BLAKE3_BLOCK_LENGTH;
+			blockFlags = flags;
+		}
+
+		memcpy(pbOut, cv, BLAKE3_OUT_LENGTH);
+
+		if (bIncrementCounter)
+			++counter;
+
+		++ppbInputs;
+		--cInputs;
+		pbOut += BLAKE3_OUT_LENGTH;
+	}
+}
+
+/**
+ * SSE4.1: 4 inputs at a time
+ **/
+
+#define ROT16_128(x) _mm_shuffle_epi8(x, _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13))
+#define ROT12_128(x) _mm_or_si128(_mm_srli_epi32(x, 12), _mm_slli_epi32(x, 20))
+#define ROT8_128(x)  _mm_shuffle_epi8(x, _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12))
+#define ROT7_128(x)  _mm_or_si128(_mm_srli_epi32(x, 7), _mm_slli_epi32(x, 25))
+
+#define G4(a, b, c, d, x, y)                                                   \
+	a = _mm_add_epi32(_mm_add_epi32(a, b), x); d = ROT16_128(_mm_xor_si128(d, a)); \
+	c = _mm_add_epi32(c, d);                   b = ROT12_128(_mm_xor_si128(b, c)); \
+	a = _mm_add_epi32(_mm_add_epi32(a, b), y); d = ROT8_128(_mm_xor_si128(d, a));  \
+	c = _mm_add_epi32(c, d);                   b = ROT7_128(_mm_xor_si128(b, c));
+
+__forceinline VOID Blake3Round4( __m128i v[16], const __m128i m[16], UINT r )
+{
+	const BYTE *s = MSG_SCHEDULE[r];
+
+	G4(v[0], v[4], v[ 8], v[12], m[s[ 0]], m[s[ 1]]);
+	G4(v[1], v[5], v[ 9], v[13], m[s[ 2]], m[s[ 3]]);
+	G4(v[2], v[6], v[10], v[14], m[s[ 4]], m[s[ 5]]);
+	G4(v[3], v[7], v[11], v[15], m[s[ 6]], m[s[ 7]]);
+	G4(v[0], v[5], v[10], v[15], m[s[ 8]], m[s[ 9]]);
+	G4(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+	G4(v[2], v[7], v[ 8], v[13], m[s[12]], m[s[13]]);
+	G4(v[3], v[4], v[ 9], v[14], m[s[14]], m[s[15]]);
+}
+
+// Transposes the 4x4 matrix of words in v[0..3]
+__forceinline VOID Blake3Transpose4( __m128i v[4] )
+{
+	__m128i ab01 = _mm_unpacklo_epi32(v[0], v[1]);
+	__m128i ab23 = _mm_unpackhi_epi32(v[0], v[1]);
+	__m128i cd01 = _mm_unpacklo_epi32(v[2], v[3]);
+	__m128i cd23 = _mm_unpackhi_epi32(v[2], v[3]);
+
+	v[0] = _mm_unpacklo_epi64(ab01, cd01);
+	v[1] = _mm_unpackhi_epi64(ab01, cd01);
+	v[2] = _mm_unpacklo_epi64(ab23, cd23);
+	v[3] = _mm_unpackhi_epi64(ab23, cd23);
+}
+
+// Sets the low and high halves of each lane's counter, with carries
+__forceinline VOID Blake3Counter4( UINT64 counter, BOOL bIncrement, __m128i *pLo, __m128i *pHi )
+{
+	const __m128i sign = _mm_set1_epi32(0x80000000);
+	__m128i add = _mm_and_si128(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(-(INT32)bIncrement));
+	__m128i lo = _mm_add_epi32(_mm_set1_epi32((INT32)counter), add);
+	__m128i carry = _mm_cmpgt_epi32(_mm_xor_si128(add, sign), _mm_xor_si128(lo, sign));
+
+	*pLo = lo;
+	*pHi = _mm_sub_epi32(_mm_set1_epi32((INT32)(counter >> 32)), carry);
+}
+
+static VOID Blake3Hash4SSE41( const BYTE * const *ppbInputs, SIZE_T cBlocks, const UINT32 key[8],
+                              UINT64 counter, BOOL bIncrementCounter,
+                              BYTE flags, BYTE flagsStart, BYTE flagsEnd, PBYTE pbOut )
+{
+	__m128i h[8], v[16], m[16], counterLo, counterHi;
+	BYTE blockFlags = flags | flagsStart;
+	SIZE_T ibBlock, cLeft;
+	UINT i, r;
+
+	for (i = 0; i < 8; ++i)
+		h[i] = _mm_set1_epi32((INT32)key[i]);
+
+	Blake3Counter4(counter, bIncrementCounter, &counterLo, &counterHi);
+
+	for (ibBlock = 0, cLeft = cBlocks; cLeft; ibBlock += BLAKE3_BLOCK_LENGTH, --cLeft)
+	{
+		if (cLeft == 1)
+			blockFlags |= flagsEnd;
+
+		// Transpose the message, so that m[i] holds word i of every input
+		for (i = 0; i < 16; i += 4)
+		{
+			m[i + 0] = _mm_loadu_si128((const __m128i *)(ppbInputs[0] + ibBlock + i * 4));
+			m[i + 1] = _mm_loadu_si128((const __m128i *)(ppbInputs[1] + ibBlock + i * 4));
+			m[i + 2] = _mm_loadu_si128((const __m128i *)(ppbInputs[2] + ibBlock + i * 4));
+			m[i + 3] = _mm_loadu_si128((const __m128i *)(ppbInputs[3] + ibBlock + i * 4));
+			Blake3Transpose4(m + i);
+		}
+
+		for (i = 0; i < 8; ++i)
+			v[i] = h[i];
+		for (i = 0; i < 4; ++i)
+			v[i + 8] = _mm_set1_epi32((INT32)IV[i]);
+		v[12] = counterLo;
+		v[13] = counterHi;
+		v[14] = _mm_set1_epi32(BLAKE3_BLOCK_LENGTH);
+		v[15] = _mm_set1_epi32(blockFlags);
+
+		for (r = 0; r < 7; ++r)
+			Blake3Round4(v, m, r);
+
+		for (i = 0; i < 8; ++i)
+			h[i] = _mm_xor_si128(v[i], v[i + 8]);
+
+		blockFlags = flags;
+	}
+
+	// Transpose back to one chaining value per input
+	Blake3Transpose4(h);
+	Blake3Transpose4(h + 4);
+
+	for (i = 0; i < 4; ++i)
+	{
+		_mm_storeu_si128((__m128i *)(pbOut + i * BLAKE3_OUT_LENGTH), h[i]);
+		_mm_storeu_si128((__m128i *)(pbOut + i * BLAKE3_OUT_LENGTH + 16), h[i + 4]);
+	}
+}
+
+static VOID WHAPI Blake3HashManySSE41( const BYTE * const *ppbInputs, SIZE_T cInputs, SIZE_T cBlocks,
+                                       const UINT32 key[8], UINT64 counter, BOOL bIncrementCounter,
+                                       BYTE flags, BYTE flagsStart, BYTE flagsEnd, PBYTE pbOut )
+{
+	for ( ; cInputs >= 4; ppbInputs += 4, cInputs -= 4, pbOut += 4 * BLAKE3_OUT_LENGTH)
+	{
+		Blake3Hash4SSE41(ppbInputs, cBlocks, key, counter, bIncrementCounter, flags, flagsStart, flagsEnd, pbOut);
+
+		if (bIncrementCounter)
+			counter += 4;
+	}
+
+	Blake3HashManyC(ppbInputs, cInputs, cBlocks, key, counter, bIncrementCounter, flags, flagsStart, flagsEnd, pbOut);
+}
+
+/**
+ * AVX2: 8 inputs at a time
+ **/
+
+#define ROT16_256(x) _mm256_shuffle_epi8(x, _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, \
+                                                             2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13))
+#define ROT12_256(x) _mm256_or_si256(_mm256_srli_epi32(x, 12), _mm256_slli_epi32(x, 20))
+#define ROT8_256(x)  _mm256_shuffle_epi8(x, _mm256_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12, \
+                                                             1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12))
+#define ROT7_256(x)  _mm256_or_si256(_mm256_srli_epi32(x, 7), _mm256_slli_epi32(x, 25))
+
+#define G8(a, b, c, d, x, y)                                                            \
+	a = _mm256_add_epi32(_mm256_add_epi32(a, b), x); d = ROT16_256(_mm256_xor_si256(d, a)); \
+	c = _mm256_add_epi32(c, d);                      b = ROT12_256(_mm256_xor_si256(b, c)); \
+	a = _mm256_add_epi32(_mm256_add_epi32(a, b), y); d = ROT8_256(_mm256_xor_si256(d, a));  \
+	c = _mm256_add_epi32(c, d);                      b = ROT7_256(_mm256_xor_si256(b, c));
+
+__forceinline VOID Blake3Round8( __m256i v[16], const __m256i m[16], UINT r )
+{
+	const BYTE *s = MSG_SCHEDULE[r];
+
+	G8(v[0], v[4], v[ 8], v[12], m[s[ 0]], m[s[ 1]]);
+	G8(v[1], v[5], v[ 9], v[13], m[s[ 2]], m[s[ 3]]);
+	G8(v[2], v[6], v[10], v[14], m[s[ 4]], m[s[ 5]]);
+	G8(v[3], v[7], v[11], v[15], m[s[ 6]], m[s[ 7]]);
+	G8(v[0], v[5], v[10], v[15], m[s[ 8]], m[s[ 9]]);
+	G8(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+	G8(v[2], v[7], v[ 8], v[13], m[s[12]], m[s[13]]);
+	G8(v[3], v[4], v[ 9], v[14], m[s[14]], m[s[15]]);
+}
+
+// Transposes the 8x8 matrix of words in v[0..7]: 4x4 blocks of words within
+// each 128-bit lane, and then the 2x2 matrix of lanes
+__forceinline VOID Blake3Transpose8( __m256i v[8] )
+{
+	__m256i t[8], u[8];
+	UINT i;
+
+	for (i = 0; i < 8; i += 2)
+	{
+		t[i + 0] = _mm256_unpacklo_epi32(v[i], v[i + 1]);
+		t[i + 1] = _mm256_unpackhi_epi32(v[i], v[i + 1]);
+	}
+
+	for (i = 0; i < 8; i += 4)
+	{
+		u[i + 0] = _mm256_unpacklo_epi64(t[i + 0], t[i + 2]);
+		u[i + 1] = _mm256_unpackhi_epi64(t[i + 0], t[i + 2]);
+		u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+		u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+
+	for (i = 0; i < 4; ++i)
+	{
+		v[i + 0] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+		v[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+	}
+}
+
+__forceinline VOID Blake3Counter8( UINT64 counter, BOOL bIncrement, __m256i *pLo, __m256i *pHi )
+{
+	const __m256i sign = _mm256_set1_epi32(0x80000000);
+	__m256i add = _mm256_and_si256(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(-(INT32)bIncrement));
+	__m256i lo = _mm256_add_epi32(_mm256_set1_epi32((INT32)counter), add);
+	__m256i carry = _mm256_cmpgt_epi32(_mm256_xor_si256(add, sign), _mm256_xor_si256(lo, sign));
+
+	*pLo = lo;
+	*pHi = _mm256_sub_epi32(_mm256_set1_epi32((INT32)(counter >> 32)), carry);
+}
+
+static VOID Blake3Hash8AVX2( const BYTE * const *ppbInputs, SIZE_T cBlocks, const UINT32 key[8],
+                             UINT64 counter, BOOL bIncrementCounter,
+                             BYTE flags, BYTE flagsStart, BYTE flagsEnd, PBYTE pbOut )
+{
+	__m256i h[8], v[16], m[16], counterLo, counterHi;
+	BYTE blockFlags = flags | flagsStart;
+	SIZE_T ibBlock, cLeft;
+	UINT i, r;
+
+	for (i = 0; i < 8; ++i)
+		h[i] = _mm256_set1_epi32((INT32)key[i]);
+
+	Blake3Counter8(counter, bIncrementCounter, &counterLo, &counterHi);
+
+	for (ibBlock = 0, cLeft = cBlocks; cLeft; ibBlock += BLAKE3_BLOCK_LENGTH, --cLeft)
+	{
+		if (cLeft == 1)
+			blockFlags |= flagsEnd;
+
+		for (i = 0; i < 8; ++i)
+		{
+			m[i + 0] = _mm256_loadu_si256((const __m256i *)(ppbInputs[i] + ibBlock));
+			m[i + 8] = _mm256_loadu_si256((const __m256i *)(ppbInputs[i] + ibBlock + 32));
+		}
+
+		Blake3Transpose8(m);
+		Blake3Transpose8(m + 8);
+
+		for (i = 0; i < 8; ++i)
+			v[i] = h[i];
+		for (i = 0; i < 4; ++i)
+			v[i + 8] = _mm256_set1_epi32((INT32)IV[i]);
+		v[12] = counterLo;
+		v[13] = counterHi;
+		v[14] = _mm256_set1_epi32(BLAKE3_BLOCK_LENGTH);
+		v[15] = _mm256_set1_epi32(blockFlags);
+
+		for (r = 0; r < 7; ++r)
+			Blake3Round8(v, m, r);
+
+		for (i = 0; i < 8; ++i)
+			h[i] = _mm256_xor_si256(v[i], v[i + 8]);
+
+		blockFlags = flags;
+	}
+
+	Blake3Transpose8(h);
+
+	for (i = 0; i < 8; ++i)
+		_mm256_storeu_si256((__m256i *)(pbOut + i * BLAKE3_OUT_LENGTH), h[i]);
+}
+
+static VOID WHAPI Blake3HashManyAVX2( const BYTE * const *ppbInputs, SIZE_T cInputs, SIZE_T cBlocks,
+                                      const UINT32 key[8], UINT64 counter, BOOL bIncrementCounter,
+                                      BYTE flags, BYTE flagsStart, BYTE flagsEnd, PBYTE pbOut )
+{
+	for ( ; cInputs >= 8; ppbInputs += 8, cInputs -= 8, pbOut += 8 * BLAKE3_OUT_LENGTH)
+	{
+		Blake3Hash8AVX2(ppbInputs, cBlocks, key, counter, bIncrementCounter, flags, flagsStart, flagsEnd, pbOut);
+
+		if (bIncrementCounter)
+			counter += 8;
+	}
+
+	Blake3HashManySSE41(ppbInputs, cInputs, cBlocks, key, counter, bIncrementCounter, flags, flagsStart, flagsEnd, pbOut);
+}
+
+/**
+ * AVX-512: 16 inputs at a time
+ **/
+
+#ifdef BLAKE3_AVX512
+
+#define G16(a, b, c, d, x, y)                                                                  \
+	a = _mm512_add_epi32(_mm512_add_epi32(a, b), x); d = _mm512_ror_epi32(_mm512_xor_si512(d, a), 16); \
+	c = _mm512_add_epi32(c, d);                      b = _mm512_ror_epi32(_mm512_xor_si512(b, c), 12); \
+	a = _mm512_add_epi32(_mm512_add_epi32(a, b), y); d = _mm512_ror_epi32(_mm512_xor_si512(d, a), 8);  \
+	c = _mm512_add_epi32(c, d);                      b = _mm512_ror_epi32(_mm512_xor_si512(b, c), 7);
+
+__forceinline VOID Blake3Round16( __m512i v[16], const __m512i m[16], UINT r )
+{
+	const BYTE *s = MSG_SCHEDULE[r];
+
+	G16(v[0], v[4], v[ 8], v[12], m[s[ 0]], m[s[ 1]]);
+	G16(v[1], v[5], v[ 9], v[13], m[s[ 2]], m[s[ 3]]);
+	G16(v[2], v[6], v[10], v[14], m[s[ 4]], m[s[ 5]]);
+	G16(v[3], v[7], v[11], v[15], m[s[ 6]], m[s[ 7]]);
+	G16(v[0], v[5], v[10], v[15], m[s[ 8]], m[s[ 9]]);
+	G16(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+	G16(v[2], v[7], v[ 8], v[13], m[s[12]], m[s[13]]);
+	G16(v[3], v[4], v[ 9], v[14], m[s[14]], m[s[15]]);
+}
+
+// Transposes the 16x16 matrix of words in v[0..15]: 4x4 blocks of words
+// within each 128-bit lane, and then the 4x4 matrices of lanes
+__forceinline VOID Blake3Transpose16( __m512i v[16] )
+{
+	__m512i t[16], u[16], x0, x1, y0, y1;
+	UINT i;
+
+	for (i = 0; i < 16; i += 2)
+	{
+		t[i + 0] = _mm512_unpacklo_epi32(v[i], v[i + 1]);
+		t[i + 1] = _mm512_unpackhi_epi32(v[i], v[i + 1]);
+	}
+
+	for (i = 0; i < 16; i += 4)
+	{
+		u[i + 0] = _mm512_unpacklo_epi64(t[i + 0], t[i + 2]);
+		u[i + 1] = _mm512_unpackhi_epi64(t[i + 0], t[i + 2]);
+		u[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+		u[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+
+	for (i = 0; i < 4; ++i)
+	{
+		x0 = _mm512_shuffle_i32x4(u[i + 0], u[i + 4],  0x44);
+		x1 = _mm512_shuffle_i32x4(u[i + 0], u[i + 4],  0xEE);
+		y0 = _mm512_shuffle_i32x4(u[i + 8], u[i + 12], 0x44);
+		y1 = _mm512_shuffle_i32x4(u[i + 8], u[i + 12], 0xEE);
+
+		v[i +  0] = _mm512_shuffle_i32x4(x0, y0, 0x88);
+		v[i +  4] = _mm512_shuffle_i32x4(x0, y0, 0xDD);
+		v[i +  8] = _mm512_shuffle_i32x4(x1, y1, 0x88);
+		v[i + 12] = _mm512_shuffle_i32x4(x1, y1, 0xDD);
+	}
+}
+
+static VOID Blake3Hash16AVX512( const BYTE * const *ppbInputs, SIZE_T cBlocks, const UINT32 key[8],
+                                UINT64 counter, BOOL bIncrementCounter,
+                                BYTE flags, BYTE flagsStart, BYTE flagsEnd, PBYTE pbOut )
+{
+	__m512i h[16], v[16], m[16], counterLo, counterHi, add;
+	BYTE blockFlags = flags | flagsStart;
+	SIZE_T ibBlock, cLeft;
+	UINT i, r;
+
+	for (i = 0; i < 8; ++i)
+		h[i] = _mm512_set1_epi32((INT32)key[i]);
+
+	add = _mm512_and_si512(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+	                       _mm512_set1_epi32(-(INT32)bIncrementCounter));
+	counterLo = _mm512_add_epi32(_mm512_set1_epi32((INT32)counter), add);
+	counterHi = _mm512_set1_epi32((INT32)(counter >> 32));
+	counterHi = _mm512_mask_add_epi32(counterHi, _mm512_cmplt_epu32_mask(counterLo, add), counterHi, _mm512_set1_epi32(1));
+
+	for (ibBlock = 0, cLeft = cBlocks; cLeft; ibBlock += BLAKE3_BLOCK_LENGTH, --cLeft)
+	{
+		if (cLeft == 1)
+			blockFlags |= flagsEnd;
+
+		// Each block fills one register, which makes this a 16x16 transpose
+		for (i = 0; i < 16; ++i)
+			m[i] = _mm512_loadu_si512(ppbInputs[i] + ibBlock);
+
+		Blake3Transpose16(m);
+
+		for (i = 0; i < 8; ++i)
+			v[i] = h[i];
+		for (i = 0; i < 4; ++i)
+			v[i + 8] = _mm512_set1_epi32((INT32)IV[i]);
+		v[12] = counterLo;
+		v[13] = counterHi;
+		v[14] = _mm512_set1_epi32(BLAKE3_BLOCK_LENGTH);
+		v[15] = _mm512_set1_epi32(blockFlags);
+
+		for (r = 0; r < 7; ++r)
+			Blake3Round16(v, m, r);
+
+		for (i = 0; i < 8; ++i)
+			h[i] = _mm512_xor_si512(v[i], v[i + 8]);
+
+		blockFlags = flags;
+	}
+
+	// Pad the chaining values out to a square matrix to transpose them back
+	for (i = 8; i < 16; ++i)
+		h[i] = _mm512_setzero_si512();
+
+	Blake3Transpose16(h);
+
+	for (i = 0; i < 16; ++i)
+		_mm256_storeu_si256((__m256i *)(pbOut + i * BLAKE3_OUT_LENGTH), _mm512_castsi512_si256(h[i]));
+}
+
+static VOID WHAPI Blake3HashManyAVX512( const BYTE * const *ppbInputs, SIZE_T cInputs, SIZE_T cBlocks,
+                                        const UINT32 key[8], UINT64 counter, BOOL bIncrementCounter,
+                                        BYTE flags, BYTE flagsStart, BYTE flagsEnd, PBYTE pbOut )
+{
+	for ( ; cInputs >= 16; ppbInputs += 16, cInputs -= 16, pbOut += 16 * BLAKE3_OUT_LENGTH)
+	{
+		Blake3Hash16AVX512(ppbInputs, cBlocks, key, counter, bIncrementCounter, flags, flagsStart, flagsEnd, pbOut);
+
+		if (bIncrementCounter)
+			counter += 16;
+	}
+
+	Blake3HashManyAVX2(ppbInputs, cInputs, cBlocks, key, counter, bIncrementCounter, flags, flagsStart, flagsEnd, pbOut);
+}
+
+#endif // BLAKE3_AVX512
+
+/**
+ * Kernel selection
+ **/
+
+#ifdef BLAKE3_AVX512
+static const BLAKE3_BACKEND c_b3AVX512 = { 16, Blake3HashManyAVX512 };
+#endif
+static const BLAKE3_BACKEND c_b3AVX2   = {  8, Blake3HashManyAVX2 };
+static const BLAKE3_BACKEND c_b3SSE41  = {  4, Blake3HashManySSE41 };
+static const BLAKE3_BACKEND c_b3C      = {  1, Blake3HashManyC };
+
+static const WHKERNEL c_akBLAKE3[] = {
+#ifdef BLAKE3_AVX512
+	{ "avx512",     CPUF_AVX512F | CPUF_AVX2, 0, (PVOID)&c_b3AVX512 },
+#endif
+	{ "avx2",       CPUF_AVX2,                0, (PVOID)&c_b3AVX2 },
+	{ "sse41",      CPUF_SSE41,               0, (PVOID)&c_b3SSE41 },
+	{ WHK_PORTABLE, 0,                        0, (PVOID)&c_b3C }
+};
+
+WHKERNELSLOT g_ksBLAKE3 = { "blake3", c_akBLAKE3, ARRAYSIZE(c_akBLAKE3), NULL };
+
+__forceinline PCBLAKE3_BACKEND Blake3Backend( )
+{
+	return((PCBLAKE3_BACKEND)WHBindKernel(&g_ksBLAKE3));
+}
+
+/**
+ * Chunks, outputs, and the tree
+ **/
+
+typedef struct {
+	UINT32 cv[8];
+	BYTE   block[BLAKE3_BLOCK_LENGTH];
+	BYTE   cbBlock;
+	UINT64 counter;
+	BYTE   flags;
+} BLAKE3_OUTPUT, *PBLAKE3_OUTPUT;
+
+__forceinline UINT Blake3HighestOne( UINT64 x )
+{
+	DWORD i;
+
+#ifdef _WIN64
+	_BitScanReverse64(&i, x | 1);
+#else
+	if (x >> 32)
+	{
+		_BitScanReverse(&i, (DWORD)(x >> 32));
+		i += 32;
+	}
+	else
+	{
+		_BitScanReverse(&i, (DWORD)x | 1);
+	}
+#endif
+
+	return(i);
+}
+
+__forceinline UINT Blake3PopCount( UINT64 x )
+{
+	UINT c = 0;
+
+	for ( ; x; x &= x - 1)
+		++c;
+
+	return(c);
+}
+
+__forceinline UINT64 Blake3RoundDownToPowerOf2( UINT64 x )
+{
+	return(1ULL << Blake3HighestOne(x | 1));
+}
+
+static VOID Blake3ChunkInit( PBLAKE3_CHUNK_STATE pChunk, const UINT32 key[8], UINT64 counter )
+{
+	memcpy(pChunk->cv, key, sizeof(pChunk->cv));
+	pChunk->counter = counter;
+	memset(pChunk->buffer, 0, sizeof(pChunk->buffer));
+	pChunk->cbBuffer = 0;
+	pChunk->cBlocksCompressed = 0;
+	pChunk->flags = 0;
+}
+
+__forceinline SIZE_T Blake3ChunkLength( const BLAKE3_CHUNK_STATE *pChunk )
+{
+	return(BLAKE3_BLOCK_LENGTH * (SIZE_T)pChunk->cBlocksCompressed + pChunk->cbBuffer);
+}
+
+__forceinline BYTE Blake3ChunkStartFlag( const BLAKE3_CHUNK_STATE *pChunk )
+{
+	return((pChunk->cBlocksCompressed == 0) ? CHUNK_START : 0);
+}
+
+static VOID Blake3ChunkUpdate( PBLAKE3_CHUNK_STATE pChunk, PCBYTE pbIn, SIZE_T cbIn )
+{
+	SIZE_T cbTake;
+
+	if (pChunk->cbBuffer > 0)
+	{
+		cbTake = BLAKE3_BLOCK_LENGTH - pChunk->cbBuffer;
+		if (cbTake > cbIn)
+			cbTake = cbIn;
+
+		memcpy(pChunk->buffer + pChunk->cbBuffer, pbIn, cbTake);
+		pChunk->cbBuffer += (BYTE)cbTake;
+		pbIn += cbTake;
+		cbIn -= cbTake;
+
+		// The last block of the chunk is kept back for its CHUNK_END flag
+		if (cbIn > 0)
+		{
+			Blake3CompressInPlace(pChunk->cv, pChunk->buffer, BLAKE3_BLOCK_LENGTH, pChunk->counter,
+			                      pChunk->flags | Blake3ChunkStartFlag(pChunk));
+			++pChunk->cBlocksCompressed;
+			pChunk->cbBuffer = 0;
+			memset(pChunk->buffer, 0, sizeof(pChunk->buffer));
+		}
+	}
+
+	while (cbIn > BLAKE3_BLOCK_LENGTH)
+	{
+		Blake3CompressInPlace(pChunk->cv, pbIn, BLAKE3_BLOCK_LENGTH, pChunk->counter,
+		                      pChunk->flags | Blake3ChunkStartFlag(pChunk));
+		++pChunk->cBlocksCompressed;
+		pbIn += BLAKE3_BLOCK_LENGTH;
+		cbIn -= BLAKE3_BLOCK_LENGTH;
+	}
+
+	memcpy(pChunk->buffer + pChunk->cbBuffer, pbIn, cbIn);
+	pChunk->cbBuffer += (BYTE)cbIn;
+}
+
+static VOID Blake3ChunkOutput( const BLAKE3_CHUNK_STATE *pChunk, PBLAKE3_OUTPUT pOutput )
+{
+	memcpy(pOutput->cv, pChunk->cv, sizeof(pOutput->cv));
+	memcpy(pOutput->block, pChunk->buffer, sizeof(pOutput->block));
+	pOutput->cbBlock = pChunk->cbBuffer;
+	pOutput->counter = pChunk->counter;
+	pOutput->flags = pChunk->flags | Blake3ChunkStartFlag(pChunk) | CHUNK_END;
+}
+
+static VOID Blake3ParentOutput( const BYTE block[BLAKE3_BLOCK_LENGTH], const UINT32 key[8], PBLAKE3_OUTPUT pOutput )
+{
+	memcpy(pOutput->cv, key, sizeof(pOutput->cv));
+	memcpy(pOutput->block, block, sizeof(pOutput->block));
+	pOutput->cbBlock = BLAKE3_BLOCK_LENGTH;
+	pOutput->counter = 0;
+	pOutput->flags = PARENT;
+}
+
+static VOID Blake3OutputChainingValue( const BLAKE3_OUTPUT *pOutput, PBYTE pbCV )
+{
+	UINT32 cv[8];
+
+	memcpy(cv, pOutput->cv, sizeof(cv));
+	Blake3CompressInPlace(cv, pOutput->block, pOutput->cbBlock, pOutput->counter, pOutput->flags);
+	memcpy(pbCV, cv, BLAKE3_OUT_LENGTH);
+}
+
+// The length of the left subtree of a node with cbIn bytes below it: the
+// largest power of 2 number of full chunks that leaves at least 1 byte over
+__forceinline SIZE_T Blake3LeftLength( SIZE_T cbIn )
+{
+	return((SIZE_T)Blake3RoundDownToPowerOf2((cbIn - 1) / BLAKE3_CHUNK_LENGTH) * BLAKE3_CHUNK_LENGTH);
+}
+
+static SIZE_T Blake3CompressChunksParallel( PCBLAKE3_BACKEND pBackend, PCBYTE pbIn, SIZE_T cbIn,
+                                            const UINT32 key[8], UINT64 counter, PBYTE pbOut )
+{
+	PCBYTE apbChunks[BLAKE3_MAX_DEGREE];
+	SIZE_T cChunks = 0, ibIn = 0;
+
+	while (cbIn - ibIn >= BLAKE3_CHUNK_LENGTH)
+	{
+		apbChunks[cChunks++] = pbIn + ibIn;
+		ibIn += BLAKE3_CHUNK_LENGTH;
+	}
+
+	pBackend->pfnHashMany(apbChunks, cChunks, BLAKE3_CHUNK_LENGTH / BLAKE3_BLOCK_LENGTH, key, counter, TRUE,
+	                      0, CHUNK_START, CHUNK_END, pbOut);
+
+	// A partial chunk at the end can only be hashed on its own
+	if (cbIn > ibIn)
+	{
+		BLAKE3_CHUNK_STATE chunk;
+		BLAKE3_OUTPUT output;
+
+		Blake3ChunkInit(&chunk, key, counter + cChunks);
+		Blake3ChunkUpdate(&chunk, pbIn + ibIn, cbIn - ibIn);
+		Blake3ChunkOutput(&chunk, &output);
+		Blake3OutputChainingValue(&output, pbOut + cChunks * BLAKE3_OUT_LENGTH);
+		return(cChunks + 1);
+	}
+
+	return(cChunks);
+}
+
+static SIZE_T Blake3CompressParentsParallel( PCBLAKE3_BACKEND pBackend, PCBYTE pbChildCVs, SIZE_T cCVs,
+                                             const UINT32 key[8], PBYTE pbOut )
+{
+	PCBYTE apbParents[BLAKE3_MAX_DEGREE];
+	SIZE_T cParents = 0;
+
+	while (cCVs - 2 * cParents >= 2)
+	{
+		apbParents[cParents] = pbChildCVs + 2 * cParents * BLAKE3_OUT_LENGTH;
+		++cParents;
+	}
+
+	pBackend->pfnHashMany(apbParents, cParents, 1, key, 0, FALSE, PARENT, 0, 0, pbOut);
+
+	// An odd child is passed up to the next level as it is
+	if (cCVs > 2 * cParents)
+	{
+		memcpy(pbOut + cParents * BLAKE3_OUT_LENGTH, pbChildCVs + 2 * cParents * BLAKE3_OUT_LENGTH, BLAKE3_OUT_LENGTH);
+		return(cParents + 1);
+	}
+
+	return(cParents);
+}
+
+// Hashes a subtree of more than one chunk as far as it can without leaving
+// fewer than two chaining values, which are stored in pbOut; returns their
+// count, which is at most max(cDegree, 2)
+static SIZE_T Blake3CompressSubtreeWide( PCBLAKE3_BACKEND pBackend, PCBYTE pbIn, SIZE_T cbIn,
+                                         const UINT32 key[8], UINT64 counter, PBYTE pbOut )
+{
+	BYTE cvs[2 * BLAKE3_MAX_DEGREE * BLAKE3_OUT_LENGTH];
+	SIZE_T cbLeft, cDegree, cLeftCVs, cRightCVs;
+
+	if (cbIn <= pBackend->cDegree * BLAKE3_CHUNK_LENGTH)
+		return(Blake3CompressChunksParallel(pBackend, pbIn, cbIn, key, counter, pbOut));
+
+	cbLeft = Blake3LeftLength(cbIn);
+
+	// With the portable kernel, each side must still leave two values
+	cDegree = pBackend->cDegree;
+	if (cbLeft > BLAKE3_CHUNK_LENGTH && cDegree == 1)
+		cDegree = 2;
+
+	cLeftCVs = Blake3CompressSubtreeWide(pBackend, pbIn, cbLeft, key, counter, cvs);
+	cRightCVs = Blake3CompressSubtreeWide(pBackend, pbIn + cbLeft, cbIn - cbLeft, key,
+	                                      counter + cbLeft / BLAKE3_CHUNK_LENGTH,
+	                                      cvs + cDegree * BLAKE3_OUT_LENGTH);
+
+	if (cLeftCVs == 1)
+	{
+		memcpy(pbOut, cvs, 2 * BLAKE3_OUT_LENGTH);
+		return(2);
+	}
+
+	return(Blake3CompressParentsParallel(pBackend, cvs, cLeftCVs + cRightCVs, key, pbOut));
+}
+
+// Reduces a subtree of more than one chunk to the two chaining values of its
+// children, which are all that the tree above it needs
+static VOID Blake3CompressSubtreeToParentNode( PCBYTE pbIn, SIZE_T cbIn, const UINT32 key[8],
+                                               UINT64 counter, BYTE abOut[2 * BLAKE3_OUT_LENGTH] )
+{
+	PCBLAKE3_BACKEND pBackend = Blake3Backend();
+	BYTE cvs[2 * BLAKE3_MAX_DEGREE * BLAKE3_OUT_LENGTH], parents[BLAKE3_MAX_DEGREE * BLAKE3_OUT_LENGTH];
+	SIZE_T cCVs = Blake3CompressSubtreeWide(pBackend, pbIn, cbIn, key, counter, cvs);
+
+	while (cCVs > 2)
+	{
+		cCVs = Blake3CompressParentsParallel(pBackend, cvs, cCVs, key, parents);
+		memcpy(cvs, parents, cCVs * BLAKE3_OUT_LENGTH);
+	}
+
+	memcpy(abOut, cvs, 2 * BLAKE3_OUT_LENGTH);
+}
+
+/**
+ * The chaining value stack holds the roots of the complete subtrees to the
+ * left of the current chunk.  Merging is done lazily, when the next value is
+ * pushed, since the last two values may need to become the root instead.
+ **/
+
+static VOID Blake3MergeCVStack( PBLAKE3_CTX pContext, UINT64 cTotalChunks )
+{
+	// One subtree per 1 bit in the number of chunks that this context has seen
+	UINT cMerged = Blake3PopCount(cTotalChunks - pContext->baseCounter);
+	BLAKE3_OUTPUT output;
+
+	while (pContext->cvStackLength > cMerged)
+	{
+		PBYTE pbParent = pContext->cvStack + (pContext->cvStackLength - 2) * BLAKE3_OUT_LENGTH;
+
+		Blake3ParentOutput(pbParent, pContext->key, &output);
+		Blake3OutputChainingValue(&output, pbParent);
+		--pContext->cvStackLength;
+	}
+}
+
+static VOID Blake3PushCV( PBLAKE3_CTX pContext, PCBYTE pbCV, UINT64 counter )
+{
+	Blake3MergeCVStack(pContext, counter);
+	memcpy(pContext->cvStack + pContext->cvStackLength * BLAKE3_OUT_LENGTH, pbCV, BLAKE3_OUT_LENGTH);
+	++pContext->cvStackLength;
+}
+
+/**
+ * Public functions
+ **/
+
+void BLAKE3Init( PBLAKE3_CTX pContext )
+{
+	memcpy(pContext->key, IV, sizeof(pContext->key));
+	Blake3ChunkInit(&pContext->chunk, pContext->key, 0);
+	pContext->baseCounter = 0;
+	pContext->cvStackLength = 0;
+}
+
+void BLAKE3InitAt( PBLAKE3_CTX pContext, UINT64 cbOffset )
+{
+	BLAKE3Init(pContext);
+	pContext->chunk.counter = pContext->baseCounter = cbOffset / BLAKE3_CHUNK_LENGTH;
+}
+
+void BLAKE3Update( PBLAKE3_CTX pContext, PCBYTE pbIn, UINT cbIn )
+{
+	BYTE cv[BLAKE3_OUT_LENGTH], cvPair[2 * BLAKE3_OUT_LENGTH];
+	BLAKE3_OUTPUT output;
+	SIZE_T cbTake;
+
+	// Finish off a partial chunk first
+	if (Blake3ChunkLength(&pContext->chunk) > 0)
+	{
+		cbTake = BLAKE3_CHUNK_LENGTH - Blake3ChunkLength(&pContext->chunk);
+		if (cbTake > cbIn)
+			cbTake = cbIn;
+
+		Blake3ChunkUpdate(&pContext->chunk, pbIn, cbTake);
+		pbIn += cbTake;
+		cbIn -= (UINT)cbTake;
+
+		// The chunk is complete, but only add it to the tree if more follows
+		if (cbIn == 0)
+			return;
+
+		Blake3ChunkOutput(&pContext->chunk, &output);
+		Blake3OutputChainingValue(&output, cv);
+		Blake3PushCV(pContext, cv, pContext->chunk.counter);
+		Blake3ChunkInit(&pContext->chunk, pContext->key, pContext->chunk.counter + 1);
+	}
+
+	// Then hash the largest subtrees possible, which must be aligned to their
+	// own size within the whole input, and leave at least 1 byte over
+	while (cbIn > BLAKE3_CHUNK_LENGTH)
+	{
+		UINT64 cbSubtree = Blake3RoundDownToPowerOf2(cbIn);
+		UINT64 cbSoFar = pContext->chunk.counter * BLAKE3_CHUNK_LENGTH;
+		UINT64 cSubtreeChunks;
+
+		while ((cbSubtree - 1) & cbSoFar)
+			cbSubtree >>= 1;
+
+		cSubtreeChunks = cbSubtree / BLAKE3_CHUNK_LENGTH;
+
+		if (cbSubtree <= BLAKE3_CHUNK_LENGTH)
+		{
+			BLAKE3_CHUNK_STATE chunk;
+
+			Blake3ChunkInit(&chunk, pContext->key, pContext->chunk.counter);
+			Blake3ChunkUpdate(&chunk, pbIn, (SIZE_T)cbSubtree);
+			Blake3ChunkOutput(&chunk, &output);
+			Blake3OutputChainingValue(&output, cv);
+			Blake3PushCV(pContext, cv, chunk.counter);
+		}
+		else
+		{
+			// Both halves are pushed, so that a subtree which turns out to be
+			// the whole input can still be finished as the root
+			Blake3CompressSubtreeToParentNode(pbIn, (SIZE_T)cbSubtree, pContext->key, pContext->chunk.counter, cvPair);
+			Blake3PushCV(pContext, cvPair, pContext->chunk.counter);
+			Blake3PushCV(pContext, cvPair + BLAKE3_OUT_LENGTH, pContext->chunk.counter + cSubtreeChunks / 2);
+		}
+
+		pContext->chunk.counter += cSubtreeChunks;
+		pbIn += cbSubtree;
+		cbIn -= (UINT)cbSubtree;
+	}
+
+	if (cbIn > 0)
+	{
+		Blake3ChunkUpdate(&pContext->chunk, pbIn, cbIn);
+		Blake3MergeCVStack(pContext, pContext->chunk.counter);
+	}
+}
+
+void BLAKE3Append( PBLAKE3_CTX pContext, PBLAKE3_CTX pNext )
+{
+	BYTE cv[BLAKE3_OUT_LENGTH];
+	BLAKE3_OUTPUT output;
+	UINT64 counter, cChunks, cSubtreeChunks;
+	UINT i;
+
+	// This context ends on a chunk boundary, so a chunk that it is still
+	// holding back is complete and not the last one
+	if (Blake3ChunkLength(&pContext->chunk) > 0)
+	{
+		Blake3ChunkOutput(&pContext->chunk, &output);
+		Blake3OutputChainingValue(&output, cv);
+		Blake3PushCV(pContext, cv, pContext->chunk.counter);
+	}
+
+	// Once fully merged, the other context's stack holds one subtree per 1
+	// bit of its chunk count, largest first, which are pushed onto this one
+	Blake3MergeCVStack(pNext, pNext->chunk.counter);
+
+	counter = pNext->baseCounter;
+	cChunks = pNext->chunk.counter - pNext->baseCounter;
+
+	for (i = 0; i < pNext->cvStackLength; ++i)
+	{
+		cSubtreeChunks = Blake3RoundDownToPowerOf2(cChunks);
+		Blake3PushCV(pContext, pNext->cvStack + i * BLAKE3_OUT_LENGTH, counter);
+		counter += cSubtreeChunks;
+		cChunks -= cSubtreeChunks;
+	}
+
+	// As in BLAKE3Update, subtrees are merged once there are more bytes after them
+	pContext->chunk = pNext->chunk;
+	if (Blake3ChunkLength(&pContext->chunk) > 0)
+		Blake3MergeCVStack(pContext, pContext->chunk.counter);
+}
+
+void BLAKE3Final( PBLAKE3_CTX pContext )
+{
+	BLAKE3_OUTPUT output;
+	BYTE parentBlock[BLAKE3_BLOCK_LENGTH];
+	UINT32 cv[8];
+	SIZE_T cCVsRemaining = pContext->cvStackLength;
+
+	if (cCVsRemaining == 0 || Blake3ChunkLength(&pContext->chunk) > 0)
+	{
+		Blake3ChunkOutput(&pContext->chunk, &output);
+	}
+	else
+	{
+		// The input ended with a subtree, so the root is the parent of the
+		// last two values on the stack
+		cCVsRemaining -= 2;
+		Blake3ParentOutput(pContext->cvStack + cCVsRemaining * BLAKE3_OUT_LENGTH, pContext->key, &output);
+	}
+
+	// Roll the rest of the stack up into the root, from right to left
+	while (cCVsRemaining > 0)
+	{
+		--cCVsRemaining;
+		memcpy(parentBlock, pContext->cvStack + cCVsRemaining * BLAKE3_OUT_LENGTH, BLAKE3_OUT_LENGTH);
+		Blake3OutputChainingValue(&output, parentBlock + BLAKE3_OUT_LENGTH);
+		Blake3ParentOutput(parentBlock, pContext->key, &output);
+	}
+
+	// The first 32 bytes of the root output are just its chaining value
+	memcpy(cv, output.cv, sizeof(cv));
+	Blake3CompressInPlace(cv, output.block, output.cbBlock, output.counter, output.flags | ROOT);
+	memcpy(pContext->result, cv, BLAKE3_DIGEST_LENGTH);
+}
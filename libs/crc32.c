@@ -40,9 +40,12 @@
  * CRC32 code derived from work by Gary S. Brown.
  */
 
+#include <immintrin.h>
 #include "WinHash.h"
+#include "WinHashDispatch.h"
+#include "crc32_tables.h"
 
-static UINT32 crc32_tab[] = {
+static const UINT32 crc32_tab[] = {
 	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
 	0xe963a535, 0x9e6495a3,	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
 	0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
@@ -88,15 +91,193 @@ static UINT32 crc32_tab[] = {
 	0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
-UINT32 crc32(UINT32 crc, PCBYTE buf, UINT size)
+/*
+ * The engines below all operate on the raw CRC register; crc32() performs
+ * the pre- and post-inversion.
+ */
+
+/* Byte-at-a-time; also used for the unaligned head and tail of a buffer. */
+static UINT32 crc32_bytewise(UINT32 crc, PCBYTE buf, UINT size)
 {
 	const BYTE * p;
 
 	p = buf;
-	crc = crc ^ ~0U;
 
 	while (size--)
 		crc = crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
 
-	return crc ^ ~0U;
-}
\ No newline at end of file
+	return crc;
+}
+
+/* Slicing-by-16: 16 bytes per iteration with 16 independent table lookups. */
+static UINT32 crc32_slice16(UINT32 crc, PCBYTE buf, UINT size)
+{
+#if BYTE_ORDER == LITTLE_ENDIAN
+	const UINT32 (*t)[256] = crc32_tab16;
+	UINT32 a, b, c, d;
+
+	for ( ; size >= 16; size -= 16, buf += 16) {
+		a = ((const UINT32 *)buf)[0] ^ crc;
+		b = ((const UINT32 *)buf)[1];
+		c = ((const UINT32 *)buf)[2];
+		d = ((const UINT32 *)buf)[3];
+		crc = t[15][a & 0xFF] ^ t[14][(a >> 8) & 0xFF] ^
+		      t[13][(a >> 16) & 0xFF] ^ t[12][a >> 24] ^
+		      t[11][b & 0xFF] ^ t[10][(b >> 8) & 0xFF] ^
+		      t[ 9][(b >> 16) & 0xFF] ^ t[ 8][b >> 24] ^
+		      t[ 7][c & 0xFF] ^ t[ 6][(c >> 8) & 0xFF] ^
+		      t[ 5][(c >> 16) & 0xFF] ^ t[ 4][c >> 24] ^
+		      t[ 3][d & 0xFF] ^ t[ 2][(d >> 8) & 0xFF] ^
+		      t[ 1][(d >> 16) & 0xFF] ^ t[ 0][d >> 24];
+	}
+#endif
+
+	return crc32_bytewise(crc, buf, size);
+}
+
+/*
+ * PCLMULQDQ folding, after Intel's "Fast CRC Computation for Generic
+ * Polynomials Using PCLMULQDQ Instruction".  Four 128-bit accumulators are
+ * folded forward by 512 bits per 64-byte iteration, then folded into one,
+ * and finally reduced to 32 bits with a Barrett reduction.  The constants
+ * are x^n mod P(x) (bit-reflected) for the fold distances used:
+ *   k1 = x^(4*128+32), k2 = x^(4*128-32)  (fold by 512 bits)
+ *   k3 = x^(128+32),   k4 = x^(128-32)    (fold by 128 bits)
+ *   k5 = x^64 mod P,   and mu = x^64 / P, P' = P for the final reduction
+ */
+#define CRC32_FOLD(x, k, next) \
+	_mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), \
+	    _mm_clmulepi64_si128(x, k, 0x11)), next)
+
+static UINT32 crc32_clmul(UINT32 crc, PCBYTE buf, UINT size)
+{
+	__m128i x0, x1, x2, x3, k, t;
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, 0, 0);
+
+	if (size < 64)
+		return(crc32_slice16(crc, buf, size));
+
+	x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)buf), _mm_cvtsi32_si128(crc));
+	x1 = _mm_loadu_si128((const __m128i *)(buf + 16));
+	x2 = _mm_loadu_si128((const __m128i *)(buf + 32));
+	x3 = _mm_loadu_si128((const __m128i *)(buf + 48));
+	buf += 64;
+	size -= 64;
+
+	/* Fold by 4 x 128 bits while there is at least another 64 bytes */
+	k = _mm_set_epi64x(0x1c6e41596, 0x154442bd4);  /* k2:k1 */
+	for ( ; size >= 64; size -= 64, buf += 64) {
+		x0 = CRC32_FOLD(x0, k, _mm_loadu_si128((const __m128i *)buf));
+		x1 = CRC32_FOLD(x1, k, _mm_loadu_si128((const __m128i *)(buf + 16)));
+		x2 = CRC32_FOLD(x2, k, _mm_loadu_si128((const __m128i *)(buf + 32)));
+		x3 = CRC32_FOLD(x3, k, _mm_loadu_si128((const __m128i *)(buf + 48)));
+	}
+
+	/* Fold the four accumulators into one, then any remaining 16-byte blocks */
+	k = _mm_set_epi64x(0x0ccaa009e, 0x1751997d0);  /* k4:k3 */
+	x0 = CRC32_FOLD(x0, k, x1);
+	x0 = CRC32_FOLD(x0, k, x2);
+	x0 = CRC32_FOLD(x0, k, x3);
+	for ( ; size >= 16; size -= 16, buf += 16)
+		x0 = CRC32_FOLD(x0, k, _mm_loadu_si128((const __m128i *)buf));
+
+	/* Fold 128 bits down to 64 */
+	t = _mm_srli_si128(x0, 8);
+	x0 = _mm_xor_si128(_mm_clmulepi64_si128(x0, k, 0x10), t);
+	t = _mm_and_si128(x0, mask32);
+	x0 = _mm_srli_si128(x0, 4);
+	k = _mm_set_epi64x(0, 0x163cd6124);            /* k5 */
+	x0 = _mm_xor_si128(_mm_clmulepi64_si128(t, k, 0x00), x0);
+
+	/* Barrett reduction to 32 bits */
+	k = _mm_set_epi64x(0x1f7011641, 0x1db710641);  /* mu:P' */
+	t = _mm_and_si128(x0, mask32);
+	t = _mm_and_si128(_mm_clmulepi64_si128(t, k, 0x10), mask32);
+	t = _mm_clmulepi64_si128(t, k, 0x00);
+	crc = (UINT32)_mm_extract_epi32(_mm_xor_si128(t, x0), 1);
+
+	return(crc32_slice16(crc, buf, size));
+}
+
+/*
+ * The engine is selected on first use, see WinHashDispatch.h.
+ */
+typedef UINT32 (*PFNCRC32UPDATE)(UINT32, PCBYTE, UINT);
+
+static const WHKERNEL crc32_kernels[] = {
+	{ "clmul",      CPUF_PCLMUL | CPUF_SSE41, 0, (PVOID)crc32_clmul },
+	{ WHK_PORTABLE, 0,                        0, (PVOID)crc32_slice16 }
+};
+
+WHKERNELSLOT g_ksCRC32 = { "crc32", crc32_kernels, ARRAYSIZE(crc32_kernels), NULL };
+
+static UINT32 crc32_select(UINT32 crc, PCBYTE buf, UINT size);
+
+static PFNCRC32UPDATE crc32_update = crc32_select;
+
+static UINT32 crc32_select(UINT32 crc, PCBYTE buf, UINT size)
+{
+	crc32_update = (PFNCRC32UPDATE)WHBindKernel(&g_ksCRC32);
+	return(crc32_update(crc, buf, size));
+}
+
+UINT32 crc32(UINT32 crc, PCBYTE buf, UINT size)
+{
+	return crc32_update(crc ^ ~0U, buf, size) ^ ~0U;
+}
+
+/*
+ * CRC combination, after zlib's crc32_combine: since the CRC is linear over
+ * GF(2), crc(A || B) can be derived from crc(A), crc(B) and the length of B
+ * by multiplying crc(A) by x^(8 * len(B)) modulo the polynomial.  This lets
+ * the segments of a file be hashed independently and then merged.
+ */
+
+/* x^(2^k) mod P(x), for k = 0..31 */
+static const UINT32 crc32_x2n_tab[32] = {
+	0x40000000, 0x20000000, 0x08000000, 0x00800000, 0x00008000, 0xedb88320,
+	0xb1e6b092, 0xa06a2517, 0xed627dae, 0x88d14467, 0xd7bbfe6a, 0xec447f11,
+	0x8e7ea170, 0x6427800e, 0x4d47bae0, 0x09fe548f, 0x83852d0f, 0x30362f1a,
+	0x7b5a9cc3, 0x31fec169, 0x9fec022a, 0x6c8dedc4, 0x15d6874d, 0x5fde7a4e,
+	0xbad90e37, 0x2e4e5eef, 0x4eaba214, 0xa8a472c0, 0x429a969e, 0x148d302a,
+	0xc40ba6d0, 0xc4e22c3c
+};
+
+/* a(x) * b(x) mod P(x), both bit-reflected; a must be non-zero */
+static UINT32 crc32_multmodp(UINT32 a, UINT32 b)
+{
+	UINT32 m, p;
+
+	m = (UINT32)1 << 31;
+	p = 0;
+	for (;;) {
+		if (a & m) {
+			p ^= b;
+			if ((a & (m - 1)) == 0)
+				break;
+		}
+		m >>= 1;
+		b = b & 1 ? (b >> 1) ^ 0xedb88320 : b >> 1;
+	}
+	return p;
+}
+
+/* x^(n * 2^k) mod P(x) */
+static UINT32 crc32_x2nmodp(UINT64 n, UINT k)
+{
+	UINT32 p;
+
+	p = (UINT32)1 << 31;	/* x^0 == 1 */
+	while (n) {
+		if (n & 1)
+			p = crc32_multmodp(crc32_x2n_tab[k & 31], p);
+		n >>= 1;
+		k++;
+	}
+	return p;
+}
+
+UINT32 crc32_combine(UINT32 crc1, UINT32 crc2, UINT64 len2)
+{
+	return crc32_multmodp(crc32_x2nmodp(len2, 3), crc1) ^ crc2;
+}
@@ -0,0 +1,150 @@
+/*
+ * CRC-32C (Castagnoli), as used by iSCSI, SCTP, ext4, Btrfs, and many object
+ * stores.  The polynomial is
+ * X^32+X^28+X^27+X^26+X^25+X^23+X^22+X^20+X^19+X^18+X^14+X^13+X^11+X^10+
+ * X^9+X^8+X^6+X^0, taken "backwards" as in crc32.c: 0x82f63b78.
+ *
+ * Processors with SSE4.2 compute it directly with the crc32 instruction;
+ * otherwise the same slicing-by-16 code as CRC-32's is used.  As in crc32.c,
+ * the engines operate on the raw CRC register, and crc32c() performs the
+ * pre- and post-inversion.
+ */
+
+#include <immintrin.h>
+#include "WinHash.h"
+#include "WinHashDispatch.h"
+#include "crc32c_tables.h"
+
+/* Byte-at-a-time; also used for the unaligned head and tail of a buffer. */
+static UINT32 crc32c_bytewise(UINT32 crc, PCBYTE buf, UINT size)
+{
+	const UINT32 *t = crc32c_tab16[0];
+
+	while (size--)
+		crc = t[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+/* Slicing-by-16: 16 bytes per iteration with 16 independent table lookups. */
+static UINT32 crc32c_slice16(UINT32 crc, PCBYTE buf, UINT size)
+{
+#if BYTE_ORDER == LITTLE_ENDIAN
+	const UINT32 (*t)[256] = crc32c_tab16;
+	UINT32 a, b, c, d;
+
+	for ( ; size >= 16; size -= 16, buf += 16) {
+		a = ((const UINT32 *)buf)[0] ^ crc;
+		b = ((const UINT32 *)buf)[1];
+		c = ((const UINT32 *)buf)[2];
+		d = ((const UINT32 *)buf)[3];
+		crc = t[15][a & 0xFF] ^ t[14][(a >> 8) & 0xFF] ^
+		      t[13][(a >> 16) & 0xFF] ^ t[12][a >> 24] ^
+		      t[11][b & 0xFF] ^ t[10][(b >> 8) & 0xFF] ^
+		      t[ 9][(b >> 16) & 0xFF] ^ t[ 8][b >> 24] ^
+		      t[ 7][c & 0xFF] ^ t[ 6][(c >> 8) & 0xFF] ^
+		      t[ 5][(c >> 16) & 0xFF] ^ t[ 4][c >> 24] ^
+		      t[ 3][d & 0xFF] ^ t[ 2][(d >> 8) & 0xFF] ^
+		      t[ 1][(d >> 16) & 0xFF] ^ t[ 0][d >> 24];
+	}
+#endif
+
+	return crc32c_bytewise(crc, buf, size);
+}
+
+/*
+ * SSE4.2.  The crc32 instruction has a latency of 3 cycles but a throughput
+ * of 1 per cycle, so a single dependency chain only reaches a third of its
+ * speed.  Large buffers are therefore split into three adjacent blocks which
+ * are run as three independent chains; the block CRCs are then combined by
+ * advancing each one past the blocks that follow it (see crc32c_tables.h).
+ */
+#ifdef _WIN64
+typedef UINT64 CRC32C_WORD;
+#define crc32c_word(crc, p) ((UINT32)_mm_crc32_u64(crc, *(const UINT64 *)(p)))
+#else
+typedef UINT32 CRC32C_WORD;
+#define crc32c_word(crc, p) _mm_crc32_u32(crc, *(const UINT32 *)(p))
+#endif
+
+__forceinline UINT32 crc32c_shift(const UINT32 zeros[4][256], UINT32 crc)
+{
+	return zeros[0][crc & 0xFF] ^ zeros[1][(crc >> 8) & 0xFF] ^
+	       zeros[2][(crc >> 16) & 0xFF] ^ zeros[3][crc >> 24];
+}
+
+static UINT32 crc32c_sse42(UINT32 crc, PCBYTE buf, UINT size)
+{
+	PCBYTE end;
+	UINT32 crc0, crc1, crc2;
+
+	/* Align the input to a whole word */
+	for ( ; size && ((ULONG_PTR)buf & (sizeof(CRC32C_WORD) - 1)); size--)
+		crc = _mm_crc32_u8(crc, *buf++);
+
+	/* Three interleaved chains over blocks of CRC32C_LONG bytes... */
+	for ( ; size >= CRC32C_LONG * 3; size -= CRC32C_LONG * 3) {
+		crc0 = crc;
+		crc1 = 0;
+		crc2 = 0;
+		for (end = buf + CRC32C_LONG; buf < end; buf += sizeof(CRC32C_WORD)) {
+			crc0 = crc32c_word(crc0, buf);
+			crc1 = crc32c_word(crc1, buf + CRC32C_LONG);
+			crc2 = crc32c_word(crc2, buf + CRC32C_LONG * 2);
+		}
+		crc = crc32c_shift(crc32c_long, crc0) ^ crc1;
+		crc = crc32c_shift(crc32c_long, crc) ^ crc2;
+		buf += CRC32C_LONG * 2;
+	}
+
+	/* ...then over blocks of CRC32C_SHORT bytes */
+	for ( ; size >= CRC32C_SHORT * 3; size -= CRC32C_SHORT * 3) {
+		crc0 = crc;
+		crc1 = 0;
+		crc2 = 0;
+		for (end = buf + CRC32C_SHORT; buf < end; buf += sizeof(CRC32C_WORD)) {
+			crc0 = crc32c_word(crc0, buf);
+			crc1 = crc32c_word(crc1, buf + CRC32C_SHORT);
+			crc2 = crc32c_word(crc2, buf + CRC32C_SHORT * 2);
+		}
+		crc = crc32c_shift(crc32c_short, crc0) ^ crc1;
+		crc = crc32c_shift(crc32c_short, crc) ^ crc2;
+		buf += CRC32C_SHORT * 2;
+	}
+
+	/* What is left is too short to be worth splitting */
+	for ( ; size >= sizeof(CRC32C_WORD); size -= sizeof(CRC32C_WORD), buf += sizeof(CRC32C_WORD))
+		crc = crc32c_word(crc, buf);
+
+	for ( ; size; size--)
+		crc = _mm_crc32_u8(crc, *buf++);
+
+	return crc;
+}
+
+/*
+ * The engine is selected on first use, see WinHashDispatch.h.
+ */
+typedef UINT32 (*PFNCRC32CUPDATE)(UINT32, PCBYTE, UINT);
+
+static const WHKERNEL crc32c_kernels[] = {
+	{ "sse42",      CPUF_SSE42, 0, (PVOID)crc32c_sse42 },
+	{ WHK_PORTABLE, 0,          0, (PVOID)crc32c_slice16 }
+};
+
+WHKERNELSLOT g_ksCRC32C = { "crc32c", crc32c_kernels, ARRAYSIZE(crc32c_kernels), NULL };
+
+static UINT32 crc32c_select(UINT32 crc, PCBYTE buf, UINT size);
+
+static PFNCRC32CUPDATE crc32c_update = crc32c_select;
+
+static UINT32 crc32c_select(UINT32 crc, PCBYTE buf, UINT size)
+{
+	crc32c_update = (PFNCRC32CUPDATE)WHBindKernel(&g_ksCRC32C);
+	return(crc32c_update(crc, buf, size));
+}
+
+UINT32 crc32c(UINT32 crc, PCBYTE buf, UINT size)
+{
+	return crc32c_update(crc ^ ~0U, buf, size) ^ ~0U;
+}
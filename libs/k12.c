@@ -0,0 +1,304 @@
+/**
+ * KangarooTwelve
+ * Last modified: 2026/10/18
+ *
+ * An implementation of KangarooTwelve (RFC 9861) with an empty customization
+ * string and a 256-bit output.  K12 is TurboSHAKE128, a sponge over the
+ * Keccak-p[1600] permutation reduced to 12 rounds, applied to a flat tree, so
+ * it reuses the Keccak code in sha3/.
+ *
+ * Inputs of more than 8 KB are split into 8 KB chunks.  Every chunk after the
+ * first is a leaf, which is hashed on its own into a 32-byte chaining value,
+ * and the final node absorbs the first chunk followed by the leaves' chaining
+ * values, in order.  Since the leaves are independent, the AVX2 kernel below
+ * hashes four of them at a time with the Keccak-p[1600]x4 permutation, and
+ * separate threads can hash separate runs of leaves with K12HashLeaves; only
+ * the final node, 32 bytes for every 8 KB of input, has to be absorbed in
+ * order, with K12AppendLeaves.
+ **/
+
+#include "WinHash.h"
+#include "WinHashDispatch.h"
+#include "sha3/KeccakP-1600-SnP.h"
+#include "sha3/KeccakP-1600-times4-SnP.h"
+
+#define K12_RATE            K12_BLOCK_LENGTH
+#define K12_RATE_LANES      (K12_RATE / 8)
+#define K12_LEAF_BLOCKS     (K12_CHUNK_LENGTH / K12_RATE)  // whole blocks in a leaf
+#define K12_LEAF_TAIL       (K12_CHUNK_LENGTH % K12_RATE)  // and the bytes left over
+
+// The most leaves that K12Update hashes from the input in one go
+#define K12_BATCH_LEAVES    32
+
+// TurboSHAKE128 domain separation bytes
+#define K12_SUFFIX_SINGLE   0x07  // the whole input fits in the first chunk
+#define K12_SUFFIX_LEAF     0x0B
+#define K12_SUFFIX_TREE     0x06  // the final node of a tree
+
+// Follows the first chunk in the final node once the input needs a tree
+static const BYTE K12_TREE_MARKER[8] = { 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+/**
+ * TurboSHAKE128 with the 64-bit Keccak-p[1600] code
+ **/
+
+static VOID K12SpongeAbsorb( UINT64 state[25], PUINT pibState, PCBYTE pbIn, SIZE_T cbIn )
+{
+	UINT ibState = *pibState;
+	SIZE_T cbTake;
+
+	while (cbIn)
+	{
+		if (ibState == 0 && cbIn >= K12_RATE)
+		{
+			cbTake = KeccakP1600_12rounds_FastLoop_Absorb(state, K12_RATE_LANES, pbIn, cbIn);
+		}
+		else
+		{
+			cbTake = (cbIn < K12_RATE - ibState) ? cbIn : K12_RATE - ibState;
+			KeccakP1600_AddBytes(state, pbIn, ibState, (UINT)cbTake);
+			ibState += (UINT)cbTake;
+
+			if (ibState == K12_RATE)
+			{
+				KeccakP1600_Permute_12rounds(state);
+				ibState = 0;
+			}
+		}
+
+		pbIn += cbTake;
+		cbIn -= cbTake;
+	}
+
+	*pibState = ibState;
+}
+
+// Pads the input, and squeezes out up to one block of output
+static VOID K12SpongeSqueeze( UINT64 state[25], UINT ibState, BYTE bSuffix, PBYTE pbOut, UINT cbOut )
+{
+	KeccakP1600_AddByte(state, bSuffix, ibState);
+	KeccakP1600_AddByte(state, 0x80, K12_RATE - 1);
+	KeccakP1600_Permute_12rounds(state);
+	KeccakP1600_ExtractBytes(state, pbOut, 0, cbOut);
+}
+
+/**
+ * Leaf kernels, each of which hashes cDegree consecutive whole leaves
+ **/
+
+typedef VOID (WHAPI *PFNK12HASHMANY)( PCBYTE pbIn, PBYTE pbChainingValues );
+
+typedef struct {
+	UINT cDegree;
+	PFNK12HASHMANY pfnHashMany;
+} K12_BACKEND, *PK12_BACKEND;
+
+typedef const K12_BACKEND *PCK12_BACKEND;
+
+static VOID WHAPI K12HashManyC( PCBYTE pbIn, PBYTE pbChainingValues )
+{
+	UINT64 state[25];
+	UINT ibState = 0;
+
+	KeccakP1600_Initialize(state);
+	K12SpongeAbsorb(state, &ibState, pbIn, K12_CHUNK_LENGTH);
+	K12SpongeSqueeze(state, ibState, K12_SUFFIX_LEAF, pbChainingValues, K12_CV_LENGTH);
+}
+
+static VOID WHAPI K12HashManyAVX2( PCBYTE pbIn, PBYTE pbChainingValues )
+{
+	__declspec(align(32)) UINT64 states[25 * 4];
+	__declspec(align(8)) BYTE tails[4][K12_RATE];
+	PCBYTE apbIn[4];
+	UINT i, j;
+
+	for (j = 0; j < 4; ++j)
+	{
+		apbIn[j] = pbIn + j * K12_CHUNK_LENGTH;
+
+		// The padding only touches the last block, which is absorbed on its own
+		memcpy(tails[j], apbIn[j] + K12_LEAF_BLOCKS * K12_RATE, K12_LEAF_TAIL);
+		memset(tails[j] + K12_LEAF_TAIL, 0, K12_RATE - K12_LEAF_TAIL);
+		tails[j][K12_LEAF_TAIL] = K12_SUFFIX_LEAF;
+		tails[j][K12_RATE - 1] |= 0x80;
+	}
+
+	KeccakP1600times4_InitializeAll(states);
+	KeccakP1600times4_12rounds_FastLoop_AbsorbMulti(states, K12_RATE_LANES, apbIn, K12_LEAF_BLOCKS);
+
+	for (j = 0; j < 4; ++j)
+		apbIn[j] = tails[j];
+
+	KeccakP1600times4_12rounds_FastLoop_AbsorbMulti(states, K12_RATE_LANES, apbIn, 1);
+
+	// The states are interleaved: lane i of instance j is at states[i * 4 + j]
+	for (j = 0; j < 4; ++j)
+	{
+		for (i = 0; i < K12_CV_LENGTH / 8; ++i)
+			memcpy(pbChainingValues + j * K12_CV_LENGTH + i * 8, &states[i * 4 + j], 8);
+	}
+}
+
+static const K12_BACKEND c_k12AVX2 = { 4, K12HashManyAVX2 };
+static const K12_BACKEND c_k12C    = { 1, K12HashManyC };
+
+static const WHKERNEL c_akK12[] = {
+	{ "avx2",       CPUF_AVX2, 0, (PVOID)&c_k12AVX2 },
+	{ WHK_PORTABLE, 0,         0, (PVOID)&c_k12C }
+};
+
+WHKERNELSLOT g_ksK12 = { "k12", c_akK12, ARRAYSIZE(c_akK12), NULL };
+
+void K12HashLeaves( PCBYTE pbIn, SIZE_T cLeaves, PBYTE pbChainingValues )
+{
+	PCK12_BACKEND pBackend = (PCK12_BACKEND)WHBindKernel(&g_ksK12);
+
+	for ( ; cLeaves >= pBackend->cDegree; cLeaves -= pBackend->cDegree)
+	{
+		pBackend->pfnHashMany(pbIn, pbChainingValues);
+		pbIn += pBackend->cDegree * K12_CHUNK_LENGTH;
+		pbChainingValues += pBackend->cDegree * K12_CV_LENGTH;
+	}
+
+	for ( ; cLeaves; --cLeaves)
+	{
+		K12HashManyC(pbIn, pbChainingValues);
+		pbIn += K12_CHUNK_LENGTH;
+		pbChainingValues += K12_CV_LENGTH;
+	}
+}
+
+/**
+ * The final node
+ **/
+
+// Called once the first chunk is full and there is more input
+static VOID K12StartTree( PK12_CTX pContext )
+{
+	K12SpongeAbsorb(pContext->node, &pContext->ibNode, K12_TREE_MARKER, sizeof(K12_TREE_MARKER));
+	pContext->bTree = TRUE;
+	pContext->cbChunk = 0;
+}
+
+static VOID K12AbsorbChainingValues( PK12_CTX pContext, PCBYTE pbChainingValues, SIZE_T cLeaves )
+{
+	K12SpongeAbsorb(pContext->node, &pContext->ibNode, pbChainingValues, cLeaves * K12_CV_LENGTH);
+	pContext->cLeaves += cLeaves;
+}
+
+static VOID K12FinishLeaf( PK12_CTX pContext )
+{
+	BYTE cv[K12_CV_LENGTH];
+
+	K12SpongeSqueeze(pContext->leaf, pContext->ibLeaf, K12_SUFFIX_LEAF, cv, sizeof(cv));
+	K12AbsorbChainingValues(pContext, cv, 1);
+	pContext->cbChunk = 0;
+}
+
+void K12Init( PK12_CTX pContext )
+{
+	KeccakP1600_Initialize(pContext->node);
+	pContext->ibNode = 0;
+	pContext->ibLeaf = 0;
+	pContext->cbChunk = 0;
+	pContext->cLeaves = 0;
+	pContext->bTree = FALSE;
+}
+
+void K12Update( PK12_CTX pContext, PCBYTE pbIn, UINT cbIn )
+{
+	BYTE cvs[K12_BATCH_LEAVES * K12_CV_LENGTH];
+	UINT cbTake, cLeaves;
+
+	// The first chunk goes straight into the final node
+	if (!pContext->bTree)
+	{
+		cbTake = (cbIn < K12_CHUNK_LENGTH - pContext->cbChunk) ? cbIn : K12_CHUNK_LENGTH - pContext->cbChunk;
+		K12SpongeAbsorb(pContext->node, &pContext->ibNode, pbIn, cbTake);
+		pContext->cbChunk += cbTake;
+		pbIn += cbTake;
+		cbIn -= cbTake;
+
+		if (cbIn == 0)
+			return;
+
+		K12StartTree(pContext);
+	}
+
+	while (cbIn)
+	{
+		if (pContext->cbChunk == 0 && cbIn >= K12_CHUNK_LENGTH)
+		{
+			// Whole leaves are hashed straight from the input
+			cLeaves = cbIn / K12_CHUNK_LENGTH;
+			if (cLeaves > K12_BATCH_LEAVES)
+				cLeaves = K12_BATCH_LEAVES;
+
+			K12HashLeaves(pbIn, cLeaves, cvs);
+			K12AbsorbChainingValues(pContext, cvs, cLeaves);
+			cbTake = cLeaves * K12_CHUNK_LENGTH;
+		}
+		else
+		{
+			if (pContext->cbChunk == 0)
+			{
+				KeccakP1600_Initialize(pContext->leaf);
+				pContext->ibLeaf = 0;
+			}
+
+			cbTake = (cbIn < K12_CHUNK_LENGTH - pContext->cbChunk) ? cbIn : K12_CHUNK_LENGTH - pContext->cbChunk;
+			K12SpongeAbsorb(pContext->leaf, &pContext->ibLeaf, pbIn, cbTake);
+			pContext->cbChunk += cbTake;
+
+			// A full leaf is complete, whether or not more input follows
+			if (pContext->cbChunk == K12_CHUNK_LENGTH)
+				K12FinishLeaf(pContext);
+		}
+
+		pbIn += cbTake;
+		cbIn -= cbTake;
+	}
+}
+
+void K12AppendLeaves( PK12_CTX pContext, PCBYTE pbChainingValues, SIZE_T cLeaves )
+{
+	if (!pContext->bTree)
+		K12StartTree(pContext);
+
+	K12AbsorbChainingValues(pContext, pbChainingValues, cLeaves);
+}
+
+void K12Final( PK12_CTX pContext )
+{
+	// The empty customization string is encoded as just its length, 0
+	static const BYTE abCustomization[1] = { 0x00 };
+	BYTE abTrailer[sizeof(UINT64) + 3];
+	UINT64 cLeaves;
+	UINT cb, i;
+
+	K12Update(pContext, abCustomization, sizeof(abCustomization));
+
+	if (!pContext->bTree)
+	{
+		K12SpongeSqueeze(pContext->node, pContext->ibNode, K12_SUFFIX_SINGLE, pContext->result, K12_DIGEST_LENGTH);
+		return;
+	}
+
+	if (pContext->cbChunk)
+		K12FinishLeaf(pContext);
+
+	// The number of leaves, big-endian without leading zeros, followed by the
+	// number of bytes it took, followed by 0xFFFF
+	for (cb = 0, cLeaves = pContext->cLeaves; cLeaves; cLeaves >>= 8)
+		++cb;
+
+	for (i = 0; i < cb; ++i)
+		abTrailer[i] = (BYTE)(pContext->cLeaves >> (8 * (cb - 1 - i)));
+
+	abTrailer[cb] = (BYTE)cb;
+	abTrailer[cb + 1] = 0xFF;
+	abTrailer[cb + 2] = 0xFF;
+
+	K12SpongeAbsorb(pContext->node, &pContext->ibNode, abTrailer, cb + 3);
+	K12SpongeSqueeze(pContext->node, pContext->ibNode, K12_SUFFIX_TREE, pContext->result, K12_DIGEST_LENGTH);
+}
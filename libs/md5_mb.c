@@ -0,0 +1,191 @@
+/**
+ * Multi-Buffer MD5
+ * Last modified: 2026/10/18
+ *
+ * A WinHashMB kernel that runs 8 independent MD5 streams side by side, one per
+ * 32-bit AVX2 vector element.  A single MD5 stream is a strictly serial chain
+ * of dependent additions, so interleaving independent messages is the only
+ * way to make it go any faster.  The state is stored transposed: word i of
+ * lane l is at state[i * cLanes + l].
+ **/
+
+#include "WinHashMB.h"
+#include <immintrin.h>
+
+static const UINT32 IVMD5MB[4] = {
+	0x67452301UL, 0xefcdab89UL, 0x98badcfeUL, 0x10325476UL
+};
+
+VOID WHAPI MD5MBInitLane( PVOID pvState, UINT cLanes, UINT iLane )
+{
+	UINT32 *state = (UINT32 *)pvState;
+	UINT i;
+
+	for (i = 0; i < 4; ++i)
+		state[i * cLanes + iLane] = IVMD5MB[i];
+}
+
+VOID WHAPI MD5MBFinalLane( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest )
+{
+	const UINT32 *state = (const UINT32 *)pvState;
+	UINT i;
+
+	for (i = 0; i < 4; ++i, pbDigest += 4)
+	{
+		UINT32 word = state[i * cLanes + iLane];
+		pbDigest[0] = (BYTE)(word);
+		pbDigest[1] = (BYTE)(word >>  8);
+		pbDigest[2] = (BYTE)(word >> 16);
+		pbDigest[3] = (BYTE)(word >> 24);
+	}
+}
+
+/**
+ * Loads words [iWord, iWord + 8) of the current block of 8 lanes, transposed
+ * so that in[j] holds word iWord + j of every lane (MD5 is little-endian, so
+ * there is no byte swapping)
+ **/
+
+__forceinline VOID MD5MBLoad8( __m256i in[8], const PCBYTE *ppbData, UINT cbOffset )
+{
+	__m256i r0 = _mm256_loadu_si256((const __m256i *)(ppbData[0] + cbOffset));
+	__m256i r1 = _mm256_loadu_si256((const __m256i *)(ppbData[1] + cbOffset));
+	__m256i r2 = _mm256_loadu_si256((const __m256i *)(ppbData[2] + cbOffset));
+	__m256i r3 = _mm256_loadu_si256((const __m256i *)(ppbData[3] + cbOffset));
+	__m256i r4 = _mm256_loadu_si256((const __m256i *)(ppbData[4] + cbOffset));
+	__m256i r5 = _mm256_loadu_si256((const __m256i *)(ppbData[5] + cbOffset));
+	__m256i r6 = _mm256_loadu_si256((const __m256i *)(ppbData[6] + cbOffset));
+	__m256i r7 = _mm256_loadu_si256((const __m256i *)(ppbData[7] + cbOffset));
+	__m256i t0, t1, t2, t3, t4, t5, t6, t7;
+
+	t0 = _mm256_unpacklo_epi32(r0, r1);
+	t1 = _mm256_unpackhi_epi32(r0, r1);
+	t2 = _mm256_unpacklo_epi32(r2, r3);
+	t3 = _mm256_unpackhi_epi32(r2, r3);
+	t4 = _mm256_unpacklo_epi32(r4, r5);
+	t5 = _mm256_unpackhi_epi32(r4, r5);
+	t6 = _mm256_unpacklo_epi32(r6, r7);
+	t7 = _mm256_unpackhi_epi32(r6, r7);
+
+	r0 = _mm256_unpacklo_epi64(t0, t2);
+	r1 = _mm256_unpackhi_epi64(t0, t2);
+	r2 = _mm256_unpacklo_epi64(t1, t3);
+	r3 = _mm256_unpackhi_epi64(t1, t3);
+	r4 = _mm256_unpacklo_epi64(t4, t6);
+	r5 = _mm256_unpackhi_epi64(t4, t6);
+	r6 = _mm256_unpacklo_epi64(t5, t7);
+	r7 = _mm256_unpackhi_epi64(t5, t7);
+
+	in[0] = _mm256_permute2x128_si256(r0, r4, 0x20);
+	in[1] = _mm256_permute2x128_si256(r1, r5, 0x20);
+	in[2] = _mm256_permute2x128_si256(r2, r6, 0x20);
+	in[3] = _mm256_permute2x128_si256(r3, r7, 0x20);
+	in[4] = _mm256_permute2x128_si256(r0, r4, 0x31);
+	in[5] = _mm256_permute2x128_si256(r1, r5, 0x31);
+	in[6] = _mm256_permute2x128_si256(r2, r6, 0x31);
+	in[7] = _mm256_permute2x128_si256(r3, r7, 0x31);
+}
+
+/* The four core functions, as in md5.c */
+#define F1(x, y, z) _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define F2(x, y, z) F1(z, x, y)
+#define F3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define F4(x, y, z) _mm256_xor_si256(y, _mm256_or_si256(x, _mm256_xor_si256(z, ones)))
+
+#define MD5MBSTEP(f, w, x, y, z, data, t, s)                                   \
+	w = _mm256_add_epi32(w, _mm256_add_epi32(f(x, y, z),                       \
+	        _mm256_add_epi32(data, _mm256_set1_epi32((int)(t)))));             \
+	w = _mm256_add_epi32(_mm256_or_si256(_mm256_slli_epi32(w, s),              \
+	        _mm256_srli_epi32(w, 32 - (s))), x)
+
+VOID WHAPI MD5MBTransformAVX2( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks )
+{
+	__m256i *state = (__m256i *)pvState;
+	__m256i a, b, c, d, in[16];
+	const __m256i ones = _mm256_set1_epi32(-1);
+	UINT cbOffset;
+
+	for (cbOffset = 0; cBlocks; --cBlocks, cbOffset += MD5_BLOCK_LENGTH)
+	{
+		MD5MBLoad8(in, ppbData, cbOffset);
+		MD5MBLoad8(in + 8, ppbData, cbOffset + 32);
+
+		a = _mm256_loadu_si256(state + 0);
+		b = _mm256_loadu_si256(state + 1);
+		c = _mm256_loadu_si256(state + 2);
+		d = _mm256_loadu_si256(state + 3);
+
+		MD5MBSTEP(F1, a, b, c, d, in[ 0], 0xd76aa478,  7);
+		MD5MBSTEP(F1, d, a, b, c, in[ 1], 0xe8c7b756, 12);
+		MD5MBSTEP(F1, c, d, a, b, in[ 2], 0x242070db, 17);
+		MD5MBSTEP(F1, b, c, d, a, in[ 3], 0xc1bdceee, 22);
+		MD5MBSTEP(F1, a, b, c, d, in[ 4], 0xf57c0faf,  7);
+		MD5MBSTEP(F1, d, a, b, c, in[ 5], 0x4787c62a, 12);
+		MD5MBSTEP(F1, c, d, a, b, in[ 6], 0xa8304613, 17);
+		MD5MBSTEP(F1, b, c, d, a, in[ 7], 0xfd469501, 22);
+		MD5MBSTEP(F1, a, b, c, d, in[ 8], 0x698098d8,  7);
+		MD5MBSTEP(F1, d, a, b, c, in[ 9], 0x8b44f7af, 12);
+		MD5MBSTEP(F1, c, d, a, b, in[10], 0xffff5bb1, 17);
+		MD5MBSTEP(F1, b, c, d, a, in[11], 0x895cd7be, 22);
+		MD5MBSTEP(F1, a, b, c, d, in[12], 0x6b901122,  7);
+		MD5MBSTEP(F1, d, a, b, c, in[13], 0xfd987193, 12);
+		MD5MBSTEP(F1, c, d, a, b, in[14], 0xa679438e, 17);
+		MD5MBSTEP(F1, b, c, d, a, in[15], 0x49b40821, 22);
+
+		MD5MBSTEP(F2, a, b, c, d, in[ 1], 0xf61e2562,  5);
+		MD5MBSTEP(F2, d, a, b, c, in[ 6], 0xc040b340,  9);
+		MD5MBSTEP(F2, c, d, a, b, in[11], 0x265e5a51, 14);
+		MD5MBSTEP(F2, b, c, d, a, in[ 0], 0xe9b6c7aa, 20);
+		MD5MBSTEP(F2, a, b, c, d, in[ 5], 0xd62f105d,  5);
+		MD5MBSTEP(F2, d, a, b, c, in[10], 0x02441453,  9);
+		MD5MBSTEP(F2, c, d, a, b, in[15], 0xd8a1e681, 14);
+		MD5MBSTEP(F2, b, c, d, a, in[ 4], 0xe7d3fbc8, 20);
+		MD5MBSTEP(F2, a, b, c, d, in[ 9], 0x21e1cde6,  5);
+		MD5MBSTEP(F2, d, a, b, c, in[14], 0xc33707d6,  9);
+		MD5MBSTEP(F2, c, d, a, b, in[ 3], 0xf4d50d87, 14);
+		MD5MBSTEP(F2, b, c, d, a, in[ 8], 0x455a14ed, 20);
+		MD5MBSTEP(F2, a, b, c, d, in[13], 0xa9e3e905,  5);
+		MD5MBSTEP(F2, d, a, b, c, in[ 2], 0xfcefa3f8,  9);
+		MD5MBSTEP(F2, c, d, a, b, in[ 7], 0x676f02d9, 14);
+		MD5MBSTEP(F2, b, c, d, a, in[12], 0x8d2a4c8a, 20);
+
+		MD5MBSTEP(F3, a, b, c, d, in[ 5], 0xfffa3942,  4);
+		MD5MBSTEP(F3, d, a, b, c, in[ 8], 0x8771f681, 11);
+		MD5MBSTEP(F3, c, d, a, b, in[11], 0x6d9d6122, 16);
+		MD5MBSTEP(F3, b, c, d, a, in[14], 0xfde5380c, 23);
+		MD5MBSTEP(F3, a, b, c, d, in[ 1], 0xa4beea44,  4);
+		MD5MBSTEP(F3, d, a, b, c, in[ 4], 0x4bdecfa9, 11);
+		MD5MBSTEP(F3, c, d, a, b, in[ 7], 0xf6bb4b60, 16);
+		MD5MBSTEP(F3, b, c, d, a, in[10], 0xbebfbc70, 23);
+		MD5MBSTEP(F3, a, b, c, d, in[13], 0x289b7ec6,  4);
+		MD5MBSTEP(F3, d, a, b, c, in[ 0], 0xeaa127fa, 11);
+		MD5MBSTEP(F3, c, d, a, b, in[ 3], 0xd4ef3085, 16);
+		MD5MBSTEP(F3, b, c, d, a, in[ 6], 0x04881d05, 23);
+		MD5MBSTEP(F3, a, b, c, d, in[ 9], 0xd9d4d039,  4);
+		MD5MBSTEP(F3, d, a, b, c, in[12], 0xe6db99e5, 11);
+		MD5MBSTEP(F3, c, d, a, b, in[15], 0x1fa27cf8, 16);
+		MD5MBSTEP(F3, b, c, d, a, in[ 2], 0xc4ac5665, 23);
+
+		MD5MBSTEP(F4, a, b, c, d, in[ 0], 0xf4292244,  6);
+		MD5MBSTEP(F4, d, a, b, c, in[ 7], 0x432aff97, 10);
+		MD5MBSTEP(F4, c, d, a, b, in[14], 0xab9423a7, 15);
+		MD5MBSTEP(F4, b, c, d, a, in[ 5], 0xfc93a039, 21);
+		MD5MBSTEP(F4, a, b, c, d, in[12], 0x655b59c3,  6);
+		MD5MBSTEP(F4, d, a, b, c, in[ 3], 0x8f0ccc92, 10);
+		MD5MBSTEP(F4, c, d, a, b, in[10], 0xffeff47d, 15);
+		MD5MBSTEP(F4, b, c, d, a, in[ 1], 0x85845dd1, 21);
+		MD5MBSTEP(F4, a, b, c, d, in[ 8], 0x6fa87e4f,  6);
+		MD5MBSTEP(F4, d, a, b, c, in[15], 0xfe2ce6e0, 10);
+		MD5MBSTEP(F4, c, d, a, b, in[ 6], 0xa3014314, 15);
+		MD5MBSTEP(F4, b, c, d, a, in[13], 0x4e0811a1, 21);
+		MD5MBSTEP(F4, a, b, c, d, in[ 4], 0xf7537e82,  6);
+		MD5MBSTEP(F4, d, a, b, c, in[11], 0xbd3af235, 10);
+		MD5MBSTEP(F4, c, d, a, b, in[ 2], 0x2ad7d2bb, 15);
+		MD5MBSTEP(F4, b, c, d, a, in[ 9], 0xeb86d391, 21);
+
+		_mm256_storeu_si256(state + 0, _mm256_add_epi32(a, _mm256_loadu_si256(state + 0)));
+		_mm256_storeu_si256(state + 1, _mm256_add_epi32(b, _mm256_loadu_si256(state + 1)));
+		_mm256_storeu_si256(state + 2, _mm256_add_epi32(c, _mm256_loadu_si256(state + 2)));
+		_mm256_storeu_si256(state + 3, _mm256_add_epi32(d, _mm256_loadu_si256(state + 3)));
+	}
+}
@@ -35,8 +35,10 @@
  */
 
 #include <string.h>
+#include <immintrin.h>
 #include "WinHash.h"
 #include "BitwiseIntrinsics.h"
+#include "WinHashDispatch.h"
 
 /*
  * UNROLLED TRANSFORM LOOP NOTE:
@@ -471,6 +473,97 @@ void SHA256Transform(UINT32 state[8], const BYTE data[SHA256_BLOCK_LENGTH])
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+/*
+ * SHA-NI multi-block transform: hashes nblocks consecutive 512-bit blocks
+ * using sha256rnds2/sha256msg1/sha256msg2.  The state is kept in the
+ * ABEF/CDGH register layout expected by these instructions for the whole run.
+ */
+#define ROUNDS256_NI(msg, j) do {					\
+	tmp = _mm_add_epi32(msg, _mm_loadu_si128((const __m128i *)&K256[j])); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, tmp);		\
+	tmp = _mm_shuffle_epi32(tmp, 0x0E);				\
+	state0 = _mm_sha256rnds2_epu32(state0, state1, tmp);		\
+} while(0)
+
+#define SCHED256_NI(m0, m1, m2, m3)					\
+	m0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m0, m1), \
+	    _mm_alignr_epi8(m3, m2, 4)), m3)
+
+void SHA256TransformNI(UINT32 state[8], const BYTE *data, UINT nblocks)
+{
+	__m128i	state0, state1, save0, save1, tmp;
+	__m128i	msg0, msg1, msg2, msg3;
+	int	j;
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);	/* CDAB */
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);	/* EFGH */
+	state0 = _mm_alignr_epi8(tmp, state1, 8);		/* ABEF */
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);		/* CDGH */
+
+	for ( ; nblocks; nblocks--, data += SHA256_BLOCK_LENGTH) {
+		save0 = state0;
+		save1 = state1;
+
+		msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data +  0)), mask);
+		msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), mask);
+		msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), mask);
+		msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), mask);
+
+		ROUNDS256_NI(msg0,  0);
+		ROUNDS256_NI(msg1,  4);
+		ROUNDS256_NI(msg2,  8);
+		ROUNDS256_NI(msg3, 12);
+
+		for (j = 16; j < 64; j += 16) {
+			SCHED256_NI(msg0, msg1, msg2, msg3);
+			ROUNDS256_NI(msg0, j);
+			SCHED256_NI(msg1, msg2, msg3, msg0);
+			ROUNDS256_NI(msg1, j + 4);
+			SCHED256_NI(msg2, msg3, msg0, msg1);
+			ROUNDS256_NI(msg2, j + 8);
+			SCHED256_NI(msg3, msg0, msg1, msg2);
+			ROUNDS256_NI(msg3, j + 12);
+		}
+
+		state0 = _mm_add_epi32(state0, save0);
+		state1 = _mm_add_epi32(state1, save1);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1B);			/* FEBA */
+	state1 = _mm_shuffle_epi32(state1, 0xB1);		/* DCHG */
+	_mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xF0));	/* DCBA */
+	_mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));	/* HGFE */
+}
+
+static void SHA256TransformC(UINT32 state[8], const BYTE *data, UINT nblocks)
+{
+	for ( ; nblocks; nblocks--, data += SHA256_BLOCK_LENGTH)
+		SHA256Transform(state, data);
+}
+
+/*
+ * The multi-block transform is selected on first use, see WinHashDispatch.h.
+ */
+typedef void (*PFNSHA256TRANSFORMBLOCKS)(UINT32 [8], const BYTE *, UINT);
+
+static const WHKERNEL SHA256Kernels[] = {
+	{ "shani",      CPUF_SHA, 0, (PVOID)SHA256TransformNI },
+	{ WHK_PORTABLE, 0,        0, (PVOID)SHA256TransformC }
+};
+
+WHKERNELSLOT g_ksSHA256 = { "sha256", SHA256Kernels, ARRAYSIZE(SHA256Kernels), NULL };
+
+static void SHA256TransformSelect(UINT32 state[8], const BYTE *data, UINT nblocks);
+
+static PFNSHA256TRANSFORMBLOCKS SHA256TransformBlocks = SHA256TransformSelect;
+
+static void SHA256TransformSelect(UINT32 state[8], const BYTE *data, UINT nblocks)
+{
+	SHA256TransformBlocks = (PFNSHA256TRANSFORMBLOCKS)WHBindKernel(&g_ksSHA256);
+	SHA256TransformBlocks(state, data, nblocks);
+}
+
 void SHA256Update(PSHA2_CTX context, PCBYTE data, UINT len)
 {
 	UINT32	freespace, usedspace;
@@ -490,7 +583,7 @@ void SHA256Update(PSHA2_CTX context, PCBYTE data, UINT len)
 			context->bitcount[0] += freespace << 3;
 			len -= freespace;
 			data += freespace;
-			SHA256Transform(context->state.st32, context->buffer);
+			SHA256TransformBlocks(context->state.st32, context->buffer, 1);
 		} else {
 			/* The buffer is not yet full */
 			memcpy(&context->buffer[usedspace], data, len);
@@ -500,12 +593,14 @@ void SHA256Update(PSHA2_CTX context, PCBYTE data, UINT len)
 			return;
 		}
 	}
-	while (len >= SHA256_BLOCK_LENGTH) {
+	if (len >= SHA256_BLOCK_LENGTH) {
 		/* Process as many complete blocks as we can */
-		SHA256Transform(context->state.st32, data);
-		context->bitcount[0] += SHA256_BLOCK_LENGTH << 3;
-		len -= SHA256_BLOCK_LENGTH;
-		data += SHA256_BLOCK_LENGTH;
+		freespace = len & ~(SHA256_BLOCK_LENGTH - 1);
+		SHA256TransformBlocks(context->state.st32, data,
+		    freespace / SHA256_BLOCK_LENGTH);
+		context->bitcount[0] += (UINT64)freespace << 3;
+		len -= freespace;
+		data += freespace;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -535,7 +630,7 @@ void SHA256Pad(PSHA2_CTX context)
 				    SHA256_BLOCK_LENGTH - usedspace);
 			}
 			/* Do second-to-last transform: */
-			SHA256Transform(context->state.st32, context->buffer);
+			SHA256TransformBlocks(context->state.st32, context->buffer, 1);
 
 			/* Prepare for last transform: */
 			memset(context->buffer, 0, SHA256_SHORT_BLOCK_LENGTH);
@@ -552,7 +647,7 @@ void SHA256Pad(PSHA2_CTX context)
 	    context->bitcount[0]);
 
 	/* Final transform: */
-	SHA256Transform(context->state.st32, context->buffer);
+	SHA256TransformBlocks(context->state.st32, context->buffer, 1);
 
 	/* Clean up: */
 	usedspace = 0;
@@ -745,6 +840,140 @@ void SHA512Transform(UINT64 state[8], const BYTE data[SHA512_BLOCK_LENGTH])
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+/*
+ * AVX2 multi-block transform: the message schedule is computed four words
+ * at a time in ymm registers and stored (with the round constants already
+ * added) to WK, which leaves only the inherently serial rounds in scalar
+ * code.  W[t-2] of the upper two words of each group depends on the lower
+ * two, so sigma1 is done in two 128-bit halves.
+ */
+#define ROR64_AVX2(x, n)						\
+	_mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+#define ROR64_SSE2(x, n)						\
+	_mm_or_si128(_mm_srli_epi64(x, n), _mm_slli_epi64(x, 64 - (n)))
+
+#define sigma0_512_AVX2(x)						\
+	_mm256_xor_si256(_mm256_xor_si256(ROR64_AVX2(x, 1), ROR64_AVX2(x, 8)), \
+	    _mm256_srli_epi64(x, 7))
+#define sigma1_512_SSE2(x)						\
+	_mm_xor_si128(_mm_xor_si128(ROR64_SSE2(x, 19), ROR64_SSE2(x, 61)), \
+	    _mm_srli_epi64(x, 6))
+
+#define SCHED512_AVX2(x0, x1, x2, x3) do {				\
+	w15 = _mm256_alignr_epi8(_mm256_permute2x128_si256(x0, x1, 0x21), x0, 8); \
+	w7 = _mm256_alignr_epi8(_mm256_permute2x128_si256(x2, x3, 0x21), x2, 8); \
+	tmp = _mm256_add_epi64(_mm256_add_epi64(x0, sigma0_512_AVX2(w15)), w7); \
+	lo = _mm_add_epi64(_mm256_castsi256_si128(tmp),		\
+	    sigma1_512_SSE2(_mm256_extracti128_si256(x3, 1)));		\
+	hi = _mm_add_epi64(_mm256_extracti128_si256(tmp, 1), sigma1_512_SSE2(lo)); \
+	x0 = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1); \
+} while(0)
+
+#define STOREWK512_AVX2(x, j)						\
+	_mm256_store_si256((__m256i *)&WK[j],				\
+	    _mm256_add_epi64(x, _mm256_loadu_si256((const __m256i *)&K512[j])))
+
+#define ROUND512_WK(a,b,c,d,e,f,g,h,j) do {				\
+	T1 = (h) + Sigma1_512((e)) + Ch((e), (f), (g)) + WK[j];	\
+	(d) += T1;							\
+	(h) = T1 + Sigma0_512((a)) + Maj((a), (b), (c));		\
+} while(0)
+
+void SHA512TransformAVX2(UINT64 state[8], const BYTE *data, UINT nblocks)
+{
+	__declspec(align(32)) UINT64 WK[80];
+	UINT64	a, b, c, d, e, f, g, h, T1;
+	__m256i	x0, x1, x2, x3, w15, w7, tmp;
+	__m128i	lo, hi;
+	int	j;
+	const __m256i mask = _mm256_set_epi64x(
+	    0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL,
+	    0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL);
+
+	for ( ; nblocks; nblocks--, data += SHA512_BLOCK_LENGTH) {
+		x0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(data +  0)), mask);
+		x1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(data + 32)), mask);
+		x2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(data + 64)), mask);
+		x3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(data + 96)), mask);
+
+		STOREWK512_AVX2(x0,  0);
+		STOREWK512_AVX2(x1,  4);
+		STOREWK512_AVX2(x2,  8);
+		STOREWK512_AVX2(x3, 12);
+
+		for (j = 16; j < 80; j += 16) {
+			SCHED512_AVX2(x0, x1, x2, x3);
+			STOREWK512_AVX2(x0, j);
+			SCHED512_AVX2(x1, x2, x3, x0);
+			STOREWK512_AVX2(x1, j + 4);
+			SCHED512_AVX2(x2, x3, x0, x1);
+			STOREWK512_AVX2(x2, j + 8);
+			SCHED512_AVX2(x3, x0, x1, x2);
+			STOREWK512_AVX2(x3, j + 12);
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		for (j = 0; j < 80; j += 8) {
+			ROUND512_WK(a, b, c, d, e, f, g, h, j);
+			ROUND512_WK(h, a, b, c, d, e, f, g, j + 1);
+			ROUND512_WK(g, h, a, b, c, d, e, f, j + 2);
+			ROUND512_WK(f, g, h, a, b, c, d, e, j + 3);
+			ROUND512_WK(e, f, g, h, a, b, c, d, j + 4);
+			ROUND512_WK(d, e, f, g, h, a, b, c, j + 5);
+			ROUND512_WK(c, d, e, f, g, h, a, b, j + 6);
+			ROUND512_WK(b, c, d, e, f, g, h, a, j + 7);
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+
+	/* Clean up */
+	a = b = c = d = e = f = g = h = T1 = 0;
+}
+
+static void SHA512TransformC(UINT64 state[8], const BYTE *data, UINT nblocks)
+{
+	for ( ; nblocks; nblocks--, data += SHA512_BLOCK_LENGTH)
+		SHA512Transform(state, data);
+}
+
+/*
+ * The multi-block transform is selected on first use, see WinHashDispatch.h.
+ */
+typedef void (*PFNSHA512TRANSFORMBLOCKS)(UINT64 [8], const BYTE *, UINT);
+
+static const WHKERNEL SHA512Kernels[] = {
+	{ "avx2",       CPUF_AVX2, 0, (PVOID)SHA512TransformAVX2 },
+	{ WHK_PORTABLE, 0,         0, (PVOID)SHA512TransformC }
+};
+
+WHKERNELSLOT g_ksSHA512 = { "sha512", SHA512Kernels, ARRAYSIZE(SHA512Kernels), NULL };
+
+static void SHA512TransformSelect(UINT64 state[8], const BYTE *data, UINT nblocks);
+
+static PFNSHA512TRANSFORMBLOCKS SHA512TransformBlocks = SHA512TransformSelect;
+
+static void SHA512TransformSelect(UINT64 state[8], const BYTE *data, UINT nblocks)
+{
+	SHA512TransformBlocks = (PFNSHA512TRANSFORMBLOCKS)WHBindKernel(&g_ksSHA512);
+	SHA512TransformBlocks(state, data, nblocks);
+}
+
 void SHA512Update(PSHA2_CTX context, PCBYTE data, UINT len)
 {
 	UINT32 freespace, usedspace;
@@ -764,7 +993,7 @@ void SHA512Update(PSHA2_CTX context, PCBYTE data, UINT len)
 			ADDINC128(context->bitcount, freespace << 3);
 			len -= freespace;
 			data += freespace;
-			SHA512Transform(context->state.st64, context->buffer);
+			SHA512TransformBlocks(context->state.st64, context->buffer, 1);
 		} else {
 			/* The buffer is not yet full */
 			memcpy(&context->buffer[usedspace], data, len);
@@ -774,12 +1003,14 @@ void SHA512Update(PSHA2_CTX context, PCBYTE data, UINT len)
 			return;
 		}
 	}
-	while (len >= SHA512_BLOCK_LENGTH) {
+	if (len >= SHA512_BLOCK_LENGTH) {
 		/* Process as many complete blocks as we can */
-		SHA512Transform(context->state.st64, data);
-		ADDINC128(context->bitcount, SHA512_BLOCK_LENGTH << 3);
-		len -= SHA512_BLOCK_LENGTH;
-		data += SHA512_BLOCK_LENGTH;
+		freespace = len & ~(SHA512_BLOCK_LENGTH - 1);
+		SHA512TransformBlocks(context->state.st64, data,
+		    freespace / SHA512_BLOCK_LENGTH);
+		ADDINC128(context->bitcount, (UINT64)freespace << 3);
+		len -= freespace;
+		data += freespace;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -807,7 +1038,7 @@ void SHA512Pad(PSHA2_CTX context)
 				memset(&context->buffer[usedspace], 0, SHA512_BLOCK_LENGTH - usedspace);
 			}
 			/* Do second-to-last transform: */
-			SHA512Transform(context->state.st64, context->buffer);
+			SHA512TransformBlocks(context->state.st64, context->buffer, 1);
 
 			/* And set-up for the last transform: */
 			memset(context->buffer, 0, SHA512_BLOCK_LENGTH - 2);
@@ -826,7 +1057,7 @@ void SHA512Pad(PSHA2_CTX context)
 	    context->bitcount[0]);
 
 	/* Final transform: */
-	SHA512Transform(context->state.st64, context->buffer);
+	SHA512TransformBlocks(context->state.st64, context->buffer, 1);
 
 	/* Clean up: */
 	usedspace = 0;
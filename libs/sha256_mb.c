@@ -0,0 +1,261 @@
+/**
+ * Multi-Buffer SHA-256
+ * Last modified: 2026/10/18
+ *
+ * WinHashMB kernels that run 8 (AVX2) or 16 (AVX-512) independent SHA-256
+ * streams side by side, one per 32-bit vector element.  The state is stored
+ * transposed: working variable i of lane l is at state[i * cLanes + l].
+ **/
+
+#include "WinHashMB.h"
+#include <immintrin.h>
+
+static const UINT32 K256MB[64] = {
+	0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL,
+	0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+	0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL,
+	0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+	0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL,
+	0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+	0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL,
+	0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+	0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL,
+	0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+	0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL,
+	0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+	0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL,
+	0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+	0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL,
+	0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+static const UINT32 IV256MB[8] = {
+	0x6a09e667UL, 0xbb67ae85UL, 0x3c6ef372UL, 0xa54ff53aUL,
+	0x510e527fUL, 0x9b05688cUL, 0x1f83d9abUL, 0x5be0cd19UL
+};
+
+VOID WHAPI SHA256MBInitLane( PVOID pvState, UINT cLanes, UINT iLane )
+{
+	UINT32 *state = (UINT32 *)pvState;
+	UINT i;
+
+	for (i = 0; i < 8; ++i)
+		state[i * cLanes + iLane] = IV256MB[i];
+}
+
+VOID WHAPI SHA256MBFinalLane( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest )
+{
+	const UINT32 *state = (const UINT32 *)pvState;
+	UINT i;
+
+	for (i = 0; i < 8; ++i, pbDigest += 4)
+	{
+		UINT32 word = state[i * cLanes + iLane];
+		pbDigest[0] = (BYTE)(word >> 24);
+		pbDigest[1] = (BYTE)(word >> 16);
+		pbDigest[2] = (BYTE)(word >>  8);
+		pbDigest[3] = (BYTE)(word);
+	}
+}
+
+/**
+ * The rounds, written once in terms of the V* operations defined by each
+ * kernel below; the working variables are renamed instead of rotated
+ **/
+
+#define SIGMA0(a)  VXOR3(VROR(a,  2), VROR(a, 13), VROR(a, 22))
+#define SIGMA1(e)  VXOR3(VROR(e,  6), VROR(e, 11), VROR(e, 25))
+#define sigma0(w)  VXOR3(VROR(w,  7), VROR(w, 18), VSHR(w,  3))
+#define sigma1(w)  VXOR3(VROR(w, 17), VROR(w, 19), VSHR(w, 10))
+
+#define ROUND(a, b, c, d, e, f, g, h, i)                                       \
+	t1 = VADD(VADD(VADD(h, SIGMA1(e)), VCH(e, f, g)),                          \
+	          VADD(VSET1(K256MB[i]), w[(i) & 15]));                            \
+	d = VADD(d, t1);                                                           \
+	h = VADD(VADD(t1, SIGMA0(a)), VMAJ(a, b, c))
+
+#define SCHEDULE(i)                                                            \
+	w[(i) & 15] = VADD(VADD(w[(i) & 15], sigma1(w[((i) - 2) & 15])),            \
+	                   VADD(w[((i) - 7) & 15], sigma0(w[((i) - 15) & 15])))
+
+#define ROUNDS_0_TO_63()                                                       \
+	for (i = 0; i < 64; i += 8)                                                \
+	{                                                                          \
+		if (i >= 16)                                                           \
+		{                                                                      \
+			SCHEDULE(i + 0); SCHEDULE(i + 1); SCHEDULE(i + 2); SCHEDULE(i + 3);\
+			SCHEDULE(i + 4); SCHEDULE(i + 5); SCHEDULE(i + 6); SCHEDULE(i + 7);\
+		}                                                                      \
+		ROUND(a, b, c, d, e, f, g, h, i + 0);                                  \
+		ROUND(h, a, b, c, d, e, f, g, i + 1);                                  \
+		ROUND(g, h, a, b, c, d, e, f, i + 2);                                  \
+		ROUND(f, g, h, a, b, c, d, e, i + 3);                                  \
+		ROUND(e, f, g, h, a, b, c, d, i + 4);                                  \
+		ROUND(d, e, f, g, h, a, b, c, i + 5);                                  \
+		ROUND(c, d, e, f, g, h, a, b, i + 6);                                  \
+		ROUND(b, c, d, e, f, g, h, a, i + 7);                                  \
+	}
+
+/**
+ * Loads words [iWord, iWord + 8) of the current block of 8 lanes, transposed
+ * so that w[j] holds word iWord + j of every lane, and converted from
+ * big-endian
+ **/
+
+__forceinline VOID SHA256MBLoad8( __m256i w[8], const PCBYTE *ppbData, UINT cbOffset )
+{
+	const __m256i bswap = _mm256_setr_epi8(
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+	__m256i r0 = _mm256_loadu_si256((const __m256i *)(ppbData[0] + cbOffset));
+	__m256i r1 = _mm256_loadu_si256((const __m256i *)(ppbData[1] + cbOffset));
+	__m256i r2 = _mm256_loadu_si256((const __m256i *)(ppbData[2] + cbOffset));
+	__m256i r3 = _mm256_loadu_si256((const __m256i *)(ppbData[3] + cbOffset));
+	__m256i r4 = _mm256_loadu_si256((const __m256i *)(ppbData[4] + cbOffset));
+	__m256i r5 = _mm256_loadu_si256((const __m256i *)(ppbData[5] + cbOffset));
+	__m256i r6 = _mm256_loadu_si256((const __m256i *)(ppbData[6] + cbOffset));
+	__m256i r7 = _mm256_loadu_si256((const __m256i *)(ppbData[7] + cbOffset));
+	__m256i t0, t1, t2, t3, t4, t5, t6, t7;
+
+	t0 = _mm256_unpacklo_epi32(r0, r1);
+	t1 = _mm256_unpackhi_epi32(r0, r1);
+	t2 = _mm256_unpacklo_epi32(r2, r3);
+	t3 = _mm256_unpackhi_epi32(r2, r3);
+	t4 = _mm256_unpacklo_epi32(r4, r5);
+	t5 = _mm256_unpackhi_epi32(r4, r5);
+	t6 = _mm256_unpacklo_epi32(r6, r7);
+	t7 = _mm256_unpackhi_epi32(r6, r7);
+
+	r0 = _mm256_unpacklo_epi64(t0, t2);
+	r1 = _mm256_unpackhi_epi64(t0, t2);
+	r2 = _mm256_unpacklo_epi64(t1, t3);
+	r3 = _mm256_unpackhi_epi64(t1, t3);
+	r4 = _mm256_unpacklo_epi64(t4, t6);
+	r5 = _mm256_unpackhi_epi64(t4, t6);
+	r6 = _mm256_unpacklo_epi64(t5, t7);
+	r7 = _mm256_unpackhi_epi64(t5, t7);
+
+	w[0] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r0, r4, 0x20), bswap);
+	w[1] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r1, r5, 0x20), bswap);
+	w[2] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r2, r6, 0x20), bswap);
+	w[3] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r3, r7, 0x20), bswap);
+	w[4] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r0, r4, 0x31), bswap);
+	w[5] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r1, r5, 0x31), bswap);
+	w[6] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r2, r6, 0x31), bswap);
+	w[7] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r3, r7, 0x31), bswap);
+}
+
+/**
+ * AVX2: 8 lanes
+ **/
+
+#define VADD(x, y)     _mm256_add_epi32(x, y)
+#define VXOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define VROR(x, n)     _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define VSHR(x, n)     _mm256_srli_epi32(x, n)
+#define VCH(e, f, g)   _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g))
+#define VMAJ(a, b, c)  _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)))
+#define VSET1(k)       _mm256_set1_epi32((int)(k))
+
+VOID WHAPI SHA256MBTransformAVX2( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks )
+{
+	__m256i *state = (__m256i *)pvState;
+	__m256i a, b, c, d, e, f, g, h, t1, w[16];
+	UINT cbOffset, i;
+
+	for (cbOffset = 0; cBlocks; --cBlocks, cbOffset += SHA256_BLOCK_LENGTH)
+	{
+		SHA256MBLoad8(w, ppbData, cbOffset);
+		SHA256MBLoad8(w + 8, ppbData, cbOffset + 32);
+
+		a = _mm256_loadu_si256(state + 0);
+		b = _mm256_loadu_si256(state + 1);
+		c = _mm256_loadu_si256(state + 2);
+		d = _mm256_loadu_si256(state + 3);
+		e = _mm256_loadu_si256(state + 4);
+		f = _mm256_loadu_si256(state + 5);
+		g = _mm256_loadu_si256(state + 6);
+		h = _mm256_loadu_si256(state + 7);
+
+		ROUNDS_0_TO_63();
+
+		_mm256_storeu_si256(state + 0, VADD(a, _mm256_loadu_si256(state + 0)));
+		_mm256_storeu_si256(state + 1, VADD(b, _mm256_loadu_si256(state + 1)));
+		_mm256_storeu_si256(state + 2, VADD(c, _mm256_loadu_si256(state + 2)));
+		_mm256_storeu_si256(state + 3, VADD(d, _mm256_loadu_si256(state + 3)));
+		_mm256_storeu_si256(state + 4, VADD(e, _mm256_loadu_si256(state + 4)));
+		_mm256_storeu_si256(state + 5, VADD(f, _mm256_loadu_si256(state + 5)));
+		_mm256_storeu_si256(state + 6, VADD(g, _mm256_loadu_si256(state + 6)));
+		_mm256_storeu_si256(state + 7, VADD(h, _mm256_loadu_si256(state + 7)));
+	}
+}
+
+#undef VADD
+#undef VXOR3
+#undef VROR
+#undef VSHR
+#undef VCH
+#undef VMAJ
+#undef VSET1
+
+/**
+ * AVX-512: 16 lanes, each block loaded as two sets of 8 AVX2 rows
+ **/
+
+#ifdef WHMB_AVX512
+
+#define VADD(x, y)     _mm512_add_epi32(x, y)
+#define VXOR3(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define VROR(x, n)     _mm512_ror_epi32(x, n)
+#define VSHR(x, n)     _mm512_srli_epi32(x, n)
+#define VCH(e, f, g)   _mm512_ternarylogic_epi32(e, f, g, 0xCA)
+#define VMAJ(a, b, c)  _mm512_ternarylogic_epi32(a, b, c, 0xE8)
+#define VSET1(k)       _mm512_set1_epi32((int)(k))
+
+__forceinline VOID SHA256MBLoad16( __m512i w[8], const PCBYTE *ppbData, UINT cbOffset )
+{
+	__m256i lo[8], hi[8];
+	UINT j;
+
+	SHA256MBLoad8(lo, ppbData, cbOffset);
+	SHA256MBLoad8(hi, ppbData + 8, cbOffset);
+
+	for (j = 0; j < 8; ++j)
+		w[j] = _mm512_inserti64x4(_mm512_castsi256_si512(lo[j]), hi[j], 1);
+}
+
+VOID WHAPI SHA256MBTransformAVX512( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks )
+{
+	__m512i *state = (__m512i *)pvState;
+	__m512i a, b, c, d, e, f, g, h, t1, w[16];
+	UINT cbOffset, i;
+
+	for (cbOffset = 0; cBlocks; --cBlocks, cbOffset += SHA256_BLOCK_LENGTH)
+	{
+		SHA256MBLoad16(w, ppbData, cbOffset);
+		SHA256MBLoad16(w + 8, ppbData, cbOffset + 32);
+
+		a = _mm512_loadu_si512(state + 0);
+		b = _mm512_loadu_si512(state + 1);
+		c = _mm512_loadu_si512(state + 2);
+		d = _mm512_loadu_si512(state + 3);
+		e = _mm512_loadu_si512(state + 4);
+		f = _mm512_loadu_si512(state + 5);
+		g = _mm512_loadu_si512(state + 6);
+		h = _mm512_loadu_si512(state + 7);
+
+		ROUNDS_0_TO_63();
+
+		_mm512_storeu_si512(state + 0, VADD(a, _mm512_loadu_si512(state + 0)));
+		_mm512_storeu_si512(state + 1, VADD(b, _mm512_loadu_si512(state + 1)));
+		_mm512_storeu_si512(state + 2, VADD(c, _mm512_loadu_si512(state + 2)));
+		_mm512_storeu_si512(state + 3, VADD(d, _mm512_loadu_si512(state + 3)));
+		_mm512_storeu_si512(state + 4, VADD(e, _mm512_loadu_si512(state + 4)));
+		_mm512_storeu_si512(state + 5, VADD(f, _mm512_loadu_si512(state + 5)));
+		_mm512_storeu_si512(state + 6, VADD(g, _mm512_loadu_si512(state + 6)));
+		_mm512_storeu_si512(state + 7, VADD(h, _mm512_loadu_si512(state + 7)));
+	}
+}
+
+#endif
@@ -0,0 +1,176 @@
+/*
+Keccak-p[1600] for processors with AVX-512F, used at runtime in place of the
+generic 64-bit implementation when the processor supports it (see
+KeccakSponge.c).  It operates on the same lane-complemented state as
+KeccakP-1600-opt64.c, so the two can be freely mixed on one sponge.
+
+The state is held in five ZMM registers, one per row (plane) y, with lane x
+of the row in qword x and qwords 5 to 7 unused.  Theta and chi then become
+row-wide ternary logic operations, rho is a single variable rotate per row,
+and pi is a 5x5 transpose done with two rounds of two-source permutes.
+*/
+
+#include <immintrin.h>
+#include "KeccakP-1600-SnP.h"
+
+#ifdef KeccakP1600_AVX512_supported
+
+static const unsigned long long KeccakP1600_AVX512_RoundConstants[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+    0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL };
+
+#define XOR3(a, b, c)           _mm512_ternarylogic_epi64(a, b, c, 0x96)
+#define XORANDNOT(a, b, c)      _mm512_ternarylogic_epi64(a, b, c, 0xD2)  /* a ^ (~b & c) */
+
+/* Qword indices; only qwords 0 to 4 of each row are meaningful */
+#define ROW(x0, x1, x2, x3, x4) _mm512_set_epi64(0, 0, 0, x4, x3, x2, x1, x0)
+
+#define declareConstants \
+    const __m512i xMinus1 = ROW(4, 0, 1, 2, 3); \
+    const __m512i xPlus1 = ROW(1, 2, 3, 4, 0); \
+    const __m512i xPlus2 = ROW(2, 3, 4, 0, 1); \
+    const __m512i rho0 = ROW( 0,  1, 62, 28, 27); \
+    const __m512i rho1 = ROW(36, 44,  6, 55, 20); \
+    const __m512i rho2 = ROW( 3, 10, 43, 25, 39); \
+    const __m512i rho3 = ROW(41, 45, 15, 21,  8); \
+    const __m512i rho4 = ROW(18,  2, 61, 56, 14); \
+    /* After pi, lane x of row y comes from lane (x + 3y) mod 5 of row x. \
+       The rows are first interleaved in pairs, (0, 1) and (2, 3), with \
+       new row k in qwords 2k and 2k + 1 ("lo" for k < 4, "hi" for k = 4), \
+       and then gathered back together along with the lane from row 4 */ \
+    const __m512i pi01lo = _mm512_set_epi64(8, 4, 10, 1, 12, 3, 9, 0); \
+    const __m512i pi23lo = _mm512_set_epi64(10, 1, 12, 3, 9, 0, 11, 2); \
+    const __m512i pi01hi = _mm512_set_epi64(0, 0, 0, 0, 0, 0, 11, 2); \
+    const __m512i pi23hi = _mm512_set_epi64(0, 0, 0, 0, 0, 0, 8, 4); \
+    const __m512i piRow0 = ROW(0, 1,  8,  9, 0); \
+    const __m512i piRow1 = ROW(2, 3, 10, 11, 0); \
+    const __m512i piRow2 = ROW(4, 5, 12, 13, 0); \
+    const __m512i piRow3 = ROW(6, 7, 14, 15, 0); \
+    const __m512i piRow4 = ROW(0, 1,  8,  9, 0);
+
+#if defined(KeccakP1600_useLaneComplementing)
+/* Lanes 1, 2, 8, 12, 17 and 20 are stored complemented by the generic code */
+#define declareComplement \
+    const __m512i complement0 = _mm512_maskz_set1_epi64(0x06, -1); \
+    const __m512i complement1 = _mm512_maskz_set1_epi64(0x08, -1); \
+    const __m512i complement2 = _mm512_maskz_set1_epi64(0x04, -1); \
+    const __m512i complement3 = _mm512_maskz_set1_epi64(0x04, -1); \
+    const __m512i complement4 = _mm512_maskz_set1_epi64(0x01, -1);
+#define complementRows \
+    A0 = _mm512_xor_si512(A0, complement0); \
+    A1 = _mm512_xor_si512(A1, complement1); \
+    A2 = _mm512_xor_si512(A2, complement2); \
+    A3 = _mm512_xor_si512(A3, complement3); \
+    A4 = _mm512_xor_si512(A4, complement4);
+#else
+#define declareComplement
+#define complementRows
+#endif
+
+#define copyFromState(lanes) \
+    A0 = _mm512_maskz_loadu_epi64(0x1F, (lanes) +  0); \
+    A1 = _mm512_maskz_loadu_epi64(0x1F, (lanes) +  5); \
+    A2 = _mm512_maskz_loadu_epi64(0x1F, (lanes) + 10); \
+    A3 = _mm512_maskz_loadu_epi64(0x1F, (lanes) + 15); \
+    A4 = _mm512_maskz_loadu_epi64(0x1F, (lanes) + 20); \
+    complementRows
+
+#define copyToState(lanes) \
+    complementRows \
+    _mm512_mask_storeu_epi64((lanes) +  0, 0x1F, A0); \
+    _mm512_mask_storeu_epi64((lanes) +  5, 0x1F, A1); \
+    _mm512_mask_storeu_epi64((lanes) + 10, 0x1F, A2); \
+    _mm512_mask_storeu_epi64((lanes) + 15, 0x1F, A3); \
+    _mm512_mask_storeu_epi64((lanes) + 20, 0x1F, A4);
+
+#define round(i) \
+    /* Theta */ \
+    C = XOR3(XOR3(A0, A1, A2), A3, A4); \
+    D0 = _mm512_permutexvar_epi64(xMinus1, C); \
+    D1 = _mm512_rol_epi64(_mm512_permutexvar_epi64(xPlus1, C), 1); \
+    /* Rho */ \
+    A0 = _mm512_rolv_epi64(XOR3(A0, D0, D1), rho0); \
+    A1 = _mm512_rolv_epi64(XOR3(A1, D0, D1), rho1); \
+    A2 = _mm512_rolv_epi64(XOR3(A2, D0, D1), rho2); \
+    A3 = _mm512_rolv_epi64(XOR3(A3, D0, D1), rho3); \
+    A4 = _mm512_rolv_epi64(XOR3(A4, D0, D1), rho4); \
+    /* Pi */ \
+    T01lo = _mm512_permutex2var_epi64(A0, pi01lo, A1); \
+    T23lo = _mm512_permutex2var_epi64(A2, pi23lo, A3); \
+    T01hi = _mm512_permutex2var_epi64(A0, pi01hi, A1); \
+    T23hi = _mm512_permutex2var_epi64(A2, pi23hi, A3); \
+    B0 = _mm512_mask_permutexvar_epi64(_mm512_permutex2var_epi64(T01lo, piRow0, T23lo), 0x10, _mm512_set1_epi64(4), A4); \
+    B1 = _mm512_mask_permutexvar_epi64(_mm512_permutex2var_epi64(T01lo, piRow1, T23lo), 0x10, _mm512_set1_epi64(2), A4); \
+    B2 = _mm512_mask_permutexvar_epi64(_mm512_permutex2var_epi64(T01lo, piRow2, T23lo), 0x10, _mm512_set1_epi64(0), A4); \
+    B3 = _mm512_mask_permutexvar_epi64(_mm512_permutex2var_epi64(T01lo, piRow3, T23lo), 0x10, _mm512_set1_epi64(3), A4); \
+    B4 = _mm512_mask_permutexvar_epi64(_mm512_permutex2var_epi64(T01hi, piRow4, T23hi), 0x10, _mm512_set1_epi64(1), A4); \
+    /* Chi */ \
+    A0 = XORANDNOT(B0, _mm512_permutexvar_epi64(xPlus1, B0), _mm512_permutexvar_epi64(xPlus2, B0)); \
+    A1 = XORANDNOT(B1, _mm512_permutexvar_epi64(xPlus1, B1), _mm512_permutexvar_epi64(xPlus2, B1)); \
+    A2 = XORANDNOT(B2, _mm512_permutexvar_epi64(xPlus1, B2), _mm512_permutexvar_epi64(xPlus2, B2)); \
+    A3 = XORANDNOT(B3, _mm512_permutexvar_epi64(xPlus1, B3), _mm512_permutexvar_epi64(xPlus2, B3)); \
+    A4 = XORANDNOT(B4, _mm512_permutexvar_epi64(xPlus1, B4), _mm512_permutexvar_epi64(xPlus2, B4)); \
+    /* Iota */ \
+    A0 = _mm512_xor_si512(A0, _mm512_maskz_loadu_epi64(0x01, &KeccakP1600_AVX512_RoundConstants[i]));
+
+#define rounds24 \
+    for (i = 0; i < 24; i++) { \
+        round(i) \
+    }
+
+#define declareState \
+    __m512i A0, A1, A2, A3, A4, B0, B1, B2, B3, B4; \
+    __m512i C, D0, D1, T01lo, T23lo, T01hi, T23hi; \
+    unsigned int i; \
+    declareConstants \
+    declareComplement
+
+/* ---------------------------------------------------------------- */
+
+void KeccakP1600_AVX512_Permute_24rounds(void *state)
+{
+    declareState
+    unsigned long long *stateAsLanes = (unsigned long long*)state;
+
+    copyFromState(stateAsLanes)
+    rounds24
+    copyToState(stateAsLanes)
+}
+
+/* ---------------------------------------------------------------- */
+
+size_t KeccakF1600_AVX512_FastLoop_Absorb(void *state, unsigned int laneCount, const unsigned char *data, size_t dataByteLen)
+{
+    size_t originalDataByteLen = dataByteLen;
+    declareState
+    unsigned long long *stateAsLanes = (unsigned long long*)state;
+    const unsigned long long *inDataAsLanes = (const unsigned long long*)data;
+    __mmask8 inMask[5];
+    unsigned int y;
+
+    /* Which lanes of each row receive input, for a rate of laneCount lanes */
+    for (y = 0; y < 5; y++)
+        inMask[y] = (laneCount >= 5*y + 5) ? 0x1F : (laneCount > 5*y) ? (__mmask8)((1 << (laneCount - 5*y)) - 1) : 0;
+
+    copyFromState(stateAsLanes)
+    while(dataByteLen >= laneCount*8) {
+        A0 = _mm512_xor_si512(A0, _mm512_maskz_loadu_epi64(inMask[0], inDataAsLanes +  0));
+        A1 = _mm512_xor_si512(A1, _mm512_maskz_loadu_epi64(inMask[1], inDataAsLanes +  5));
+        A2 = _mm512_xor_si512(A2, _mm512_maskz_loadu_epi64(inMask[2], inDataAsLanes + 10));
+        A3 = _mm512_xor_si512(A3, _mm512_maskz_loadu_epi64(inMask[3], inDataAsLanes + 15));
+        A4 = _mm512_xor_si512(A4, _mm512_maskz_loadu_epi64(inMask[4], inDataAsLanes + 20));
+        rounds24
+        inDataAsLanes += laneCount;
+        dataByteLen -= laneCount*8;
+    }
+    copyToState(stateAsLanes)
+    return originalDataByteLen - dataByteLen;
+}
+
+#endif
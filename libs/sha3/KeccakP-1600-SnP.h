@@ -45,5 +45,14 @@ void KeccakP1600_Permute_24rounds(void *state);
 void KeccakP1600_ExtractBytes(const void *state, unsigned char *data, unsigned int offset, unsigned int length);
 void KeccakP1600_ExtractAndAddBytes(const void *state, const unsigned char *input, unsigned char *output, unsigned int offset, unsigned int length);
 size_t KeccakF1600_FastLoop_Absorb(void *state, unsigned int laneCount, const unsigned char *data, size_t dataByteLen);
+#define KeccakP1600_12rounds_FastLoop_supported
+size_t KeccakP1600_12rounds_FastLoop_Absorb(void *state, unsigned int laneCount, const unsigned char *data, size_t dataByteLen);
+
+/* AVX-512 intrinsics are only available starting with Visual Studio 2017 15.3 */
+#if defined(_MSC_VER) && (_MSC_VER >= 1911)
+#define KeccakP1600_AVX512_supported
+void KeccakP1600_AVX512_Permute_24rounds(void *state);
+size_t KeccakF1600_AVX512_FastLoop_Absorb(void *state, unsigned int laneCount, const unsigned char *data, size_t dataByteLen);
+#endif
 
 #endif
@@ -0,0 +1,316 @@
+/*
+Keccak-p[1600]x4 for processors with AVX2: four independent instances of the
+permutation, one per 64-bit element of a YMM register.  A single Keccak-p
+state does not vectorize well with AVX2, but four unrelated sponges (such as
+the SHA3 states of four small files, see sha3_mb.c) can all be absorbed in
+less time than it takes the generic implementation to absorb just one.
+
+The states are interleaved: lane i of instance j is at ((UINT64*)states)[4*i + j].
+This implementation does not use lane complementing.
+*/
+
+#include <string.h>
+#include <immintrin.h>
+#include "KeccakP-1600-times4-SnP.h"
+
+static const unsigned long long KeccakP1600times4_RoundConstants[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+    0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL };
+
+#define LOAD256(a)              _mm256_load_si256((const __m256i *)&(a))
+#define STORE256(a, b)          _mm256_store_si256((__m256i *)&(a), b)
+#define XOR256(a, b)            _mm256_xor_si256(a, b)
+#define XOR5(a, b, c, d, e)     XOR256(XOR256(XOR256(a, b), XOR256(c, d)), e)
+#define ANDNOT256(a, b)         _mm256_andnot_si256(a, b)  /* ~a & b */
+#define CONST256_64(a)          _mm256_set1_epi64x(a)
+
+/* Rotations by a multiple of 8 bits are a single byte shuffle */
+#define ROL64in256(d, o) \
+    (((o) == 8) ? _mm256_shuffle_epi8(d, rho8) : \
+     ((o) == 56) ? _mm256_shuffle_epi8(d, rho56) : \
+     _mm256_or_si256(_mm256_slli_epi64(d, o), _mm256_srli_epi64(d, 64 - (o))))
+
+#define declareABCDE \
+    __m256i Aba, Abe, Abi, Abo, Abu, Aga, Age, Agi, Ago, Agu, Aka, Ake, Aki; \
+    __m256i Ako, Aku, Ama, Ame, Ami, Amo, Amu, Asa, Ase, Asi, Aso, Asu; \
+    __m256i Bba, Bbe, Bbi, Bbo, Bbu, Bga, Bge, Bgi, Bgo, Bgu, Bka, Bke, Bki; \
+    __m256i Bko, Bku, Bma, Bme, Bmi, Bmo, Bmu, Bsa, Bse, Bsi, Bso, Bsu; \
+    __m256i Eba, Ebe, Ebi, Ebo, Ebu, Ega, Ege, Egi, Ego, Egu, Eka, Eke, Eki; \
+    __m256i Eko, Eku, Ema, Eme, Emi, Emo, Emu, Esa, Ese, Esi, Eso, Esu; \
+    __m256i Ca, Ce, Ci, Co, Cu, Da, De, Di, Do, Du; \
+    const __m256i rho8 = _mm256_set_epi64x(0x0E0D0C0B0A09080FULL, 0x0605040302010007ULL, \
+                                           0x0E0D0C0B0A09080FULL, 0x0605040302010007ULL); \
+    const __m256i rho56 = _mm256_set_epi64x(0x080F0E0D0C0B0A09ULL, 0x0007060504030201ULL, \
+                                            0x080F0E0D0C0B0A09ULL, 0x0007060504030201ULL); \
+    unsigned int i;
+
+#define thetaRhoPiChiIota(i, A, E) \
+    /* Theta */ \
+    Ca = XOR5(A##ba, A##ga, A##ka, A##ma, A##sa); \
+    Ce = XOR5(A##be, A##ge, A##ke, A##me, A##se); \
+    Ci = XOR5(A##bi, A##gi, A##ki, A##mi, A##si); \
+    Co = XOR5(A##bo, A##go, A##ko, A##mo, A##so); \
+    Cu = XOR5(A##bu, A##gu, A##ku, A##mu, A##su); \
+    Da = XOR256(Cu, ROL64in256(Ce, 1)); \
+    De = XOR256(Ca, ROL64in256(Ci, 1)); \
+    Di = XOR256(Ce, ROL64in256(Co, 1)); \
+    Do = XOR256(Ci, ROL64in256(Cu, 1)); \
+    Du = XOR256(Co, ROL64in256(Ca, 1)); \
+    /* Rho and pi */ \
+    Bba = XOR256(A##ba, Da); \
+    Bbe = ROL64in256(XOR256(A##ge, De), 44); \
+    Bbi = ROL64in256(XOR256(A##ki, Di), 43); \
+    Bbo = ROL64in256(XOR256(A##mo, Do), 21); \
+    Bbu = ROL64in256(XOR256(A##su, Du), 14); \
+    Bga = ROL64in256(XOR256(A##bo, Do), 28); \
+    Bge = ROL64in256(XOR256(A##gu, Du), 20); \
+    Bgi = ROL64in256(XOR256(A##ka, Da), 3); \
+    Bgo = ROL64in256(XOR256(A##me, De), 45); \
+    Bgu = ROL64in256(XOR256(A##si, Di), 61); \
+    Bka = ROL64in256(XOR256(A##be, De), 1); \
+    Bke = ROL64in256(XOR256(A##gi, Di), 6); \
+    Bki = ROL64in256(XOR256(A##ko, Do), 25); \
+    Bko = ROL64in256(XOR256(A##mu, Du), 8); \
+    Bku = ROL64in256(XOR256(A##sa, Da), 18); \
+    Bma = ROL64in256(XOR256(A##bu, Du), 27); \
+    Bme = ROL64in256(XOR256(A##ga, Da), 36); \
+    Bmi = ROL64in256(XOR256(A##ke, De), 10); \
+    Bmo = ROL64in256(XOR256(A##mi, Di), 15); \
+    Bmu = ROL64in256(XOR256(A##so, Do), 56); \
+    Bsa = ROL64in256(XOR256(A##bi, Di), 62); \
+    Bse = ROL64in256(XOR256(A##go, Do), 55); \
+    Bsi = ROL64in256(XOR256(A##ku, Du), 39); \
+    Bso = ROL64in256(XOR256(A##ma, Da), 41); \
+    Bsu = ROL64in256(XOR256(A##se, De), 2); \
+    /* Chi and iota */ \
+    E##ba = XOR256(Bba, ANDNOT256(Bbe, Bbi)); \
+    E##be = XOR256(Bbe, ANDNOT256(Bbi, Bbo)); \
+    E##bi = XOR256(Bbi, ANDNOT256(Bbo, Bbu)); \
+    E##bo = XOR256(Bbo, ANDNOT256(Bbu, Bba)); \
+    E##bu = XOR256(Bbu, ANDNOT256(Bba, Bbe)); \
+    E##ga = XOR256(Bga, ANDNOT256(Bge, Bgi)); \
+    E##ge = XOR256(Bge, ANDNOT256(Bgi, Bgo)); \
+    E##gi = XOR256(Bgi, ANDNOT256(Bgo, Bgu)); \
+    E##go = XOR256(Bgo, ANDNOT256(Bgu, Bga)); \
+    E##gu = XOR256(Bgu, ANDNOT256(Bga, Bge)); \
+    E##ka = XOR256(Bka, ANDNOT256(Bke, Bki)); \
+    E##ke = XOR256(Bke, ANDNOT256(Bki, Bko)); \
+    E##ki = XOR256(Bki, ANDNOT256(Bko, Bku)); \
+    E##ko = XOR256(Bko, ANDNOT256(Bku, Bka)); \
+    E##ku = XOR256(Bku, ANDNOT256(Bka, Bke)); \
+    E##ma = XOR256(Bma, ANDNOT256(Bme, Bmi)); \
+    E##me = XOR256(Bme, ANDNOT256(Bmi, Bmo)); \
+    E##mi = XOR256(Bmi, ANDNOT256(Bmo, Bmu)); \
+    E##mo = XOR256(Bmo, ANDNOT256(Bmu, Bma)); \
+    E##mu = XOR256(Bmu, ANDNOT256(Bma, Bme)); \
+    E##sa = XOR256(Bsa, ANDNOT256(Bse, Bsi)); \
+    E##se = XOR256(Bse, ANDNOT256(Bsi, Bso)); \
+    E##si = XOR256(Bsi, ANDNOT256(Bso, Bsu)); \
+    E##so = XOR256(Bso, ANDNOT256(Bsu, Bsa)); \
+    E##su = XOR256(Bsu, ANDNOT256(Bsa, Bse)); \
+    E##ba = XOR256(E##ba, CONST256_64(KeccakP1600times4_RoundConstants[i])); \
+
+#define rounds24 \
+    for (i = 0; i < 24; i += 2) { \
+        thetaRhoPiChiIota(i, A, E) \
+        thetaRhoPiChiIota(i + 1, E, A) \
+    }
+
+#define rounds12 \
+    for (i = 12; i < 24; i += 2) { \
+        thetaRhoPiChiIota(i, A, E) \
+        thetaRhoPiChiIota(i + 1, E, A) \
+    }
+
+#define copyFromState(X, stateAsLanes) \
+    X##ba = LOAD256(stateAsLanes[ 0]); \
+    X##be = LOAD256(stateAsLanes[ 1]); \
+    X##bi = LOAD256(stateAsLanes[ 2]); \
+    X##bo = LOAD256(stateAsLanes[ 3]); \
+    X##bu = LOAD256(stateAsLanes[ 4]); \
+    X##ga = LOAD256(stateAsLanes[ 5]); \
+    X##ge = LOAD256(stateAsLanes[ 6]); \
+    X##gi = LOAD256(stateAsLanes[ 7]); \
+    X##go = LOAD256(stateAsLanes[ 8]); \
+    X##gu = LOAD256(stateAsLanes[ 9]); \
+    X##ka = LOAD256(stateAsLanes[10]); \
+    X##ke = LOAD256(stateAsLanes[11]); \
+    X##ki = LOAD256(stateAsLanes[12]); \
+    X##ko = LOAD256(stateAsLanes[13]); \
+    X##ku = LOAD256(stateAsLanes[14]); \
+    X##ma = LOAD256(stateAsLanes[15]); \
+    X##me = LOAD256(stateAsLanes[16]); \
+    X##mi = LOAD256(stateAsLanes[17]); \
+    X##mo = LOAD256(stateAsLanes[18]); \
+    X##mu = LOAD256(stateAsLanes[19]); \
+    X##sa = LOAD256(stateAsLanes[20]); \
+    X##se = LOAD256(stateAsLanes[21]); \
+    X##si = LOAD256(stateAsLanes[22]); \
+    X##so = LOAD256(stateAsLanes[23]); \
+    X##su = LOAD256(stateAsLanes[24]);
+
+#define copyToState(stateAsLanes, X) \
+    STORE256(stateAsLanes[ 0], X##ba); \
+    STORE256(stateAsLanes[ 1], X##be); \
+    STORE256(stateAsLanes[ 2], X##bi); \
+    STORE256(stateAsLanes[ 3], X##bo); \
+    STORE256(stateAsLanes[ 4], X##bu); \
+    STORE256(stateAsLanes[ 5], X##ga); \
+    STORE256(stateAsLanes[ 6], X##ge); \
+    STORE256(stateAsLanes[ 7], X##gi); \
+    STORE256(stateAsLanes[ 8], X##go); \
+    STORE256(stateAsLanes[ 9], X##gu); \
+    STORE256(stateAsLanes[10], X##ka); \
+    STORE256(stateAsLanes[11], X##ke); \
+    STORE256(stateAsLanes[12], X##ki); \
+    STORE256(stateAsLanes[13], X##ko); \
+    STORE256(stateAsLanes[14], X##ku); \
+    STORE256(stateAsLanes[15], X##ma); \
+    STORE256(stateAsLanes[16], X##me); \
+    STORE256(stateAsLanes[17], X##mi); \
+    STORE256(stateAsLanes[18], X##mo); \
+    STORE256(stateAsLanes[19], X##mu); \
+    STORE256(stateAsLanes[20], X##sa); \
+    STORE256(stateAsLanes[21], X##se); \
+    STORE256(stateAsLanes[22], X##si); \
+    STORE256(stateAsLanes[23], X##so); \
+    STORE256(stateAsLanes[24], X##su);
+
+/* Adds the first laneCount lanes of one block into the state */
+#define addLanes(X, lanes, laneCount) \
+    switch (laneCount) { \
+        case 25: X##su = XOR256(X##su, lanes[24]); \
+        case 24: X##so = XOR256(X##so, lanes[23]); \
+        case 23: X##si = XOR256(X##si, lanes[22]); \
+        case 22: X##se = XOR256(X##se, lanes[21]); \
+        case 21: X##sa = XOR256(X##sa, lanes[20]); \
+        case 20: X##mu = XOR256(X##mu, lanes[19]); \
+        case 19: X##mo = XOR256(X##mo, lanes[18]); \
+        case 18: X##mi = XOR256(X##mi, lanes[17]); \
+        case 17: X##me = XOR256(X##me, lanes[16]); \
+        case 16: X##ma = XOR256(X##ma, lanes[15]); \
+        case 15: X##ku = XOR256(X##ku, lanes[14]); \
+        case 14: X##ko = XOR256(X##ko, lanes[13]); \
+        case 13: X##ki = XOR256(X##ki, lanes[12]); \
+        case 12: X##ke = XOR256(X##ke, lanes[11]); \
+        case 11: X##ka = XOR256(X##ka, lanes[10]); \
+        case 10: X##gu = XOR256(X##gu, lanes[ 9]); \
+        case  9: X##go = XOR256(X##go, lanes[ 8]); \
+        case  8: X##gi = XOR256(X##gi, lanes[ 7]); \
+        case  7: X##ge = XOR256(X##ge, lanes[ 6]); \
+        case  6: X##ga = XOR256(X##ga, lanes[ 5]); \
+        case  5: X##bu = XOR256(X##bu, lanes[ 4]); \
+        case  4: X##bo = XOR256(X##bo, lanes[ 3]); \
+        case  3: X##bi = XOR256(X##bi, lanes[ 2]); \
+        case  2: X##be = XOR256(X##be, lanes[ 1]); \
+        case  1: X##ba = XOR256(X##ba, lanes[ 0]); \
+    }
+
+/* ---------------------------------------------------------------- */
+
+void KeccakP1600times4_InitializeAll(void *states)
+{
+    memset(states, 0, KeccakP1600times4_statesSizeInBytes);
+}
+
+/* ---------------------------------------------------------------- */
+
+void KeccakP1600times4_PermuteAll_24rounds(void *states)
+{
+    declareABCDE
+    __m256i *stateAsLanes = (__m256i *)states;
+
+    copyFromState(A, stateAsLanes)
+    rounds24
+    copyToState(stateAsLanes, A)
+}
+
+/* ---------------------------------------------------------------- */
+
+void KeccakF1600times4_FastLoop_AbsorbMulti(void *states, unsigned int laneCount, const unsigned char * const *data, size_t blockCount)
+{
+    declareABCDE
+    __m256i *stateAsLanes = (__m256i *)states;
+    __m256i lanes[25], t0, t1, t2, t3, u0, u1, u2, u3;
+    const unsigned char *in0 = data[0], *in1 = data[1], *in2 = data[2], *in3 = data[3];
+    unsigned int j;
+
+    copyFromState(A, stateAsLanes)
+    for ( ; blockCount; blockCount--) {
+        /* Transpose four lanes at a time from the four inputs */
+        for (j = 0; j + 4 <= laneCount; j += 4) {
+            t0 = _mm256_loadu_si256((const __m256i *)(in0 + 8*j));
+            t1 = _mm256_loadu_si256((const __m256i *)(in1 + 8*j));
+            t2 = _mm256_loadu_si256((const __m256i *)(in2 + 8*j));
+            t3 = _mm256_loadu_si256((const __m256i *)(in3 + 8*j));
+            u0 = _mm256_unpacklo_epi64(t0, t1);
+            u1 = _mm256_unpackhi_epi64(t0, t1);
+            u2 = _mm256_unpacklo_epi64(t2, t3);
+            u3 = _mm256_unpackhi_epi64(t2, t3);
+            lanes[j + 0] = _mm256_permute2x128_si256(u0, u2, 0x20);
+            lanes[j + 1] = _mm256_permute2x128_si256(u1, u3, 0x20);
+            lanes[j + 2] = _mm256_permute2x128_si256(u0, u2, 0x31);
+            lanes[j + 3] = _mm256_permute2x128_si256(u1, u3, 0x31);
+        }
+        for ( ; j < laneCount; j++)
+            lanes[j] = _mm256_set_epi64x(((const long long *)in3)[j], ((const long long *)in2)[j],
+                                         ((const long long *)in1)[j], ((const long long *)in0)[j]);
+
+        addLanes(A, lanes, laneCount)
+        rounds24
+
+        in0 += laneCount*8;
+        in1 += laneCount*8;
+        in2 += laneCount*8;
+        in3 += laneCount*8;
+    }
+    copyToState(stateAsLanes, A)
+}
+
+/* ---------------------------------------------------------------- */
+
+void KeccakP1600times4_12rounds_FastLoop_AbsorbMulti(void *states, unsigned int laneCount, const unsigned char * const *data, size_t blockCount)
+{
+    declareABCDE
+    __m256i *stateAsLanes = (__m256i *)states;
+    __m256i lanes[25], t0, t1, t2, t3, u0, u1, u2, u3;
+    const unsigned char *in0 = data[0], *in1 = data[1], *in2 = data[2], *in3 = data[3];
+    unsigned int j;
+
+    copyFromState(A, stateAsLanes)
+    for ( ; blockCount; blockCount--) {
+        /* Transpose four lanes at a time from the four inputs */
+        for (j = 0; j + 4 <= laneCount; j += 4) {
+            t0 = _mm256_loadu_si256((const __m256i *)(in0 + 8*j));
+            t1 = _mm256_loadu_si256((const __m256i *)(in1 + 8*j));
+            t2 = _mm256_loadu_si256((const __m256i *)(in2 + 8*j));
+            t3 = _mm256_loadu_si256((const __m256i *)(in3 + 8*j));
+            u0 = _mm256_unpacklo_epi64(t0, t1);
+            u1 = _mm256_unpackhi_epi64(t0, t1);
+            u2 = _mm256_unpacklo_epi64(t2, t3);
+            u3 = _mm256_unpackhi_epi64(t2, t3);
+            lanes[j + 0] = _mm256_permute2x128_si256(u0, u2, 0x20);
+            lanes[j + 1] = _mm256_permute2x128_si256(u1, u3, 0x20);
+            lanes[j + 2] = _mm256_permute2x128_si256(u0, u2, 0x31);
+            lanes[j + 3] = _mm256_permute2x128_si256(u1, u3, 0x31);
+        }
+        for ( ; j < laneCount; j++)
+            lanes[j] = _mm256_set_epi64x(((const long long *)in3)[j], ((const long long *)in2)[j],
+                                         ((const long long *)in1)[j], ((const long long *)in0)[j]);
+
+        addLanes(A, lanes, laneCount)
+        rounds12
+
+        in0 += laneCount*8;
+        in1 += laneCount*8;
+        in2 += laneCount*8;
+        in3 += laneCount*8;
+    }
+    copyToState(stateAsLanes, A)
+}
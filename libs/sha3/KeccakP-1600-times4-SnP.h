@@ -0,0 +1,29 @@
+/*
+Keccak-p[1600]x4, four interleaved instances of Keccak-p[1600] processed in
+parallel, see KeccakP-1600-times4-SIMD256.c.
+
+This follows the naming of the KeccakP1600times4 SnP interface, except that
+the absorbing loop takes a separate input pointer for each instance, since
+the inputs are typically four unrelated messages.
+*/
+
+#ifndef _KeccakP_1600_times4_SnP_h_
+#define _KeccakP_1600_times4_SnP_h_
+
+#include <stddef.h>
+
+#define KeccakP1600times4_implementation        "256-bit SIMD implementation (AVX2)"
+#define KeccakP1600times4_statesSizeInBytes     800
+#define KeccakP1600times4_statesAlignment       32
+
+void KeccakP1600times4_InitializeAll(void *states);
+void KeccakP1600times4_PermuteAll_24rounds(void *states);
+
+/* Absorbs blockCount blocks of laneCount lanes from each of the four inputs,
+   data[j] being the input of instance j, applying the permutation after each */
+void KeccakF1600times4_FastLoop_AbsorbMulti(void *states, unsigned int laneCount, const unsigned char * const *data, size_t blockCount);
+
+/* The same, using Keccak-p[1600, 12] as in KangarooTwelve */
+void KeccakP1600times4_12rounds_FastLoop_AbsorbMulti(void *states, unsigned int laneCount, const unsigned char * const *data, size_t blockCount);
+
+#endif
@@ -75,13 +75,65 @@ http://creativecommons.org/publicdomain/zero/1.0/
 
 #ifndef KeccakP1600_excluded
     #include "KeccakP-1600-SnP.h"
+    #include "../WinHashDispatch.h"
+
+    /* The permutation is selected on first use, see WinHashDispatch.h */
+    typedef void (*PFNKECCAKP1600PERMUTE)(void *state);
+    typedef size_t (*PFNKECCAKF1600FASTLOOPABSORB)(void *state, unsigned int laneCount, const unsigned char *data, size_t dataByteLen);
+
+    typedef struct {
+        PFNKECCAKP1600PERMUTE Permute;
+        PFNKECCAKF1600FASTLOOPABSORB FastLoop_Absorb;
+    } KeccakP1600_Backend;
+
+    #ifdef KeccakP1600_AVX512_supported
+    static const KeccakP1600_Backend KeccakP1600_AVX512_Backend = {
+        KeccakP1600_AVX512_Permute_24rounds, KeccakF1600_AVX512_FastLoop_Absorb };
+    #endif
+    static const KeccakP1600_Backend KeccakP1600_opt64_Backend = {
+        KeccakP1600_Permute_24rounds, KeccakF1600_FastLoop_Absorb };
+
+    static const WHKERNEL KeccakP1600_Kernels[] = {
+    #ifdef KeccakP1600_AVX512_supported
+        { "avx512",     CPUF_AVX512F, 0, (PVOID)&KeccakP1600_AVX512_Backend },
+    #endif
+        { WHK_PORTABLE, 0,            0, (PVOID)&KeccakP1600_opt64_Backend }
+    };
+
+    WHKERNELSLOT g_ksKeccakP1600 = { "keccak", KeccakP1600_Kernels, ARRAYSIZE(KeccakP1600_Kernels), NULL };
+
+    static void KeccakP1600_PermuteSelect(void *state);
+    static size_t KeccakF1600_FastLoop_AbsorbSelect(void *state, unsigned int laneCount, const unsigned char *data, size_t dataByteLen);
+
+    static PFNKECCAKP1600PERMUTE KeccakP1600_PermuteSelected = KeccakP1600_PermuteSelect;
+    static PFNKECCAKF1600FASTLOOPABSORB KeccakF1600_FastLoop_AbsorbSelected = KeccakF1600_FastLoop_AbsorbSelect;
+
+    static void KeccakP1600_Select(void)
+    {
+        const KeccakP1600_Backend *backend = (const KeccakP1600_Backend *)WHBindKernel(&g_ksKeccakP1600);
+
+        KeccakP1600_PermuteSelected = backend->Permute;
+        KeccakF1600_FastLoop_AbsorbSelected = backend->FastLoop_Absorb;
+    }
+
+    static void KeccakP1600_PermuteSelect(void *state)
+    {
+        KeccakP1600_Select();
+        KeccakP1600_PermuteSelected(state);
+    }
+
+    static size_t KeccakF1600_FastLoop_AbsorbSelect(void *state, unsigned int laneCount, const unsigned char *data, size_t dataByteLen)
+    {
+        KeccakP1600_Select();
+        return KeccakF1600_FastLoop_AbsorbSelected(state, laneCount, data, dataByteLen);
+    }
 
     #define prefix KeccakWidth1600
     #define SnP KeccakP1600
     #define SnP_width 1600
-    #define SnP_Permute KeccakP1600_Permute_24rounds
+    #define SnP_Permute KeccakP1600_PermuteSelected
     #if defined(KeccakF1600_FastLoop_supported)
-        #define SnP_FastLoop_Absorb KeccakF1600_FastLoop_Absorb
+        #define SnP_FastLoop_Absorb KeccakF1600_FastLoop_AbsorbSelected
     #endif
         #include "KeccakSponge.inc"
     #undef prefix
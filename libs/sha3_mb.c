@@ -0,0 +1,57 @@
+/**
+ * Multi-Buffer SHA3
+ * Last modified: 2026/10/18
+ *
+ * WinHashMB kernels that run 4 independent SHA3-256 or SHA3-512 sponges side
+ * by side with the AVX2 Keccak-p[1600]x4 permutation.  WinHashMB has already
+ * applied the padding, so all that is left to do here is to absorb; since
+ * both rates are larger than the digests, squeezing is then just a matter of
+ * reading out the first lanes.  The states are stored interleaved: lane i of
+ * sponge l is at state[i * cLanes + l].
+ **/
+
+#include "WinHashMB.h"
+#include "sha3/KeccakP-1600-times4-SnP.h"
+
+VOID WHAPI SHA3MBInitLane( PVOID pvState, UINT cLanes, UINT iLane )
+{
+	UINT64 *state = (UINT64 *)pvState;
+	UINT i;
+
+	for (i = 0; i < 25; ++i)
+		state[i * cLanes + iLane] = 0;
+}
+
+static VOID WHAPI SHA3MBFinalLane( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest, UINT cbDigest )
+{
+	const UINT64 *state = (const UINT64 *)pvState;
+	UINT i, j;
+
+	for (i = 0; i < cbDigest / 8; ++i)
+	{
+		UINT64 lane = state[i * cLanes + iLane];
+
+		for (j = 0; j < 8; ++j, lane >>= 8)
+			*pbDigest++ = (BYTE)lane;
+	}
+}
+
+VOID WHAPI SHA3_256MBFinalLane( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest )
+{
+	SHA3MBFinalLane(pvState, cLanes, iLane, pbDigest, SHA3_256_DIGEST_LENGTH);
+}
+
+VOID WHAPI SHA3_256MBTransformAVX2( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks )
+{
+	KeccakF1600times4_FastLoop_AbsorbMulti(pvState, SHA3_256_BLOCK_LENGTH / 8, ppbData, cBlocks);
+}
+
+VOID WHAPI SHA3_512MBFinalLane( LPCVOID pvState, UINT cLanes, UINT iLane, PBYTE pbDigest )
+{
+	SHA3MBFinalLane(pvState, cLanes, iLane, pbDigest, SHA3_512_DIGEST_LENGTH);
+}
+
+VOID WHAPI SHA3_512MBTransformAVX2( PVOID pvState, const PCBYTE *ppbData, UINT cBlocks )
+{
+	KeccakF1600times4_FastLoop_AbsorbMulti(pvState, SHA3_512_BLOCK_LENGTH / 8, ppbData, cBlocks);
+}
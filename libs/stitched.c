@@ -0,0 +1,712 @@
+/**
+ * Stitched kernels
+ * Last modified: 2026/10/18
+ *
+ * MD5, SHA-1, and SHA-256 are each one long chain of dependent operations per
+ * block, so on their own they leave most of a modern processor's execution
+ * ports idle.  When two algorithms are requested together, their rounds can
+ * be interleaved ("stitched") in one loop, and the processor then overlaps
+ * the two chains for far less than the cost of running them one after the
+ * other.  This covers the two pairs most often requested together: MD5 with
+ * SHA-1, and SHA-256 with CRC-32.
+ *
+ * Each of the kernels below has the same effect as the separate transforms in
+ * md5.c, sha1.c, sha2.c, and crc32.c, whose round macros they repeat.  When
+ * SHA-NI is available, SHA-1 or SHA-256 runs in the vector unit alongside
+ * MD5's scalar steps or CRC-32's carry-less multiplies.
+ **/
+
+#include "WinHash.h"
+#include "WinHashDispatch.h"
+#include <immintrin.h>
+#include <intrin.h>
+
+/**
+ * MD5 + SHA-1
+ **/
+
+// As in md5.c
+#define F1(x, y, z) (z ^ (x & (y ^ z)))
+#define F2(x, y, z) F1(z, x, y)
+#define F3(x, y, z) (x ^ y ^ z)
+#define F4(x, y, z) (y ^ (x | ~z))
+
+#define MD5STEP(f, w, x, y, z, data, s) \
+	( w += f(x, y, z) + data,  w = RotLV32(w, s),  w += x )
+
+// As in sha1.c
+#define rol(value, bits) (RotLV32((value), (bits)))
+
+#define blk0(i) (block[i] = (rol(block[i],24)&0xFF00FF00)|(rol(block[i],8)&0x00FF00FF))
+#define blk(i) (block[i&15] = rol(block[(i+13)&15]^block[(i+8)&15]^block[(i+2)&15]^block[i&15],1))
+
+#define R0(v,w,x,y,z,i) z+=((w&(x^y))^y)+blk0(i)+0x5A827999+rol(v,5);w=rol(w,30);
+#define R1(v,w,x,y,z,i) z+=((w&(x^y))^y)+blk(i)+0x5A827999+rol(v,5);w=rol(w,30);
+#define R2(v,w,x,y,z,i) z+=(w^x^y)+blk(i)+0x6ED9EBA1+rol(v,5);w=rol(w,30);
+#define R3(v,w,x,y,z,i) z+=(((w|x)&y)|(w&x))+blk(i)+0x8F1BBCDC+rol(v,5);w=rol(w,30);
+#define R4(v,w,x,y,z,i) z+=(w^x^y)+blk(i)+0xCA62C1D6+rol(v,5);w=rol(w,30);
+
+typedef VOID (WHAPI *PFNMD5SHA1BLOCKS)( UINT32 md5[4], UINT32 sha1[5], PCBYTE pbIn, UINT cBlocks );
+
+// Five SHA-1 rounds for every four MD5 steps
+static VOID WHAPI Md5Sha1BlocksC( UINT32 md5[4], UINT32 sha1[5], PCBYTE pbIn, UINT cBlocks )
+{
+	UINT32 ma, mb, mc, md, in[16];
+	UINT32 sa, sb, sc, sd, se, block[16];
+
+	for ( ; cBlocks; --cBlocks, pbIn += MD5_BLOCK_LENGTH)
+	{
+		// x86 is little-endian, as are MD5's message words (SHA-1's are
+		// swapped by blk0)
+		memcpy(in, pbIn, sizeof(in));
+		memcpy(block, pbIn, sizeof(block));
+
+		ma = md5[0]; mb = md5[1]; mc = md5[2]; md = md5[3];
+		sa = sha1[0]; sb = sha1[1]; sc = sha1[2]; sd = sha1[3]; se = sha1[4];
+
+		R0(sa,sb,sc,sd,se, 0); R0(se,sa,sb,sc,sd, 1); R0(sd,se,sa,sb,sc, 2); R0(sc,sd,se,sa,sb, 3); R0(sb,sc,sd,se,sa, 4);
+		MD5STEP(F1, ma, mb, mc, md, in[ 0] + 0xd76aa478,  7);
+		MD5STEP(F1, md, ma, mb, mc, in[ 1] + 0xe8c7b756, 12);
+		MD5STEP(F1, mc, md, ma, mb, in[ 2] + 0x242070db, 17);
+		MD5STEP(F1, mb, mc, md, ma, in[ 3] + 0xc1bdceee, 22);
+		R0(sa,sb,sc,sd,se, 5); R0(se,sa,sb,sc,sd, 6); R0(sd,se,sa,sb,sc, 7); R0(sc,sd,se,sa,sb, 8); R0(sb,sc,sd,se,sa, 9);
+		MD5STEP(F1, ma, mb, mc, md, in[ 4] + 0xf57c0faf,  7);
+		MD5STEP(F1, md, ma, mb, mc, in[ 5] + 0x4787c62a, 12);
+		MD5STEP(F1, mc, md, ma, mb, in[ 6] + 0xa8304613, 17);
+		MD5STEP(F1, mb, mc, md, ma, in[ 7] + 0xfd469501, 22);
+		R0(sa,sb,sc,sd,se,10); R0(se,sa,sb,sc,sd,11); R0(sd,se,sa,sb,sc,12); R0(sc,sd,se,sa,sb,13); R0(sb,sc,sd,se,sa,14);
+		MD5STEP(F1, ma, mb, mc, md, in[ 8] + 0x698098d8,  7);
+		MD5STEP(F1, md, ma, mb, mc, in[ 9] + 0x8b44f7af, 12);
+		MD5STEP(F1, mc, md, ma, mb, in[10] + 0xffff5bb1, 17);
+		MD5STEP(F1, mb, mc, md, ma, in[11] + 0x895cd7be, 22);
+		R0(sa,sb,sc,sd,se,15); R1(se,sa,sb,sc,sd,16); R1(sd,se,sa,sb,sc,17); R1(sc,sd,se,sa,sb,18); R1(sb,sc,sd,se,sa,19);
+		MD5STEP(F1, ma, mb, mc, md, in[12] + 0x6b901122,  7);
+		MD5STEP(F1, md, ma, mb, mc, in[13] + 0xfd987193, 12);
+		MD5STEP(F1, mc, md, ma, mb, in[14] + 0xa679438e, 17);
+		MD5STEP(F1, mb, mc, md, ma, in[15] + 0x49b40821, 22);
+		R2(sa,sb,sc,sd,se,20); R2(se,sa,sb,sc,sd,21); R2(sd,se,sa,sb,sc,22); R2(sc,sd,se,sa,sb,23); R2(sb,sc,sd,se,sa,24);
+		MD5STEP(F2, ma, mb, mc, md, in[ 1] + 0xf61e2562,  5);
+		MD5STEP(F2, md, ma, mb, mc, in[ 6] + 0xc040b340,  9);
+		MD5STEP(F2, mc, md, ma, mb, in[11] + 0x265e5a51, 14);
+		MD5STEP(F2, mb, mc, md, ma, in[ 0] + 0xe9b6c7aa, 20);
+		R2(sa,sb,sc,sd,se,25); R2(se,sa,sb,sc,sd,26); R2(sd,se,sa,sb,sc,27); R2(sc,sd,se,sa,sb,28); R2(sb,sc,sd,se,sa,29);
+		MD5STEP(F2, ma, mb, mc, md, in[ 5] + 0xd62f105d,  5);
+		MD5STEP(F2, md, ma, mb, mc, in[10] + 0x02441453,  9);
+		MD5STEP(F2, mc, md, ma, mb, in[15] + 0xd8a1e681, 14);
+		MD5STEP(F2, mb, mc, md, ma, in[ 4] + 0xe7d3fbc8, 20);
+		R2(sa,sb,sc,sd,se,30); R2(se,sa,sb,sc,sd,31); R2(sd,se,sa,sb,sc,32); R2(sc,sd,se,sa,sb,33); R2(sb,sc,sd,se,sa,34);
+		MD5STEP(F2, ma, mb, mc, md, in[ 9] + 0x21e1cde6,  5);
+		MD5STEP(F2, md, ma, mb, mc, in[14] + 0xc33707d6,  9);
+		MD5STEP(F2, mc, md, ma, mb, in[ 3] + 0xf4d50d87, 14);
+		MD5STEP(F2, mb, mc, md, ma, in[ 8] + 0x455a14ed, 20);
+		R2(sa,sb,sc,sd,se,35); R2(se,sa,sb,sc,sd,36); R2(sd,se,sa,sb,sc,37); R2(sc,sd,se,sa,sb,38); R2(sb,sc,sd,se,sa,39);
+		MD5STEP(F2, ma, mb, mc, md, in[13] + 0xa9e3e905,  5);
+		MD5STEP(F2, md, ma, mb, mc, in[ 2] + 0xfcefa3f8,  9);
+		MD5STEP(F2, mc, md, ma, mb, in[ 7] + 0x676f02d9, 14);
+		MD5STEP(F2, mb, mc, md, ma, in[12] + 0x8d2a4c8a, 20);
+		R3(sa,sb,sc,sd,se,40); R3(se,sa,sb,sc,sd,41); R3(sd,se,sa,sb,sc,42); R3(sc,sd,se,sa,sb,43); R3(sb,sc,sd,se,sa,44);
+		MD5STEP(F3, ma, mb, mc, md, in[ 5] + 0xfffa3942,  4);
+		MD5STEP(F3, md, ma, mb, mc, in[ 8] + 0x8771f681, 11);
+		MD5STEP(F3, mc, md, ma, mb, in[11] + 0x6d9d6122, 16);
+		MD5STEP(F3, mb, mc, md, ma, in[14] + 0xfde5380c, 23);
+		R3(sa,sb,sc,sd,se,45); R3(se,sa,sb,sc,sd,46); R3(sd,se,sa,sb,sc,47); R3(sc,sd,se,sa,sb,48); R3(sb,sc,sd,se,sa,49);
+		MD5STEP(F3, ma, mb, mc, md, in[ 1] + 0xa4beea44,  4);
+		MD5STEP(F3, md, ma, mb, mc, in[ 4] + 0x4bdecfa9, 11);
+		MD5STEP(F3, mc, md, ma, mb, in[ 7] + 0xf6bb4b60, 16);
+		MD5STEP(F3, mb, mc, md, ma, in[10] + 0xbebfbc70, 23);
+		R3(sa,sb,sc,sd,se,50); R3(se,sa,sb,sc,sd,51); R3(sd,se,sa,sb,sc,52); R3(sc,sd,se,sa,sb,53); R3(sb,sc,sd,se,sa,54);
+		MD5STEP(F3, ma, mb, mc, md, in[13] + 0x289b7ec6,  4);
+		MD5STEP(F3, md, ma, mb, mc, in[ 0] + 0xeaa127fa, 11);
+		MD5STEP(F3, mc, md, ma, mb, in[ 3] + 0xd4ef3085, 16);
+		MD5STEP(F3, mb, mc, md, ma, in[ 6] + 0x04881d05, 23);
+		R3(sa,sb,sc,sd,se,55); R3(se,sa,sb,sc,sd,56); R3(sd,se,sa,sb,sc,57); R3(sc,sd,se,sa,sb,58); R3(sb,sc,sd,se,sa,59);
+		MD5STEP(F3, ma, mb, mc, md, in[ 9] + 0xd9d4d039,  4);
+		MD5STEP(F3, md, ma, mb, mc, in[12] + 0xe6db99e5, 11);
+		MD5STEP(F3, mc, md, ma, mb, in[15] + 0x1fa27cf8, 16);
+		MD5STEP(F3, mb, mc, md, ma, in[ 2] + 0xc4ac5665, 23);
+		R4(sa,sb,sc,sd,se,60); R4(se,sa,sb,sc,sd,61); R4(sd,se,sa,sb,sc,62); R4(sc,sd,se,sa,sb,63); R4(sb,sc,sd,se,sa,64);
+		MD5STEP(F4, ma, mb, mc, md, in[ 0] + 0xf4292244,  6);
+		MD5STEP(F4, md, ma, mb, mc, in[ 7] + 0x432aff97, 10);
+		MD5STEP(F4, mc, md, ma, mb, in[14] + 0xab9423a7, 15);
+		MD5STEP(F4, mb, mc, md, ma, in[ 5] + 0xfc93a039, 21);
+		R4(sa,sb,sc,sd,se,65); R4(se,sa,sb,sc,sd,66); R4(sd,se,sa,sb,sc,67); R4(sc,sd,se,sa,sb,68); R4(sb,sc,sd,se,sa,69);
+		MD5STEP(F4, ma, mb, mc, md, in[12] + 0x655b59c3,  6);
+		MD5STEP(F4, md, ma, mb, mc, in[ 3] + 0x8f0ccc92, 10);
+		MD5STEP(F4, mc, md, ma, mb, in[10] + 0xffeff47d, 15);
+		MD5STEP(F4, mb, mc, md, ma, in[ 1] + 0x85845dd1, 21);
+		R4(sa,sb,sc,sd,se,70); R4(se,sa,sb,sc,sd,71); R4(sd,se,sa,sb,sc,72); R4(sc,sd,se,sa,sb,73); R4(sb,sc,sd,se,sa,74);
+		MD5STEP(F4, ma, mb, mc, md, in[ 8] + 0x6fa87e4f,  6);
+		MD5STEP(F4, md, ma, mb, mc, in[15] + 0xfe2ce6e0, 10);
+		MD5STEP(F4, mc, md, ma, mb, in[ 6] + 0xa3014314, 15);
+		MD5STEP(F4, mb, mc, md, ma, in[13] + 0x4e0811a1, 21);
+		R4(sa,sb,sc,sd,se,75); R4(se,sa,sb,sc,sd,76); R4(sd,se,sa,sb,sc,77); R4(sc,sd,se,sa,sb,78); R4(sb,sc,sd,se,sa,79);
+		MD5STEP(F4, ma, mb, mc, md, in[ 4] + 0xf7537e82,  6);
+		MD5STEP(F4, md, ma, mb, mc, in[11] + 0xbd3af235, 10);
+		MD5STEP(F4, mc, md, ma, mb, in[ 2] + 0x2ad7d2bb, 15);
+		MD5STEP(F4, mb, mc, md, ma, in[ 9] + 0xeb86d391, 21);
+		md5[0] += ma; md5[1] += mb; md5[2] += mc; md5[3] += md;
+		sha1[0] += sa; sha1[1] += sb; sha1[2] += sc; sha1[3] += sd; sha1[4] += se;
+	}
+}
+
+// SHA-1's rounds run in the vector unit, four at a time, while MD5's steps
+// run in the scalar units
+static VOID WHAPI Md5Sha1BlocksNI( UINT32 md5[4], UINT32 sha1[5], PCBYTE pbIn, UINT cBlocks )
+{
+	UINT32 ma, mb, mc, md, in[16];
+	__m128i ABCD, ABCD_SAVE, E0, E0_SAVE, E1;
+	__m128i MSG0, MSG1, MSG2, MSG3;
+	const __m128i MASK = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+	PCBYTE data = pbIn;
+
+	ABCD = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)sha1), 0x1B);
+	E0 = _mm_set_epi32(sha1[4], 0, 0, 0);
+
+	for ( ; cBlocks; --cBlocks, data += SHA1_BLOCK_LENGTH)
+	{
+		memcpy(in, data, sizeof(in));
+
+		ma = md5[0]; mb = md5[1]; mc = md5[2]; md = md5[3];
+		ABCD_SAVE = ABCD;
+		E0_SAVE = E0;
+
+		// SHA-1 rounds 0-3
+		MSG0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), MASK);
+		E0 = _mm_add_epi32(E0, MSG0);
+		E1 = ABCD;
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+		MD5STEP(F1, ma, mb, mc, md, in[ 0] + 0xd76aa478,  7);
+		MD5STEP(F1, md, ma, mb, mc, in[ 1] + 0xe8c7b756, 12);
+		MD5STEP(F1, mc, md, ma, mb, in[ 2] + 0x242070db, 17);
+		MD5STEP(F1, mb, mc, md, ma, in[ 3] + 0xc1bdceee, 22);
+
+		// SHA-1 rounds 4-7
+		MSG1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), MASK);
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 0);
+		MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+		MD5STEP(F1, ma, mb, mc, md, in[ 4] + 0xf57c0faf,  7);
+		MD5STEP(F1, md, ma, mb, mc, in[ 5] + 0x4787c62a, 12);
+		MD5STEP(F1, mc, md, ma, mb, in[ 6] + 0xa8304613, 17);
+		MD5STEP(F1, mb, mc, md, ma, in[ 7] + 0xfd469501, 22);
+
+		// SHA-1 rounds 8-11
+		MSG2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), MASK);
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+		MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+		MSG0 = _mm_xor_si128(MSG0, MSG2);
+		MD5STEP(F1, ma, mb, mc, md, in[ 8] + 0x698098d8,  7);
+		MD5STEP(F1, md, ma, mb, mc, in[ 9] + 0x8b44f7af, 12);
+		MD5STEP(F1, mc, md, ma, mb, in[10] + 0xffff5bb1, 17);
+		MD5STEP(F1, mb, mc, md, ma, in[11] + 0x895cd7be, 22);
+
+		// SHA-1 rounds 12-15
+		MSG3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), MASK);
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 0);
+		MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+		MSG1 = _mm_xor_si128(MSG1, MSG3);
+		MD5STEP(F1, ma, mb, mc, md, in[12] + 0x6b901122,  7);
+		MD5STEP(F1, md, ma, mb, mc, in[13] + 0xfd987193, 12);
+		MD5STEP(F1, mc, md, ma, mb, in[14] + 0xa679438e, 17);
+		MD5STEP(F1, mb, mc, md, ma, in[15] + 0x49b40821, 22);
+
+		// SHA-1 rounds 16-19
+		E0 = _mm_sha1nexte_epu32(E0, MSG0);
+		E1 = ABCD;
+		MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+		MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+		MSG2 = _mm_xor_si128(MSG2, MSG0);
+		MD5STEP(F2, ma, mb, mc, md, in[ 1] + 0xf61e2562,  5);
+		MD5STEP(F2, md, ma, mb, mc, in[ 6] + 0xc040b340,  9);
+		MD5STEP(F2, mc, md, ma, mb, in[11] + 0x265e5a51, 14);
+
+		// SHA-1 rounds 20-23
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 1);
+		MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+		MSG3 = _mm_xor_si128(MSG3, MSG1);
+		MD5STEP(F2, mb, mc, md, ma, in[ 0] + 0xe9b6c7aa, 20);
+		MD5STEP(F2, ma, mb, mc, md, in[ 5] + 0xd62f105d,  5);
+		MD5STEP(F2, md, ma, mb, mc, in[10] + 0x02441453,  9);
+
+		// SHA-1 rounds 24-27
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 1);
+		MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+		MSG0 = _mm_xor_si128(MSG0, MSG2);
+		MD5STEP(F2, mc, md, ma, mb, in[15] + 0xd8a1e681, 14);
+		MD5STEP(F2, mb, mc, md, ma, in[ 4] + 0xe7d3fbc8, 20);
+		MD5STEP(F2, ma, mb, mc, md, in[ 9] + 0x21e1cde6,  5);
+
+		// SHA-1 rounds 28-31
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 1);
+		MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+		MSG1 = _mm_xor_si128(MSG1, MSG3);
+		MD5STEP(F2, md, ma, mb, mc, in[14] + 0xc33707d6,  9);
+		MD5STEP(F2, mc, md, ma, mb, in[ 3] + 0xf4d50d87, 14);
+		MD5STEP(F2, mb, mc, md, ma, in[ 8] + 0x455a14ed, 20);
+
+		// SHA-1 rounds 32-35
+		E0 = _mm_sha1nexte_epu32(E0, MSG0);
+		E1 = ABCD;
+		MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 1);
+		MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+		MSG2 = _mm_xor_si128(MSG2, MSG0);
+		MD5STEP(F2, ma, mb, mc, md, in[13] + 0xa9e3e905,  5);
+		MD5STEP(F2, md, ma, mb, mc, in[ 2] + 0xfcefa3f8,  9);
+		MD5STEP(F2, mc, md, ma, mb, in[ 7] + 0x676f02d9, 14);
+
+		// SHA-1 rounds 36-39
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 1);
+		MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+		MSG3 = _mm_xor_si128(MSG3, MSG1);
+		MD5STEP(F2, mb, mc, md, ma, in[12] + 0x8d2a4c8a, 20);
+		MD5STEP(F3, ma, mb, mc, md, in[ 5] + 0xfffa3942,  4);
+		MD5STEP(F3, md, ma, mb, mc, in[ 8] + 0x8771f681, 11);
+
+		// SHA-1 rounds 40-43
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 2);
+		MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+		MSG0 = _mm_xor_si128(MSG0, MSG2);
+		MD5STEP(F3, mc, md, ma, mb, in[11] + 0x6d9d6122, 16);
+		MD5STEP(F3, mb, mc, md, ma, in[14] + 0xfde5380c, 23);
+		MD5STEP(F3, ma, mb, mc, md, in[ 1] + 0xa4beea44,  4);
+
+		// SHA-1 rounds 44-47
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 2);
+		MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+		MSG1 = _mm_xor_si128(MSG1, MSG3);
+		MD5STEP(F3, md, ma, mb, mc, in[ 4] + 0x4bdecfa9, 11);
+		MD5STEP(F3, mc, md, ma, mb, in[ 7] + 0xf6bb4b60, 16);
+		MD5STEP(F3, mb, mc, md, ma, in[10] + 0xbebfbc70, 23);
+
+		// SHA-1 rounds 48-51
+		E0 = _mm_sha1nexte_epu32(E0, MSG0);
+		E1 = ABCD;
+		MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 2);
+		MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+		MSG2 = _mm_xor_si128(MSG2, MSG0);
+		MD5STEP(F3, ma, mb, mc, md, in[13] + 0x289b7ec6,  4);
+		MD5STEP(F3, md, ma, mb, mc, in[ 0] + 0xeaa127fa, 11);
+		MD5STEP(F3, mc, md, ma, mb, in[ 3] + 0xd4ef3085, 16);
+
+		// SHA-1 rounds 52-55
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 2);
+		MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+		MSG3 = _mm_xor_si128(MSG3, MSG1);
+		MD5STEP(F3, mb, mc, md, ma, in[ 6] + 0x04881d05, 23);
+		MD5STEP(F3, ma, mb, mc, md, in[ 9] + 0xd9d4d039,  4);
+		MD5STEP(F3, md, ma, mb, mc, in[12] + 0xe6db99e5, 11);
+
+		// SHA-1 rounds 56-59
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 2);
+		MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+		MSG0 = _mm_xor_si128(MSG0, MSG2);
+		MD5STEP(F3, mc, md, ma, mb, in[15] + 0x1fa27cf8, 16);
+		MD5STEP(F3, mb, mc, md, ma, in[ 2] + 0xc4ac5665, 23);
+		MD5STEP(F4, ma, mb, mc, md, in[ 0] + 0xf4292244,  6);
+
+		// SHA-1 rounds 60-63
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+		MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+		MSG1 = _mm_xor_si128(MSG1, MSG3);
+		MD5STEP(F4, md, ma, mb, mc, in[ 7] + 0x432aff97, 10);
+		MD5STEP(F4, mc, md, ma, mb, in[14] + 0xab9423a7, 15);
+		MD5STEP(F4, mb, mc, md, ma, in[ 5] + 0xfc93a039, 21);
+
+		// SHA-1 rounds 64-67
+		E0 = _mm_sha1nexte_epu32(E0, MSG0);
+		E1 = ABCD;
+		MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+		MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+		MSG2 = _mm_xor_si128(MSG2, MSG0);
+		MD5STEP(F4, ma, mb, mc, md, in[12] + 0x655b59c3,  6);
+		MD5STEP(F4, md, ma, mb, mc, in[ 3] + 0x8f0ccc92, 10);
+		MD5STEP(F4, mc, md, ma, mb, in[10] + 0xffeff47d, 15);
+
+		// SHA-1 rounds 68-71
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+		MSG3 = _mm_xor_si128(MSG3, MSG1);
+		MD5STEP(F4, mb, mc, md, ma, in[ 1] + 0x85845dd1, 21);
+		MD5STEP(F4, ma, mb, mc, md, in[ 8] + 0x6fa87e4f,  6);
+		MD5STEP(F4, md, ma, mb, mc, in[15] + 0xfe2ce6e0, 10);
+
+		// SHA-1 rounds 72-75
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+		MD5STEP(F4, mc, md, ma, mb, in[ 6] + 0xa3014314, 15);
+		MD5STEP(F4, mb, mc, md, ma, in[13] + 0x4e0811a1, 21);
+		MD5STEP(F4, ma, mb, mc, md, in[ 4] + 0xf7537e82,  6);
+
+		// SHA-1 rounds 76-79
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+		MD5STEP(F4, md, ma, mb, mc, in[11] + 0xbd3af235, 10);
+		MD5STEP(F4, mc, md, ma, mb, in[ 2] + 0x2ad7d2bb, 15);
+		MD5STEP(F4, mb, mc, md, ma, in[ 9] + 0xeb86d391, 21);
+		E0 = _mm_sha1nexte_epu32(E0, E0_SAVE);
+		ABCD = _mm_add_epi32(ABCD, ABCD_SAVE);
+		md5[0] += ma; md5[1] += mb; md5[2] += mc; md5[3] += md;
+	}
+
+	_mm_storeu_si128((__m128i *)sha1, _mm_shuffle_epi32(ABCD, 0x1B));
+	sha1[4] = _mm_extract_epi32(E0, 3);
+}
+
+static const WHKERNEL c_akMD5SHA1[] = {
+	{ "shani",      CPUF_SHA, 0, (PVOID)Md5Sha1BlocksNI },
+	{ WHK_PORTABLE, 0,        0, (PVOID)Md5Sha1BlocksC }
+};
+
+WHKERNELSLOT g_ksMD5SHA1 = { "md5sha1", c_akMD5SHA1, ARRAYSIZE(c_akMD5SHA1), NULL };
+
+/**
+ * SHA-256 + CRC-32
+ **/
+
+// As in sha2.c
+#define Ch(x,y,z)       (((x) & (y)) ^ ((~(x)) & (z)))
+#define Maj(x,y,z)      (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define Sigma0_256(x)   (RotRV32((x), 2) ^ RotRV32((x), 13) ^ RotRV32((x), 22))
+#define Sigma1_256(x)   (RotRV32((x), 6) ^ RotRV32((x), 11) ^ RotRV32((x), 25))
+#define sigma0_256(x)   (RotRV32((x), 7) ^ RotRV32((x), 18) ^ ((x) >> 3))
+#define sigma1_256(x)   (RotRV32((x), 17) ^ RotRV32((x), 19) ^ ((x) >> 10))
+
+// From sha2.c
+void SHA256Transform( UINT32 state[8], const BYTE data[SHA256_BLOCK_LENGTH] );
+
+static const __declspec(align(16)) UINT32 K256[64] = {
+	0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL,
+	0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+	0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL,
+	0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+	0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL,
+	0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+	0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL,
+	0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+	0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL,
+	0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+	0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL,
+	0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+	0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL,
+	0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+	0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL,
+	0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+#define ROUND256_0_TO_15(a,b,c,d,e,f,g,h) do {                        \
+	W256[j] = SwapV32(((const UINT32 *)pbIn)[j]);                     \
+	T1 = (h) + Sigma1_256((e)) + Ch((e), (f), (g)) + K256[j] + W256[j]; \
+	(d) += T1;                                                        \
+	(h) = T1 + Sigma0_256((a)) + Maj((a), (b), (c));                  \
+	j++;                                                              \
+} while(0)
+
+#define ROUND256(a,b,c,d,e,f,g,h) do {                                \
+	s0 = sigma0_256(W256[(j+1)&0x0f]);                                \
+	s1 = sigma1_256(W256[(j+14)&0x0f]);                               \
+	T1 = (h) + Sigma1_256((e)) + Ch((e), (f), (g)) + K256[j] +        \
+	     (W256[j&0x0f] += s1 + W256[(j+9)&0x0f] + s0);                \
+	(d) += T1;                                                        \
+	(h) = T1 + Sigma0_256((a)) + Maj((a), (b), (c));                  \
+	j++;                                                              \
+} while(0)
+
+#define ROUNDS256_NI(msg, j) do {                                     \
+	tmp = _mm_add_epi32(msg, _mm_load_si128((const __m128i *)&K256[j])); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, tmp);              \
+	tmp = _mm_shuffle_epi32(tmp, 0x0E);                               \
+	state0 = _mm_sha256rnds2_epu32(state0, state1, tmp);              \
+} while(0)
+
+#define SCHED256_NI(m0, m1, m2, m3)                                   \
+	m0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m0, m1), \
+	    _mm_alignr_epi8(m3, m2, 4)), m3)
+
+// As in crc32.c: each block is folded into four 128-bit accumulators, which
+// are reduced to the 32-bit CRC after the last block.  The first block's fold
+// uses a multiplier of 0, so that it simply loads the accumulators
+#define CRC32_FOLD(x, k, next) \
+	_mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), \
+	    _mm_clmulepi64_si128(x, k, 0x11)), next)
+
+#define CRC32_K2K1 _mm_set_epi64x(0x1c6e41596, 0x154442bd4)
+
+__forceinline UINT32 Crc32Reduce( __m128i x0, __m128i x1, __m128i x2, __m128i x3 )
+{
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, 0, 0);
+	__m128i k, t;
+
+	k = _mm_set_epi64x(0x0ccaa009e, 0x1751997d0);  // k4:k3
+	x0 = CRC32_FOLD(x0, k, x1);
+	x0 = CRC32_FOLD(x0, k, x2);
+	x0 = CRC32_FOLD(x0, k, x3);
+
+	t = _mm_srli_si128(x0, 8);
+	x0 = _mm_xor_si128(_mm_clmulepi64_si128(x0, k, 0x10), t);
+	t = _mm_and_si128(x0, mask32);
+	x0 = _mm_srli_si128(x0, 4);
+	k = _mm_set_epi64x(0, 0x163cd6124);            // k5
+	x0 = _mm_xor_si128(_mm_clmulepi64_si128(t, k, 0x00), x0);
+
+	k = _mm_set_epi64x(0x1f7011641, 0x1db710641);  // mu:P'
+	t = _mm_and_si128(x0, mask32);
+	t = _mm_and_si128(_mm_clmulepi64_si128(t, k, 0x10), mask32);
+	t = _mm_clmulepi64_si128(t, k, 0x00);
+	return((UINT32)_mm_extract_epi32(_mm_xor_si128(t, x0), 1));
+}
+
+// Both take and return the CRC in the same (inverted) form as crc32() does
+typedef UINT32 (WHAPI *PFNSHA256CRC32BLOCKS)( UINT32 sha256[8], UINT32 uCRC32, PCBYTE pbIn, UINT cBlocks );
+
+// One CRC-32 fold for every two of the first eight SHA-256 rounds
+static UINT32 WHAPI Sha256Crc32BlocksCLMUL( UINT32 sha256[8], UINT32 uCRC32, PCBYTE pbIn, UINT cBlocks )
+{
+	UINT32 a, b, c, d, e, f, g, h, s0, s1, T1, W256[16];
+	__m128i x0, x1, x2, x3, k, crc;
+	int j;
+
+	x0 = x1 = x2 = x3 = k = _mm_setzero_si128();
+	crc = _mm_cvtsi32_si128(uCRC32 ^ ~0U);
+
+	for ( ; cBlocks; --cBlocks, pbIn += SHA256_BLOCK_LENGTH)
+	{
+		a = sha256[0]; b = sha256[1]; c = sha256[2]; d = sha256[3];
+		e = sha256[4]; f = sha256[5]; g = sha256[6]; h = sha256[7];
+		j = 0;
+
+		ROUND256_0_TO_15(a,b,c,d,e,f,g,h);
+		ROUND256_0_TO_15(h,a,b,c,d,e,f,g);
+		x0 = CRC32_FOLD(x0, k, _mm_xor_si128(_mm_loadu_si128((const __m128i *)pbIn), crc));
+		ROUND256_0_TO_15(g,h,a,b,c,d,e,f);
+		ROUND256_0_TO_15(f,g,h,a,b,c,d,e);
+		x1 = CRC32_FOLD(x1, k, _mm_loadu_si128((const __m128i *)(pbIn + 16)));
+		ROUND256_0_TO_15(e,f,g,h,a,b,c,d);
+		ROUND256_0_TO_15(d,e,f,g,h,a,b,c);
+		x2 = CRC32_FOLD(x2, k, _mm_loadu_si128((const __m128i *)(pbIn + 32)));
+		ROUND256_0_TO_15(c,d,e,f,g,h,a,b);
+		ROUND256_0_TO_15(b,c,d,e,f,g,h,a);
+		x3 = CRC32_FOLD(x3, k, _mm_loadu_si128((const __m128i *)(pbIn + 48)));
+		crc = _mm_setzero_si128();
+		k = CRC32_K2K1;
+		ROUND256_0_TO_15(a,b,c,d,e,f,g,h);
+		ROUND256_0_TO_15(h,a,b,c,d,e,f,g);
+		ROUND256_0_TO_15(g,h,a,b,c,d,e,f);
+		ROUND256_0_TO_15(f,g,h,a,b,c,d,e);
+		ROUND256_0_TO_15(e,f,g,h,a,b,c,d);
+		ROUND256_0_TO_15(d,e,f,g,h,a,b,c);
+		ROUND256_0_TO_15(c,d,e,f,g,h,a,b);
+		ROUND256_0_TO_15(b,c,d,e,f,g,h,a);
+
+		do {
+			ROUND256(a,b,c,d,e,f,g,h);
+			ROUND256(h,a,b,c,d,e,f,g);
+			ROUND256(g,h,a,b,c,d,e,f);
+			ROUND256(f,g,h,a,b,c,d,e);
+			ROUND256(e,f,g,h,a,b,c,d);
+			ROUND256(d,e,f,g,h,a,b,c);
+			ROUND256(c,d,e,f,g,h,a,b);
+			ROUND256(b,c,d,e,f,g,h,a);
+		} while (j < 64);
+
+		sha256[0] += a; sha256[1] += b; sha256[2] += c; sha256[3] += d;
+		sha256[4] += e; sha256[5] += f; sha256[6] += g; sha256[7] += h;
+	}
+
+	return(Crc32Reduce(x0, x1, x2, x3) ^ ~0U);
+}
+
+// SHA-256's rounds run in the SHA-NI unit while CRC-32's multiplies run in
+// the carry-less multiplier; one fold for every four rounds of the first
+// sixteen
+static UINT32 WHAPI Sha256Crc32BlocksNI( UINT32 sha256[8], UINT32 uCRC32, PCBYTE pbIn, UINT cBlocks )
+{
+	__m128i state0, state1, save0, save1, tmp;
+	__m128i msg0, msg1, msg2, msg3;
+	__m128i x0, x1, x2, x3, k, crc;
+	int j;
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&sha256[0]), 0xB1);  // CDAB
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&sha256[4]), 0x1B);  // EFGH
+	state0 = _mm_alignr_epi8(tmp, state1, 8);    // ABEF
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);  // CDGH
+
+	x0 = x1 = x2 = x3 = k = _mm_setzero_si128();
+	crc = _mm_cvtsi32_si128(uCRC32 ^ ~0U);
+
+	for ( ; cBlocks; --cBlocks, pbIn += SHA256_BLOCK_LENGTH)
+	{
+		save0 = state0;
+		save1 = state1;
+
+		msg0 = _mm_loadu_si128((const __m128i *)(pbIn +  0));
+		msg1 = _mm_loadu_si128((const __m128i *)(pbIn + 16));
+		msg2 = _mm_loadu_si128((const __m128i *)(pbIn + 32));
+		msg3 = _mm_loadu_si128((const __m128i *)(pbIn + 48));
+
+		x0 = CRC32_FOLD(x0, k, _mm_xor_si128(msg0, crc));
+		msg0 = _mm_shuffle_epi8(msg0, mask);
+		ROUNDS256_NI(msg0,  0);
+		x1 = CRC32_FOLD(x1, k, msg1);
+		msg1 = _mm_shuffle_epi8(msg1, mask);
+		ROUNDS256_NI(msg1,  4);
+		x2 = CRC32_FOLD(x2, k, msg2);
+		msg2 = _mm_shuffle_epi8(msg2, mask);
+		ROUNDS256_NI(msg2,  8);
+		x3 = CRC32_FOLD(x3, k, msg3);
+		msg3 = _mm_shuffle_epi8(msg3, mask);
+		ROUNDS256_NI(msg3, 12);
+		crc = _mm_setzero_si128();
+		k = CRC32_K2K1;
+
+		for (j = 16; j < 64; j += 16)
+		{
+			SCHED256_NI(msg0, msg1, msg2, msg3);
+			ROUNDS256_NI(msg0, j);
+			SCHED256_NI(msg1, msg2, msg3, msg0);
+			ROUNDS256_NI(msg1, j + 4);
+			SCHED256_NI(msg2, msg3, msg0, msg1);
+			ROUNDS256_NI(msg2, j + 8);
+			SCHED256_NI(msg3, msg0, msg1, msg2);
+			ROUNDS256_NI(msg3, j + 12);
+		}
+
+		state0 = _mm_add_epi32(state0, save0);
+		state1 = _mm_add_epi32(state1, save1);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1B);     // FEBA
+	state1 = _mm_shuffle_epi32(state1, 0xB1);  // DCHG
+	_mm_storeu_si128((__m128i *)&sha256[0], _mm_blend_epi16(tmp, state1, 0xF0));  // DCBA
+	_mm_storeu_si128((__m128i *)&sha256[4], _mm_alignr_epi8(state1, tmp, 8));     // HGFE
+
+	return(Crc32Reduce(x0, x1, x2, x3) ^ ~0U);
+}
+
+// Without a carry-less multiplier, CRC-32 is table-driven and would compete
+// with SHA-256 for the same units, so the two are simply run one after the other
+static UINT32 WHAPI Sha256Crc32BlocksC( UINT32 sha256[8], UINT32 uCRC32, PCBYTE pbIn, UINT cBlocks )
+{
+	UINT i;
+
+	for (i = 0; i < cBlocks; ++i)
+		SHA256Transform(sha256, pbIn + i * SHA256_BLOCK_LENGTH);
+
+	return(crc32(uCRC32, pbIn, cBlocks * SHA256_BLOCK_LENGTH));
+}
+
+static const WHKERNEL c_akSHA256CRC32[] = {
+	{ "shani",      CPUF_SHA | CPUF_PCLMUL | CPUF_SSE41, 0, (PVOID)Sha256Crc32BlocksNI },
+	{ "clmul",      CPUF_PCLMUL | CPUF_SSE41,            0, (PVOID)Sha256Crc32BlocksCLMUL },
+	{ WHK_PORTABLE, 0,                                   0, (PVOID)Sha256Crc32BlocksC }
+};
+
+WHKERNELSLOT g_ksSHA256CRC32 = { "sha256crc32", c_akSHA256CRC32, ARRAYSIZE(c_akSHA256CRC32), NULL };
+
+/**
+ * Public functions
+ **/
+
+void MD5SHA1Update( PMD5_CTX pMD5, PSHA1_CTX pSHA1, PCBYTE pbIn, UINT cbIn )
+{
+	UINT cbHave = (UINT)(pMD5->count >> 3) & (MD5_BLOCK_LENGTH - 1);
+	UINT cbTake, cBlocks;
+
+	// Partial blocks are left to the separate updates, which buffer them
+	if (cbHave)
+	{
+		cbTake = min(cbIn, MD5_BLOCK_LENGTH - cbHave);
+		MD5Update(pMD5, pbIn, cbTake);
+		SHA1Update(pSHA1, pbIn, cbTake);
+		pbIn += cbTake;
+		cbIn -= cbTake;
+	}
+
+	cBlocks = cbIn / MD5_BLOCK_LENGTH;
+	if (cBlocks)
+	{
+		((PFNMD5SHA1BLOCKS)WHBindKernel(&g_ksMD5SHA1))(pMD5->state, pSHA1->state, pbIn, cBlocks);
+		pMD5->count += (UINT64)cBlocks * MD5_BLOCK_LENGTH * 8;
+		pSHA1->count += (UINT64)cBlocks * SHA1_BLOCK_LENGTH * 8;
+		pbIn += cBlocks * MD5_BLOCK_LENGTH;
+		cbIn -= cBlocks * MD5_BLOCK_LENGTH;
+	}
+
+	if (cbIn)
+	{
+		MD5Update(pMD5, pbIn, cbIn);
+		SHA1Update(pSHA1, pbIn, cbIn);
+	}
+}
+
+void SHA256CRC32Update( PSHA2_CTX pSHA256, PUINT32 puCRC32, PCBYTE pbIn, UINT cbIn )
+{
+	UINT cbHave = (UINT)(pSHA256->bitcount[0] >> 3) & (SHA256_BLOCK_LENGTH - 1);
+	UINT cbTake, cBlocks;
+
+	if (cbHave)
+	{
+		cbTake = min(cbIn, SHA256_BLOCK_LENGTH - cbHave);
+		SHA256Update(pSHA256, pbIn, cbTake);
+		*puCRC32 = crc32(*puCRC32, pbIn, cbTake);
+		pbIn += cbTake;
+		cbIn -= cbTake;
+	}
+
+	cBlocks = cbIn / SHA256_BLOCK_LENGTH;
+	if (cBlocks)
+	{
+		*puCRC32 = ((PFNSHA256CRC32BLOCKS)WHBindKernel(&g_ksSHA256CRC32))(pSHA256->state.st32, *puCRC32, pbIn, cBlocks);
+		pSHA256->bitcount[0] += (UINT64)cBlocks * SHA256_BLOCK_LENGTH * 8;
+		pbIn += cBlocks * SHA256_BLOCK_LENGTH;
+		cbIn -= cBlocks * SHA256_BLOCK_LENGTH;
+	}
+
+	if (cbIn)
+	{
+		SHA256Update(pSHA256, pbIn, cbIn);
+		*puCRC32 = crc32(*puCRC32, pbIn, cbIn);
+	}
+}
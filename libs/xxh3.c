@@ -0,0 +1,543 @@
+/**
+ * XXH3-128
+ * Last modified: 2026/10/18
+ *
+ * An implementation of the 128-bit variant of XXH3 (https://xxhash.com/)
+ * with the default secret and seed, producing the same digests as xxhsum -H2
+ * (and xxh128sum).  XXH3 is not a cryptographic hash; it is meant for fast
+ * integrity checks, where it is both far faster and far less likely to miss
+ * a corruption than CRC-32.
+ *
+ * Inputs of up to 240 bytes are hashed directly by the short-input paths.
+ * Longer inputs are consumed in 64-byte stripes by eight 64-bit accumulators,
+ * which the SSE2 and AVX2 kernels below update two or four at a time.
+ **/
+
+#include "WinHash.h"
+#include "WinHashDispatch.h"
+#include <immintrin.h>
+#include <intrin.h>
+
+#define XXH_STRIPE_LENGTH           64
+#define XXH_SECRET_LENGTH           192
+#define XXH_SECRET_CONSUME_RATE     8
+#define XXH_STRIPES_PER_BLOCK       ((XXH_SECRET_LENGTH - XXH_STRIPE_LENGTH) / XXH_SECRET_CONSUME_RATE)
+#define XXH_BLOCK_LENGTH            (XXH_STRIPE_LENGTH * XXH_STRIPES_PER_BLOCK)
+#define XXH_BUFFER_STRIPES          (XXH3_BUFFER_LENGTH / XXH_STRIPE_LENGTH)
+#define XXH_MIDSIZE_MAX             240
+
+// Offsets into the secret
+#define XXH_SECRET_SCRAMBLE         (XXH_SECRET_LENGTH - XXH_STRIPE_LENGTH)
+#define XXH_SECRET_LASTACC          (XXH_SECRET_SCRAMBLE - 7)
+#define XXH_SECRET_MERGEACCS        11
+#define XXH_MIDSIZE_STARTOFFSET     3
+#define XXH_MIDSIZE_LASTOFFSET      17
+#define XXH_SECRET_SIZE_MIN         136
+
+#define PRIME32_1   0x9E3779B1U
+#define PRIME32_2   0x85EBCA77U
+#define PRIME32_3   0xC2B2AE3DU
+#define PRIME64_1   0x9E3779B185EBCA87ULL
+#define PRIME64_2   0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3   0x165667B19E3779F9ULL
+#define PRIME64_4   0x85EBCA77C2B2AE63ULL
+#define PRIME64_5   0x27D4EB2F165667C5ULL
+#define PRIME_MX1   0x165667919E3779F9ULL
+#define PRIME_MX2   0x9FB21C651E98DF25ULL
+
+static const __declspec(align(64)) BYTE XXH_SECRET[XXH_SECRET_LENGTH] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+typedef struct {
+	UINT64 lo;
+	UINT64 hi;
+} XXH128, *PXXH128;
+
+// x86 is little-endian, as are all of XXH3's reads
+__forceinline UINT32 XxhRead32( PCBYTE pb )
+{
+	UINT32 x;
+	memcpy(&x, pb, sizeof(x));
+	return(x);
+}
+
+__forceinline UINT64 XxhRead64( PCBYTE pb )
+{
+	UINT64 x;
+	memcpy(&x, pb, sizeof(x));
+	return(x);
+}
+
+__forceinline XXH128 XxhMul128( UINT64 a, UINT64 b )
+{
+	XXH128 r;
+
+#ifdef _WIN64
+	r.lo = _umul128(a, b, &r.hi);
+#else
+	UINT64 lolo = __emulu((UINT32)a, (UINT32)b);
+	UINT64 hilo = __emulu((UINT32)(a >> 32), (UINT32)b);
+	UINT64 lohi = __emulu((UINT32)a, (UINT32)(b >> 32));
+	UINT64 hihi = __emulu((UINT32)(a >> 32), (UINT32)(b >> 32));
+	UINT64 cross = (lolo >> 32) + (UINT32)hilo + lohi;
+
+	r.hi = (hilo >> 32) + (cross >> 32) + hihi;
+	r.lo = (cross << 32) | (UINT32)lolo;
+#endif
+
+	return(r);
+}
+
+__forceinline UINT64 XxhMulFold64( UINT64 a, UINT64 b )
+{
+	XXH128 r = XxhMul128(a, b);
+	return(r.lo ^ r.hi);
+}
+
+__forceinline UINT64 XxhAvalanche( UINT64 h )
+{
+	h ^= h >> 37;
+	h *= PRIME_MX1;
+	h ^= h >> 32;
+	return(h);
+}
+
+__forceinline UINT64 Xxh64Avalanche( UINT64 h )
+{
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	return(h);
+}
+
+/**
+ * Inputs of up to 240 bytes
+ **/
+
+static XXH128 Xxh128Len0( )
+{
+	XXH128 h;
+
+	h.lo = Xxh64Avalanche(XxhRead64(XXH_SECRET + 64) ^ XxhRead64(XXH_SECRET + 72));
+	h.hi = Xxh64Avalanche(XxhRead64(XXH_SECRET + 80) ^ XxhRead64(XXH_SECRET + 88));
+	return(h);
+}
+
+static XXH128 Xxh128Len1To3( PCBYTE pbIn, SIZE_T cbIn )
+{
+	UINT32 combinedLo = ((UINT32)pbIn[0] << 16) | ((UINT32)pbIn[cbIn >> 1] << 24) |
+	                    ((UINT32)pbIn[cbIn - 1]) | ((UINT32)cbIn << 8);
+	UINT32 combinedHi = RotLV32(SwapV32(combinedLo), 13);
+	XXH128 h;
+
+	h.lo = Xxh64Avalanche(combinedLo ^ (UINT64)(XxhRead32(XXH_SECRET) ^ XxhRead32(XXH_SECRET + 4)));
+	h.hi = Xxh64Avalanche(combinedHi ^ (UINT64)(XxhRead32(XXH_SECRET + 8) ^ XxhRead32(XXH_SECRET + 12)));
+	return(h);
+}
+
+static XXH128 Xxh128Len4To8( PCBYTE pbIn, SIZE_T cbIn )
+{
+	UINT64 in = XxhRead32(pbIn) + ((UINT64)XxhRead32(pbIn + cbIn - 4) << 32);
+	UINT64 keyed = in ^ (XxhRead64(XXH_SECRET + 16) ^ XxhRead64(XXH_SECRET + 24));
+	XXH128 m = XxhMul128(keyed, PRIME64_1 + (cbIn << 2));
+
+	m.hi += m.lo << 1;
+	m.lo ^= m.hi >> 3;
+	m.lo ^= m.lo >> 35;
+	m.lo *= PRIME_MX2;
+	m.lo ^= m.lo >> 28;
+	m.hi = XxhAvalanche(m.hi);
+	return(m);
+}
+
+static XXH128 Xxh128Len9To16( PCBYTE pbIn, SIZE_T cbIn )
+{
+	UINT64 bitflipLo = XxhRead64(XXH_SECRET + 32) ^ XxhRead64(XXH_SECRET + 40);
+	UINT64 bitflipHi = XxhRead64(XXH_SECRET + 48) ^ XxhRead64(XXH_SECRET + 56);
+	UINT64 inLo = XxhRead64(pbIn);
+	UINT64 inHi = XxhRead64(pbIn + cbIn - 8) ^ bitflipHi;
+	XXH128 m = XxhMul128(inLo ^ XxhRead64(pbIn + cbIn - 8) ^ bitflipLo, PRIME64_1);
+	XXH128 h;
+
+	m.lo += (UINT64)(cbIn - 1) << 54;
+	m.hi += inHi + __emulu((UINT32)inHi, PRIME32_2 - 1);
+	m.lo ^= SwapV64(m.hi);
+
+	h = XxhMul128(m.lo, PRIME64_2);
+	h.hi += m.hi * PRIME64_2;
+	h.lo = XxhAvalanche(h.lo);
+	h.hi = XxhAvalanche(h.hi);
+	return(h);
+}
+
+__forceinline UINT64 XxhMix16( PCBYTE pbIn, PCBYTE pbSecret )
+{
+	return(XxhMulFold64(XxhRead64(pbIn) ^ XxhRead64(pbSecret), XxhRead64(pbIn + 8) ^ XxhRead64(pbSecret + 8)));
+}
+
+__forceinline VOID XxhMix32( PXXH128 pAcc, PCBYTE pbIn1, PCBYTE pbIn2, PCBYTE pbSecret )
+{
+	pAcc->lo += XxhMix16(pbIn1, pbSecret);
+	pAcc->lo ^= XxhRead64(pbIn2) + XxhRead64(pbIn2 + 8);
+	pAcc->hi += XxhMix16(pbIn2, pbSecret + 16);
+	pAcc->hi ^= XxhRead64(pbIn1) + XxhRead64(pbIn1 + 8);
+}
+
+__forceinline XXH128 XxhMidFinish( XXH128 acc, SIZE_T cbIn )
+{
+	XXH128 h;
+
+	h.lo = XxhAvalanche(acc.lo + acc.hi);
+	h.hi = 0 - XxhAvalanche(acc.lo * PRIME64_1 + acc.hi * PRIME64_4 + cbIn * PRIME64_2);
+	return(h);
+}
+
+static XXH128 Xxh128Len17To128( PCBYTE pbIn, SIZE_T cbIn )
+{
+	XXH128 acc;
+
+	acc.lo = cbIn * PRIME64_1;
+	acc.hi = 0;
+
+	if (cbIn > 32)
+	{
+		if (cbIn > 64)
+		{
+			if (cbIn > 96)
+				XxhMix32(&acc, pbIn + 48, pbIn + cbIn - 64, XXH_SECRET + 96);
+			XxhMix32(&acc, pbIn + 32, pbIn + cbIn - 48, XXH_SECRET + 64);
+		}
+		XxhMix32(&acc, pbIn + 16, pbIn + cbIn - 32, XXH_SECRET + 32);
+	}
+	XxhMix32(&acc, pbIn, pbIn + cbIn - 16, XXH_SECRET);
+
+	return(XxhMidFinish(acc, cbIn));
+}
+
+static XXH128 Xxh128Len129To240( PCBYTE pbIn, SIZE_T cbIn )
+{
+	XXH128 acc;
+	SIZE_T i;
+
+	acc.lo = cbIn * PRIME64_1;
+	acc.hi = 0;
+
+	for (i = 0; i < 4; ++i)
+		XxhMix32(&acc, pbIn + 32 * i, pbIn + 32 * i + 16, XXH_SECRET + 32 * i);
+
+	acc.lo = XxhAvalanche(acc.lo);
+	acc.hi = XxhAvalanche(acc.hi);
+
+	for ( ; i < cbIn / 32; ++i)
+		XxhMix32(&acc, pbIn + 32 * i, pbIn + 32 * i + 16, XXH_SECRET + XXH_MIDSIZE_STARTOFFSET + 32 * (i - 4));
+
+	// The last 32 bytes are mixed against a secret offset which is relative
+	// to the smallest allowed secret, not to the actual one
+	XxhMix32(&acc, pbIn + cbIn - 16, pbIn + cbIn - 32,
+	         XXH_SECRET + XXH_SECRET_SIZE_MIN - XXH_MIDSIZE_LASTOFFSET - 16);
+
+	return(XxhMidFinish(acc, cbIn));
+}
+
+static XXH128 Xxh128Short( PCBYTE pbIn, SIZE_T cbIn )
+{
+	if (cbIn > 128) return(Xxh128Len129To240(pbIn, cbIn));
+	if (cbIn > 16)  return(Xxh128Len17To128(pbIn, cbIn));
+	if (cbIn > 8)   return(Xxh128Len9To16(pbIn, cbIn));
+	if (cbIn > 3)   return(Xxh128Len4To8(pbIn, cbIn));
+	if (cbIn > 0)   return(Xxh128Len1To3(pbIn, cbIn));
+	return(Xxh128Len0());
+}
+
+/**
+ * Stripe accumulation kernels for longer inputs: each stripe is combined with
+ * the secret starting 8 bytes further along than for the previous stripe, and
+ * the accumulators are scrambled after every block of 16 stripes
+ **/
+
+typedef VOID (WHAPI *PFNXXH3ACCUMULATE)( UINT64 acc[8], PCBYTE pbIn, PCBYTE pbSecret, SIZE_T cStripes );
+typedef VOID (WHAPI *PFNXXH3SCRAMBLE)( UINT64 acc[8], PCBYTE pbSecret );
+
+typedef struct {
+	PFNXXH3ACCUMULATE pfnAccumulate;
+	PFNXXH3SCRAMBLE   pfnScramble;
+} XXH3_BACKEND, *PXXH3_BACKEND;
+
+typedef const XXH3_BACKEND *PCXXH3_BACKEND;
+
+static VOID WHAPI XxhAccumulateC( UINT64 acc[8], PCBYTE pbIn, PCBYTE pbSecret, SIZE_T cStripes )
+{
+	UINT64 data, key;
+	UINT i;
+
+	for ( ; cStripes; --cStripes, pbIn += XXH_STRIPE_LENGTH, pbSecret += XXH_SECRET_CONSUME_RATE)
+	{
+		for (i = 0; i < 8; ++i)
+		{
+			data = XxhRead64(pbIn + 8 * i);
+			key = data ^ XxhRead64(pbSecret + 8 * i);
+			acc[i ^ 1] += data;
+			acc[i] += __emulu((UINT32)key, (UINT32)(key >> 32));
+		}
+	}
+}
+
+static VOID WHAPI XxhScrambleC( UINT64 acc[8], PCBYTE pbSecret )
+{
+	UINT64 a;
+	UINT i;
+
+	for (i = 0; i < 8; ++i)
+	{
+		a = acc[i];
+		a ^= a >> 47;
+		a ^= XxhRead64(pbSecret + 8 * i);
+		acc[i] = a * PRIME32_1;
+	}
+}
+
+// The 32x32-bit products of each key's halves are formed by PMULUDQ, after
+// swapping the halves of a copy of the keys into the low dwords
+static VOID WHAPI XxhAccumulateSSE2( UINT64 acc[8], PCBYTE pbIn, PCBYTE pbSecret, SIZE_T cStripes )
+{
+	__m128i a[4], data, key;
+	UINT i;
+
+	for (i = 0; i < 4; ++i)
+		a[i] = _mm_loadu_si128((const __m128i *)acc + i);
+
+	for ( ; cStripes; --cStripes, pbIn += XXH_STRIPE_LENGTH, pbSecret += XXH_SECRET_CONSUME_RATE)
+	{
+		for (i = 0; i < 4; ++i)
+		{
+			data = _mm_loadu_si128((const __m128i *)pbIn + i);
+			key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i *)pbSecret + i));
+			a[i] = _mm_add_epi64(a[i], _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+			a[i] = _mm_add_epi64(a[i], _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1))));
+		}
+	}
+
+	for (i = 0; i < 4; ++i)
+		_mm_storeu_si128((__m128i *)acc + i, a[i]);
+}
+
+static VOID WHAPI XxhScrambleSSE2( UINT64 acc[8], PCBYTE pbSecret )
+{
+	const __m128i prime = _mm_set1_epi32((INT32)PRIME32_1);
+	__m128i a, lo, hi;
+	UINT i;
+
+	for (i = 0; i < 4; ++i)
+	{
+		a = _mm_loadu_si128((const __m128i *)acc + i);
+		a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+		a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i *)pbSecret + i));
+		lo = _mm_mul_epu32(a, prime);
+		hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		_mm_storeu_si128((__m128i *)acc + i, _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+	}
+}
+
+static VOID WHAPI XxhAccumulateAVX2( UINT64 acc[8], PCBYTE pbIn, PCBYTE pbSecret, SIZE_T cStripes )
+{
+	__m256i a[2], data, key;
+	UINT i;
+
+	for (i = 0; i < 2; ++i)
+		a[i] = _mm256_loadu_si256((const __m256i *)acc + i);
+
+	for ( ; cStripes; --cStripes, pbIn += XXH_STRIPE_LENGTH, pbSecret += XXH_SECRET_CONSUME_RATE)
+	{
+		for (i = 0; i < 2; ++i)
+		{
+			data = _mm256_loadu_si256((const __m256i *)pbIn + i);
+			key = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i *)pbSecret + i));
+			a[i] = _mm256_add_epi64(a[i], _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+			a[i] = _mm256_add_epi64(a[i], _mm256_mul_epu32(key, _mm256_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1))));
+		}
+	}
+
+	for (i = 0; i < 2; ++i)
+		_mm256_storeu_si256((__m256i *)acc + i, a[i]);
+}
+
+static VOID WHAPI XxhScrambleAVX2( UINT64 acc[8], PCBYTE pbSecret )
+{
+	const __m256i prime = _mm256_set1_epi32((INT32)PRIME32_1);
+	__m256i a, lo, hi;
+	UINT i;
+
+	for (i = 0; i < 2; ++i)
+	{
+		a = _mm256_loadu_si256((const __m256i *)acc + i);
+		a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+		a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i *)pbSecret + i));
+		lo = _mm256_mul_epu32(a, prime);
+		hi = _mm256_mul_epu32(_mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		_mm256_storeu_si256((__m256i *)acc + i, _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+	}
+}
+
+static const XXH3_BACKEND c_xxhAVX2 = { XxhAccumulateAVX2, XxhScrambleAVX2 };
+static const XXH3_BACKEND c_xxhSSE2 = { XxhAccumulateSSE2, XxhScrambleSSE2 };
+static const XXH3_BACKEND c_xxhC    = { XxhAccumulateC,    XxhScrambleC };
+
+static const WHKERNEL c_akXXH3[] = {
+	{ "avx2",       CPUF_AVX2, 0, (PVOID)&c_xxhAVX2 },
+	{ "sse2",       CPUF_SSE2, 0, (PVOID)&c_xxhSSE2 },
+	{ WHK_PORTABLE, 0,         0, (PVOID)&c_xxhC }
+};
+
+WHKERNELSLOT g_ksXXH3 = { "xxh3", c_akXXH3, ARRAYSIZE(c_akXXH3), NULL };
+
+// Accumulates cStripes whole stripes, scrambling at each block boundary
+static VOID XxhConsumeStripes( PXXH3_128_CTX pContext, PCBYTE pbIn, SIZE_T cStripes )
+{
+	PCXXH3_BACKEND pBackend = (PCXXH3_BACKEND)WHBindKernel(&g_ksXXH3);
+	SIZE_T cTake;
+
+	while (cStripes)
+	{
+		cTake = XXH_STRIPES_PER_BLOCK - pContext->cStripes;
+		if (cTake > cStripes)
+			cTake = cStripes;
+
+		pBackend->pfnAccumulate(pContext->acc, pbIn, XXH_SECRET + pContext->cStripes * XXH_SECRET_CONSUME_RATE, cTake);
+		pContext->cStripes += (UINT)cTake;
+		pbIn += cTake * XXH_STRIPE_LENGTH;
+		cStripes -= cTake;
+
+		if (pContext->cStripes == XXH_STRIPES_PER_BLOCK)
+		{
+			pBackend->pfnScramble(pContext->acc, XXH_SECRET + XXH_SECRET_SCRAMBLE);
+			pContext->cStripes = 0;
+		}
+	}
+}
+
+__forceinline UINT64 XxhMergeAccs( const UINT64 acc[8], PCBYTE pbSecret, UINT64 start )
+{
+	UINT i;
+
+	for (i = 0; i < 4; ++i)
+		start += XxhMulFold64(acc[2 * i] ^ XxhRead64(pbSecret + 16 * i), acc[2 * i + 1] ^ XxhRead64(pbSecret + 16 * i + 8));
+
+	return(XxhAvalanche(start));
+}
+
+/**
+ * Public functions
+ **/
+
+void XXH3_128Init( PXXH3_128_CTX pContext )
+{
+	pContext->acc[0] = PRIME32_3;
+	pContext->acc[1] = PRIME64_1;
+	pContext->acc[2] = PRIME64_2;
+	pContext->acc[3] = PRIME64_3;
+	pContext->acc[4] = PRIME64_4;
+	pContext->acc[5] = PRIME32_2;
+	pContext->acc[6] = PRIME64_5;
+	pContext->acc[7] = PRIME32_1;
+	pContext->cbBuffer = 0;
+	pContext->cStripes = 0;
+	pContext->cbTotal = 0;
+}
+
+void XXH3_128Update( PXXH3_128_CTX pContext, PCBYTE pbIn, UINT cbIn )
+{
+	UINT cbTake;
+
+	pContext->cbTotal += cbIn;
+
+	// At least one byte is always kept back in the buffer, since the last
+	// stripe is treated differently, and short inputs are hashed as a whole
+	if (cbIn <= XXH3_BUFFER_LENGTH - pContext->cbBuffer)
+	{
+		memcpy(pContext->buffer + pContext->cbBuffer, pbIn, cbIn);
+		pContext->cbBuffer += cbIn;
+		return;
+	}
+
+	if (pContext->cbBuffer)
+	{
+		cbTake = XXH3_BUFFER_LENGTH - pContext->cbBuffer;
+		memcpy(pContext->buffer + pContext->cbBuffer, pbIn, cbTake);
+		pbIn += cbTake;
+		cbIn -= cbTake;
+
+		XxhConsumeStripes(pContext, pContext->buffer, XXH_BUFFER_STRIPES);
+		pContext->cbBuffer = 0;
+	}
+
+	if (cbIn > XXH3_BUFFER_LENGTH)
+	{
+		cbTake = (cbIn - 1) / XXH3_BUFFER_LENGTH * XXH3_BUFFER_LENGTH;
+		XxhConsumeStripes(pContext, pbIn, cbTake / XXH_STRIPE_LENGTH);
+		pbIn += cbTake;
+		cbIn -= cbTake;
+
+		// Keep the last stripe consumed, in case the final stripe overlaps it
+		memcpy(pContext->buffer + XXH3_BUFFER_LENGTH - XXH_STRIPE_LENGTH, pbIn - XXH_STRIPE_LENGTH, XXH_STRIPE_LENGTH);
+	}
+
+	memcpy(pContext->buffer, pbIn, cbIn);
+	pContext->cbBuffer = cbIn;
+}
+
+void XXH3_128Final( PXXH3_128_CTX pContext )
+{
+	XXH128 h;
+	BYTE lastStripe[XXH_STRIPE_LENGTH];
+	PCBYTE pbLastStripe;
+	UINT cbCatchup;
+
+	if (pContext->cbTotal <= XXH_MIDSIZE_MAX)
+	{
+		h = Xxh128Short(pContext->buffer, (SIZE_T)pContext->cbTotal);
+	}
+	else
+	{
+		// The final stripe is the last 64 bytes of the input, which may
+		// overlap stripes that have already been consumed
+		if (pContext->cbBuffer >= XXH_STRIPE_LENGTH)
+		{
+			XxhConsumeStripes(pContext, pContext->buffer, (pContext->cbBuffer - 1) / XXH_STRIPE_LENGTH);
+			pbLastStripe = pContext->buffer + pContext->cbBuffer - XXH_STRIPE_LENGTH;
+		}
+		else
+		{
+			cbCatchup = XXH_STRIPE_LENGTH - pContext->cbBuffer;
+			memcpy(lastStripe, pContext->buffer + XXH3_BUFFER_LENGTH - cbCatchup, cbCatchup);
+			memcpy(lastStripe + cbCatchup, pContext->buffer, pContext->cbBuffer);
+			pbLastStripe = lastStripe;
+		}
+
+		((PCXXH3_BACKEND)WHBindKernel(&g_ksXXH3))->pfnAccumulate(pContext->acc, pbLastStripe,
+		                                                          XXH_SECRET + XXH_SECRET_LASTACC, 1);
+
+		h.lo = XxhMergeAccs(pContext->acc, XXH_SECRET + XXH_SECRET_MERGEACCS, pContext->cbTotal * PRIME64_1);
+		h.hi = XxhMergeAccs(pContext->acc, XXH_SECRET + XXH_SECRET_LENGTH - sizeof(pContext->acc) - XXH_SECRET_MERGEACCS,
+		                    ~(pContext->cbTotal * PRIME64_2));
+	}
+
+	// The canonical form is big-endian, high half first
+	h.hi = SwapV64(h.hi);
+	h.lo = SwapV64(h.lo);
+	memcpy(pContext->result, &h.hi, sizeof(h.hi));
+	memcpy(pContext->result + sizeof(h.hi), &h.lo, sizeof(h.lo));
+}